@@ -0,0 +1,155 @@
+#include "PCH.h"
+#include "BatchingBenchmark.h"
+#include "Rendering\SpriteBatcher.h"
+#include "Timing.h"
+#include <random>
+
+namespace
+{
+	constexpr int FRAME_COUNT = 20;						// Frames drawn per scene.
+	constexpr int TARGET_WIDTH = 800;					// The size of the game window.
+	constexpr int TARGET_HEIGHT = 600;
+	constexpr int TEXTURE_COUNT = 4;					// Sprite sheets the sprites are spread over.
+	constexpr int TEXTURE_SIZE = 64;
+	constexpr int SPRITE_SIZE = 16;						// Size of a sprite, both on its sheet and on the screen.
+	constexpr float HEALTH_BAR_HEIGHT = 2.0f;
+
+	// A sprite to draw, with a health bar over it.
+	struct BenchmarkSprite final
+	{
+		int textureIndex = 0;		// 4 bytes.
+		SDL_Rect sourceRect;		// 16 bytes.
+		SDL_FRect destinationRect;	// 16 bytes.
+		float rotation = 0.0f;		// 4 bytes.
+	};								// Total = 40 bytes.
+
+	// Draw the sprites, sorted by texture, both ways, and time them.
+	void RunScene(SDL_Renderer* a_renderer, const std::vector<SDL_Texture*>& a_textures, size_t a_spriteCount)
+	{
+		std::mt19937 generator(1234);
+		std::uniform_int_distribution<int> textureDistribution(0, TEXTURE_COUNT - 1);
+		std::uniform_int_distribution<int> cellDistribution(0, TEXTURE_SIZE / SPRITE_SIZE - 1);
+		std::uniform_real_distribution<float> xDistribution(0.0f, static_cast<float>(TARGET_WIDTH - SPRITE_SIZE));
+		std::uniform_real_distribution<float> yDistribution(0.0f, static_cast<float>(TARGET_HEIGHT - SPRITE_SIZE));
+		std::uniform_real_distribution<float> rotationDistribution(0.0f, 360.0f);
+
+		std::vector<BenchmarkSprite> sprites(a_spriteCount);
+		for (BenchmarkSprite& sprite : sprites)
+		{
+			sprite.textureIndex = textureDistribution(generator);
+			sprite.sourceRect = { cellDistribution(generator) * SPRITE_SIZE, cellDistribution(generator) * SPRITE_SIZE, SPRITE_SIZE, SPRITE_SIZE };
+			sprite.destinationRect = { roundf(xDistribution(generator)), roundf(yDistribution(generator)), static_cast<float>(SPRITE_SIZE), static_cast<float>(SPRITE_SIZE) };
+			sprite.rotation = rotationDistribution(generator);
+		}
+
+		// Sort by texture, the way the render system does within a render order.
+		std::sort(sprites.begin(), sprites.end(), [](const BenchmarkSprite& a_sprite1, const BenchmarkSprite& a_sprite2) { return a_sprite1.textureIndex < a_sprite2.textureIndex; });
+
+		// One copy per sprite and one fill per health bar, the way the render system used to.
+		Uint64 startTicks = SDL_GetPerformanceCounter();
+		size_t copyDrawCallCount = 0;
+		for (int frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			SDL_SetRenderDrawColor(a_renderer, 0, 0, 0, 255);
+			SDL_RenderClear(a_renderer);
+			copyDrawCallCount = 0;
+			for (const BenchmarkSprite& sprite : sprites)
+			{
+				const SDL_Rect destinationRect = {
+					static_cast<int>(sprite.destinationRect.x),
+					static_cast<int>(sprite.destinationRect.y),
+					static_cast<int>(sprite.destinationRect.w),
+					static_cast<int>(sprite.destinationRect.h)
+				};
+				SDL_RenderCopyEx(a_renderer, a_textures[sprite.textureIndex], &sprite.sourceRect, &destinationRect, sprite.rotation, nullptr, SDL_FLIP_NONE);
+				++copyDrawCallCount;
+			}
+			for (const BenchmarkSprite& sprite : sprites)
+			{
+				const SDL_Rect healthBar = { static_cast<int>(sprite.destinationRect.x), static_cast<int>(sprite.destinationRect.y), SPRITE_SIZE, static_cast<int>(HEALTH_BAR_HEIGHT) };
+				SDL_SetRenderDrawColor(a_renderer, 0, 255, 0, 255);
+				SDL_RenderFillRect(a_renderer, &healthBar);
+				++copyDrawCallCount;
+			}
+			SDL_RenderFlush(a_renderer);
+		}
+		const double copyMilliseconds = MillisecondsSince(startTicks);
+
+		// The same frames through the batcher, recorded and then played back.
+		SpriteBatcher spriteBatcher;
+		RenderCommandBuffer commandBuffer;
+		double submitMilliseconds = 0.0;
+		startTicks = SDL_GetPerformanceCounter();
+		for (int frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			commandBuffer.Clear();
+			commandBuffer.RecordClear({ 0, 0, 0, 255 });
+			spriteBatcher.ResetStatistics();
+			spriteBatcher.Begin(commandBuffer);
+			for (const BenchmarkSprite& sprite : sprites)
+			{
+				spriteBatcher.DrawSprite(a_textures[sprite.textureIndex], { TEXTURE_SIZE, TEXTURE_SIZE }, sprite.sourceRect, sprite.destinationRect, sprite.rotation);
+			}
+			for (const BenchmarkSprite& sprite : sprites)
+			{
+				spriteBatcher.DrawFilledRect({ sprite.destinationRect.x, sprite.destinationRect.y, static_cast<float>(SPRITE_SIZE), HEALTH_BAR_HEIGHT }, { 0, 255, 0, 255 });
+			}
+			spriteBatcher.End();
+
+			const Uint64 submitStartTicks = SDL_GetPerformanceCounter();
+			commandBuffer.Execute(a_renderer);
+			SDL_RenderFlush(a_renderer);
+			submitMilliseconds += MillisecondsSince(submitStartTicks);
+		}
+		const double batchMilliseconds = MillisecondsSince(startTicks);
+
+		const SpriteBatcher::BatchStatistics& statistics = spriteBatcher.GetStatisticsRead();
+		printf("%10zu %14.3f %12zu %14.3f %12zu %12.3f %12.3f\n",
+			a_spriteCount,
+			copyMilliseconds / FRAME_COUNT,
+			copyDrawCallCount,
+			batchMilliseconds / FRAME_COUNT,
+			statistics.drawCallCount,
+			statistics.buildMilliseconds,
+			submitMilliseconds / FRAME_COUNT);
+	}
+}
+
+void RunBatchingBenchmark()
+{
+	// Draw into a surface through the software renderer, so no window or GPU is needed.
+	SDL_Surface* targetSurface = SDL_CreateRGBSurfaceWithFormat(0, TARGET_WIDTH, TARGET_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer* renderer = targetSurface ? SDL_CreateSoftwareRenderer(targetSurface) : nullptr;
+	if (!renderer)
+	{
+		printf("Could not create a software renderer: %s\n", SDL_GetError());
+		SDL_FreeSurface(targetSurface);
+		return;
+	}
+
+	// Fill the sprite sheets with a flat color each.
+	std::vector<SDL_Texture*> textures;
+	for (int textureIndex = 0; textureIndex < TEXTURE_COUNT; ++textureIndex)
+	{
+		SDL_Surface* textureSurface = SDL_CreateRGBSurfaceWithFormat(0, TEXTURE_SIZE, TEXTURE_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+		SDL_FillRect(textureSurface, nullptr, SDL_MapRGBA(textureSurface->format, 64 * textureIndex, 128, 255 - 64 * textureIndex, 255));
+		textures.push_back(SDL_CreateTextureFromSurface(renderer, textureSurface));
+		SDL_FreeSurface(textureSurface);
+	}
+
+	printf("\nSprite batching: %d frames, %dx%d software target, %d textures\n", FRAME_COUNT, TARGET_WIDTH, TARGET_HEIGHT, TEXTURE_COUNT);
+	printf("%10s %14s %12s %14s %12s %12s %12s\n", "sprites", "copy ms/frame", "copy calls", "batch ms/frame", "batch calls", "build ms", "submit ms");
+
+	const size_t spriteCounts[] = { 100, 1000, 10000 };
+	for (const size_t spriteCount : spriteCounts)
+	{
+		RunScene(renderer, textures, spriteCount);
+	}
+
+	for (SDL_Texture* texture : textures)
+	{
+		SDL_DestroyTexture(texture);
+	}
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(targetSurface);
+}
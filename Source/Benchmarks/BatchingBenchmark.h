@@ -0,0 +1,5 @@
+#pragma once
+
+// Times drawing crowds of sprites one copy at a time against the sprite batcher, on SDL's software renderer so it runs
+// without a window, and prints the results.
+void RunBatchingBenchmark();
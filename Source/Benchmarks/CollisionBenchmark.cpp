@@ -0,0 +1,608 @@
+#include "PCH.h"
+#include "CollisionBenchmark.h"
+#include "Collision\AABB.h"
+#include "Collision\AABBNarrowphase.h"
+#include "Collision\CollisionDetector.h"
+#include "Collision\DynamicAABBTree.h"
+#include "Collision\IBroadphase.h"
+#include "Collision\SpatialIndex.h"
+#include "Collision\SweepAndPruneBroadphase.h"
+#include "Collision\UniformGridBroadphase.h"
+#include "Jobs\JobPool.h"
+#include "Timing.h"
+#include <random>
+
+namespace
+{
+	constexpr int FRAME_COUNT = 10;						// Frames simulated per collider count.
+	constexpr float GRID_CELL_SIZE = 64.0f;				// Broadphase grid cell edge.
+	constexpr float TREE_FAT_MARGIN = 8.0f;				// Margin the dynamic tree fattens bounds by.
+	constexpr size_t BRUTE_FORCE_LIMIT = 20000;			// Largest collider count the quadratic loop is timed with.
+	constexpr int REGION_QUERY_COUNT = 1000;			// Region queries timed per collider count.
+	constexpr float REGION_WIDTH = 1280.0f;				// Region queries are the size of a camera view.
+	constexpr float REGION_HEIGHT = 720.0f;
+	constexpr size_t NARROWPHASE_COLLIDER_COUNT = 100000;	// Colliders of the scene the narrowphase is timed on.
+	constexpr int NARROWPHASE_REPEAT_COUNT = 20;			// Times the candidate pairs are tested per instruction set.
+	constexpr size_t SPATIAL_QUERY_COLLIDER_COUNT = 100000;	// Colliders of the scene the spatial queries are timed on.
+	constexpr int SPATIAL_QUERY_COUNT = 1000;				// Queries timed per query kind.
+	constexpr size_t SPATIAL_QUERY_CAPACITY = 4096;			// Result buffer size of the rectangle and circle queries.
+	constexpr size_t NEAREST_COUNT = 8;						// Neighbours found per nearest query.
+	constexpr size_t SCALING_COLLIDER_COUNTS[] = { 50000, 100000 };	// Collider counts the thread scaling is timed with.
+
+	// A synthetic collider layout.
+	struct BenchmarkScenario final
+	{
+		const char* name = nullptr;			// 8 bytes.
+		float colliderSpacing = 0.0f;		// 4 bytes. World area per collider, as the edge of a square.
+		int projectilesPerTen = 0;			// 4 bytes. How many in every ten colliders are projectiles.
+		int largeColliderPeriod = 0;		// 4 bytes. Every this many colliders one is large, zero for none.
+		float largeColliderSize = 0.0f;		// 4 bytes.
+		float maxStep = 0.0f;				// 4 bytes. Largest distance a collider moves along an axis per frame.
+		bool useLayers = false;				// 1 byte. Put colliders on the game's layers instead of all on the default one.
+	};										// Total = 32 bytes with padding.
+
+	// Scatter colliders uniformly over a square world. Some colliders are projectiles, and the scenario may sprinkle in
+	// large ones, the rest are the size of a vehicle. With layers, the first collider is the player and the vehicles are
+	// NPCs, interacting like in the game.
+	std::vector<BroadphaseProxy> CreateProxies(const BenchmarkScenario& a_scenario, const CollisionLayerMatrix& a_layerMatrix, size_t a_colliderCount, float a_worldSize, std::mt19937& a_generator)
+	{
+		std::uniform_real_distribution<float> positionDistribution(0.0f, a_worldSize);
+		std::vector<BroadphaseProxy> proxies(a_colliderCount);
+		for (size_t index = 0; index < a_colliderCount; ++index)
+		{
+			const bool isProjectile = static_cast<int>(index % 10) < a_scenario.projectilesPerTen;
+			float colliderSize = isProjectile ? 4.0f : 32.0f;
+			if (a_scenario.largeColliderPeriod > 0 && index % a_scenario.largeColliderPeriod == 1)
+				colliderSize = a_scenario.largeColliderSize;
+
+			CollisionFilter filter;
+			if (a_scenario.useLayers)
+			{
+				const CollisionLayer layer = index == 0 ? CollisionLayer::PlayerLayer : isProjectile ? CollisionLayer::ProjectileLayer : CollisionLayer::NPCLayer;
+				filter = { GetCollisionLayerBit(layer), a_layerMatrix.GetLayerMask(layer) };
+			}
+
+			const float x = positionDistribution(a_generator);
+			const float y = positionDistribution(a_generator);
+			proxies[index] = { { x, y, x + colliderSize, y + colliderSize }, index, filter };
+		}
+
+		return proxies;
+	}
+
+	// Nudge every collider by a few pixels, as a frame of movement would.
+	void MoveProxies(std::vector<BroadphaseProxy>& a_proxies, float a_maxStep, std::mt19937& a_generator)
+	{
+		std::uniform_real_distribution<float> stepDistribution(-a_maxStep, a_maxStep);
+		for (BroadphaseProxy& proxy : a_proxies)
+		{
+			const float xStep = stepDistribution(a_generator);
+			const float yStep = stepDistribution(a_generator);
+			proxy.bounds = { proxy.bounds.minX + xStep, proxy.bounds.minY + yStep, proxy.bounds.maxX + xStep, proxy.bounds.maxY + yStep };
+		}
+	}
+
+	// The game's layer setup: the player and projectiles only interact with NPCs.
+	CollisionLayerMatrix CreateLayerMatrix()
+	{
+		CollisionLayerMatrix layerMatrix;
+		layerMatrix.ClearLayer(CollisionLayer::PlayerLayer);
+		layerMatrix.ClearLayer(CollisionLayer::NPCLayer);
+		layerMatrix.ClearLayer(CollisionLayer::ProjectileLayer);
+		layerMatrix.SetLayersInteract(CollisionLayer::PlayerLayer, CollisionLayer::NPCLayer, true);
+		layerMatrix.SetLayersInteract(CollisionLayer::ProjectileLayer, CollisionLayer::NPCLayer, true);
+		return layerMatrix;
+	}
+
+	// Test every pair of colliders, and count the overlapping ones.
+	size_t CountOverlapsBruteForce(const std::vector<BroadphaseProxy>& a_proxies)
+	{
+		size_t overlapCount = 0;
+		for (size_t index1 = 0; index1 < a_proxies.size(); ++index1)
+		{
+			for (size_t index2 = index1 + 1; index2 < a_proxies.size(); ++index2)
+			{
+				const bool interact = CollisionFiltersInteract(a_proxies[index1].filter, a_proxies[index2].filter);
+				overlapCount += interact && AABBOverlap(a_proxies[index1].bounds, a_proxies[index2].bounds) ? 1 : 0;
+			}
+		}
+
+		return overlapCount;
+	}
+
+	// Test the candidate pairs produced by a broadphase, and count the overlapping ones. Kept scalar, so the broadphases are
+	// compared on equal footing.
+	size_t CountOverlapsCandidates(const std::vector<BroadphaseProxy>& a_proxies, const std::vector<BroadphasePair>& a_candidatePairs)
+	{
+		size_t overlapCount = 0;
+		for (const BroadphasePair& candidatePair : a_candidatePairs)
+		{
+			overlapCount += AABBOverlap(a_proxies[candidatePair.proxyIndex1].bounds, a_proxies[candidatePair.proxyIndex2].bounds) ? 1 : 0;
+		}
+
+		return overlapCount;
+	}
+
+	// Update a broadphase, query its pairs, and test the candidates. Returns the elapsed milliseconds.
+	double TimePairQuery(IBroadphase& a_broadphase, const std::vector<BroadphaseProxy>& a_proxies, std::vector<BroadphasePair>& a_candidatePairs, size_t& an_overlapCount)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		a_broadphase.Update(a_proxies);
+		a_candidatePairs.clear();
+		a_broadphase.QueryPairs(a_candidatePairs);
+		an_overlapCount = CountOverlapsCandidates(a_proxies, a_candidatePairs);
+		return MillisecondsSince(startTicks);
+	}
+
+	// Run the region queries against a broadphase. Returns the elapsed milliseconds.
+	double TimeRegionQueries(const IBroadphase& a_broadphase, const std::vector<AABB>& a_regions, std::vector<unsigned int>& a_proxyIndices, size_t& a_resultCount)
+	{
+		a_resultCount = 0;
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (const AABB& region : a_regions)
+		{
+			a_proxyIndices.clear();
+			a_broadphase.QueryRegion(region, a_proxyIndices);
+			a_resultCount += a_proxyIndices.size();
+		}
+
+		return MillisecondsSince(startTicks);
+	}
+
+	// Test a pair the way the collision system used to, through integer SDL rectangles.
+	bool CollideSDLRects(const AABB& a_bounds1, const AABB& a_bounds2)
+	{
+		const SDL_Rect rect1 = {
+			static_cast<int>(round(a_bounds1.minX)),
+			static_cast<int>(round(a_bounds1.minY)),
+			static_cast<int>(round(a_bounds1.maxX - a_bounds1.minX)),
+			static_cast<int>(round(a_bounds1.maxY - a_bounds1.minY))
+		};
+
+		const SDL_Rect rect2 = {
+			static_cast<int>(round(a_bounds2.minX)),
+			static_cast<int>(round(a_bounds2.minY)),
+			static_cast<int>(round(a_bounds2.maxX - a_bounds2.minX)),
+			static_cast<int>(round(a_bounds2.maxY - a_bounds2.minY))
+		};
+
+		return SDL_HasIntersection(&rect1, &rect2) == SDL_TRUE;
+	}
+
+	// Time the narrowphase with every supported instruction set on the candidate pairs of a dense scene.
+	void RunNarrowphaseBenchmark()
+	{
+		std::mt19937 generator(1234);
+		const BenchmarkScenario scenario = { "narrowphase", 64.0f, 1, 0, 0.0f, 2.0f, false };
+		const float worldSize = static_cast<float>(sqrt(static_cast<double>(NARROWPHASE_COLLIDER_COUNT))) * scenario.colliderSpacing;
+		const std::vector<BroadphaseProxy> proxies = CreateProxies(scenario, CollisionLayerMatrix(), NARROWPHASE_COLLIDER_COUNT, worldSize, generator);
+
+		// Candidates of a coarse grid, so a good share of them doesn't overlap.
+		UniformGridBroadphase gridBroadphase(worldSize, worldSize, GRID_CELL_SIZE * 4.0f);
+		std::vector<BroadphasePair> candidatePairs;
+		gridBroadphase.Update(proxies);
+		gridBroadphase.QueryPairs(candidatePairs);
+
+		printf("\nNarrowphase: %zu candidate pairs, %zu colliders\n", candidatePairs.size(), NARROWPHASE_COLLIDER_COUNT);
+		printf("%14s %12s %12s\n", "instructions", "ns/pair", "overlaps");
+
+		// The old path, one pair at a time.
+		size_t sdlOverlaps = 0;
+		const Uint64 sdlStart = SDL_GetPerformanceCounter();
+		for (int repeat = 0; repeat < NARROWPHASE_REPEAT_COUNT; ++repeat)
+		{
+			sdlOverlaps = 0;
+			for (const BroadphasePair& candidatePair : candidatePairs)
+			{
+				sdlOverlaps += CollideSDLRects(proxies[candidatePair.proxyIndex1].bounds, proxies[candidatePair.proxyIndex2].bounds) ? 1 : 0;
+			}
+		}
+		const double sdlMilliseconds = MillisecondsSince(sdlStart);
+		printf("%14s %12.3f %12zu\n", "SDL_Rect", sdlMilliseconds * 1000000.0 / NARROWPHASE_REPEAT_COUNT / candidatePairs.size(), sdlOverlaps);
+
+		const AABBNarrowphase::InstructionSet instructionSets[] = {
+			AABBNarrowphase::InstructionSet::ScalarInstructions,
+			AABBNarrowphase::InstructionSet::SSEInstructions,
+			AABBNarrowphase::InstructionSet::AVXInstructions
+		};
+		const char* instructionSetNames[] = { "scalar", "SSE", "AVX" };
+
+		AABBNarrowphase narrowphase;
+		std::vector<BroadphasePair> overlappingPairs;
+		size_t scalarOverlaps = 0;
+		for (int setIndex = 0; setIndex < 3; ++setIndex)
+		{
+			if (!AABBNarrowphase::IsInstructionSetSupported(instructionSets[setIndex]))
+				continue;
+
+			narrowphase.SetInstructionSet(instructionSets[setIndex]);
+			const Uint64 startTicks = SDL_GetPerformanceCounter();
+			for (int repeat = 0; repeat < NARROWPHASE_REPEAT_COUNT; ++repeat)
+			{
+				overlappingPairs.clear();
+				narrowphase.TestPairs(proxies, candidatePairs, overlappingPairs);
+			}
+			const double milliseconds = MillisecondsSince(startTicks);
+
+			// Every instruction set must find exactly the same overlaps.
+			if (setIndex == 0)
+				scalarOverlaps = overlappingPairs.size();
+			assert(overlappingPairs.size() == scalarOverlaps);
+
+			printf("%14s %12.3f %12zu\n", instructionSetNames[setIndex], milliseconds * 1000000.0 / NARROWPHASE_REPEAT_COUNT / candidatePairs.size(), overlappingPairs.size());
+		}
+	}
+
+	// Time the spatial index queries against scanning every collider, and check they agree.
+	void RunSpatialQueryBenchmark()
+	{
+		std::mt19937 generator(1234);
+		const BenchmarkScenario scenario = { "spatial queries", 64.0f, 1, 0, 0.0f, 2.0f, true };
+		const float worldSize = static_cast<float>(sqrt(static_cast<double>(SPATIAL_QUERY_COLLIDER_COUNT))) * scenario.colliderSpacing;
+		const std::vector<BroadphaseProxy> proxies = CreateProxies(scenario, CreateLayerMatrix(), SPATIAL_QUERY_COLLIDER_COUNT, worldSize, generator);
+
+		SpatialIndex spatialIndex(TREE_FAT_MARGIN);
+		spatialIndex.Update(proxies);
+
+		// Query points scattered over the world, and rays of a screen's length in random directions.
+		std::uniform_real_distribution<float> positionDistribution(0.0f, worldSize);
+		std::uniform_real_distribution<float> angleDistribution(0.0f, 6.2831853f);
+		struct QueryPoint final { float x = 0.0f; float y = 0.0f; float angle = 0.0f; };
+		std::vector<QueryPoint> queryPoints(SPATIAL_QUERY_COUNT);
+		for (QueryPoint& queryPoint : queryPoints)
+		{
+			queryPoint = { positionDistribution(generator), positionDistribution(generator), angleDistribution(generator) };
+		}
+
+		const CollisionLayerMask npcMask = GetCollisionLayerBit(CollisionLayer::NPCLayer);
+		const float rectSize = 256.0f;
+		const float radius = 128.0f;
+		const float rayLength = 800.0f;
+		std::vector<Entity> entities(SPATIAL_QUERY_CAPACITY);
+		SpatialQueryHit hits[NEAREST_COUNT];
+
+		printf("\nSpatial queries: %zu colliders, %d queries each, NPC layer only\n", SPATIAL_QUERY_COLLIDER_COUNT, SPATIAL_QUERY_COUNT);
+		printf("%10s %12s %12s %12s\n", "query", "index us", "scan us", "results");
+
+		// Rectangles.
+		size_t indexResults = 0;
+		Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			indexResults += spatialIndex.QueryRect({ queryPoint.x, queryPoint.y, queryPoint.x + rectSize, queryPoint.y + rectSize }, entities.data(), entities.size(), npcMask);
+		}
+		double indexMilliseconds = MillisecondsSince(startTicks);
+
+		size_t scanResults = 0;
+		startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			const AABB rect = { queryPoint.x, queryPoint.y, queryPoint.x + rectSize, queryPoint.y + rectSize };
+			for (const BroadphaseProxy& proxy : proxies)
+			{
+				scanResults += (proxy.filter.layerBit & npcMask) != 0 && AABBOverlap(proxy.bounds, rect) ? 1 : 0;
+			}
+		}
+		double scanMilliseconds = MillisecondsSince(startTicks);
+		assert(indexResults == scanResults);
+		printf("%10s %12.2f %12.2f %12zu\n", "rect", indexMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, scanMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, indexResults);
+
+		// Circles.
+		indexResults = 0;
+		startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			indexResults += spatialIndex.QueryCircle(queryPoint.x, queryPoint.y, radius, entities.data(), entities.size(), npcMask);
+		}
+		indexMilliseconds = MillisecondsSince(startTicks);
+
+		scanResults = 0;
+		startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			for (const BroadphaseProxy& proxy : proxies)
+			{
+				scanResults += (proxy.filter.layerBit & npcMask) != 0 && AABBDistanceSquared(proxy.bounds, queryPoint.x, queryPoint.y) < radius * radius ? 1 : 0;
+			}
+		}
+		scanMilliseconds = MillisecondsSince(startTicks);
+		assert(indexResults == scanResults);
+		printf("%10s %12.2f %12.2f %12zu\n", "circle", indexMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, scanMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, indexResults);
+
+		// Rays, comparing the distance of the first hit.
+		double indexDistances = 0.0;
+		indexResults = 0;
+		startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			SpatialQueryHit hit;
+			if (spatialIndex.Raycast(queryPoint.x, queryPoint.y, cosf(queryPoint.angle), sinf(queryPoint.angle), rayLength, hit, npcMask))
+			{
+				indexDistances += hit.distance;
+				++indexResults;
+			}
+		}
+		indexMilliseconds = MillisecondsSince(startTicks);
+
+		double scanDistances = 0.0;
+		scanResults = 0;
+		startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			const AABB origin = { queryPoint.x, queryPoint.y, queryPoint.x, queryPoint.y };
+			const float displacementX = cosf(queryPoint.angle) * rayLength;
+			const float displacementY = sinf(queryPoint.angle) * rayLength;
+			float closestTimeOfImpact = 2.0f;
+			for (const BroadphaseProxy& proxy : proxies)
+			{
+				float timeOfImpact = 0.0f;
+				if ((proxy.filter.layerBit & npcMask) != 0 && SweepAABB(origin, displacementX, displacementY, proxy.bounds, timeOfImpact))
+					closestTimeOfImpact = std::min(closestTimeOfImpact, timeOfImpact);
+			}
+
+			if (closestTimeOfImpact <= 1.0f)
+			{
+				scanDistances += closestTimeOfImpact * rayLength;
+				++scanResults;
+			}
+		}
+		scanMilliseconds = MillisecondsSince(startTicks);
+		assert(indexResults == scanResults && fabs(indexDistances - scanDistances) < 0.01 * SPATIAL_QUERY_COUNT);
+		printf("%10s %12.2f %12.2f %12zu\n", "ray", indexMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, scanMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, indexResults);
+
+		// Nearest neighbours, comparing the distance of the farthest one.
+		indexDistances = 0.0;
+		startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			const size_t hitCount = spatialIndex.NearestK(queryPoint.x, queryPoint.y, NEAREST_COUNT, hits, npcMask);
+			indexDistances += hitCount > 0 ? hits[hitCount - 1].distance : 0.0f;
+		}
+		indexMilliseconds = MillisecondsSince(startTicks);
+
+		scanDistances = 0.0;
+		std::vector<float> distancesSquared;
+		startTicks = SDL_GetPerformanceCounter();
+		for (const QueryPoint& queryPoint : queryPoints)
+		{
+			distancesSquared.clear();
+			for (const BroadphaseProxy& proxy : proxies)
+			{
+				if ((proxy.filter.layerBit & npcMask) != 0)
+					distancesSquared.push_back(AABBDistanceSquared(proxy.bounds, queryPoint.x, queryPoint.y));
+			}
+
+			std::nth_element(distancesSquared.begin(), distancesSquared.begin() + (NEAREST_COUNT - 1), distancesSquared.end());
+			scanDistances += sqrtf(distancesSquared[NEAREST_COUNT - 1]);
+		}
+		scanMilliseconds = MillisecondsSince(startTicks);
+		assert(fabs(indexDistances - scanDistances) < 0.01 * SPATIAL_QUERY_COUNT);
+		printf("%10s %12.2f %12.2f %12zu\n", "nearest", indexMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, scanMilliseconds * 1000.0 / SPATIAL_QUERY_COUNT, NEAREST_COUNT);
+	}
+
+	// Run the collision detection over a few frames of a dense scene with the given number of threads. Returns the time
+	// per frame, and the colliding pairs of the last frame.
+	double TimeCollisionDetection(BroadphaseType a_broadphaseType, size_t a_colliderCount, unsigned int a_threadCount, std::vector<BroadphasePair>& a_collidingPairs)
+	{
+		std::mt19937 generator(1234);
+		const BenchmarkScenario scenario = { "thread scaling", 64.0f, 1, 0, 0.0f, 2.0f, false };
+		const float worldSize = static_cast<float>(sqrt(static_cast<double>(a_colliderCount))) * scenario.colliderSpacing;
+		std::vector<BroadphaseProxy> proxies = CreateProxies(scenario, CollisionLayerMatrix(), a_colliderCount, worldSize, generator);
+		const std::vector<unsigned char> proxyIsSwept(a_colliderCount, 0);
+
+		std::unique_ptr<IBroadphase> broadphase;
+		if (a_broadphaseType == BroadphaseType::UniformGridType)
+			broadphase = std::make_unique<UniformGridBroadphase>(worldSize, worldSize, GRID_CELL_SIZE);
+		else
+			broadphase = std::make_unique<DynamicAABBTree>(TREE_FAT_MARGIN);
+
+		CollisionDetector collisionDetector(std::move(broadphase));
+		JobPool jobPool;
+		jobPool.Initialize(a_threadCount - 1);
+
+		double milliseconds = 0.0;
+		for (int frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			MoveProxies(proxies, scenario.maxStep, generator);
+
+			const Uint64 startTicks = SDL_GetPerformanceCounter();
+			collisionDetector.DetectCollisions(proxies, proxyIsSwept, &jobPool);
+			milliseconds += MillisecondsSince(startTicks);
+		}
+
+		a_collidingPairs = collisionDetector.GetCollidingPairsRead();
+		return milliseconds / FRAME_COUNT;
+	}
+
+	// Time the collision detection of the grid and the tree as threads are added.
+	void RunThreadScalingBenchmark()
+	{
+		const unsigned int hardwareThreadCount = std::max(1u, std::thread::hardware_concurrency());
+		const BroadphaseType broadphaseTypes[] = { BroadphaseType::UniformGridType, BroadphaseType::DynamicTreeType };
+		const char* broadphaseNames[] = { "grid", "tree" };
+
+		printf("\nThread scaling: %u hardware threads\n", hardwareThreadCount);
+		printf("%10s %10s %8s %12s %10s %12s\n", "broadphase", "colliders", "threads", "ms/frame", "speedup", "pairs");
+
+		for (int typeIndex = 0; typeIndex < 2; ++typeIndex)
+		{
+			for (const size_t colliderCount : SCALING_COLLIDER_COUNTS)
+			{
+				std::vector<BroadphasePair> singleThreadPairs;
+				std::vector<BroadphasePair> collidingPairs;
+				double singleThreadMilliseconds = 0.0;
+				for (unsigned int threadCount = 1; threadCount <= hardwareThreadCount; threadCount *= 2)
+				{
+					const double milliseconds = TimeCollisionDetection(broadphaseTypes[typeIndex], colliderCount, threadCount, collidingPairs);
+					if (threadCount == 1)
+					{
+						singleThreadMilliseconds = milliseconds;
+						singleThreadPairs = collidingPairs;
+					}
+
+					// The pairs must come out identical, in the same order, however many threads ran.
+					assert(collidingPairs.size() == singleThreadPairs.size());
+					assert(std::equal(collidingPairs.begin(), collidingPairs.end(), singleThreadPairs.begin(), [](const BroadphasePair& a_pair1, const BroadphasePair& a_pair2)
+					{
+						return a_pair1.proxyIndex1 == a_pair2.proxyIndex1 && a_pair1.proxyIndex2 == a_pair2.proxyIndex2;
+					}));
+
+					printf("%10s %10zu %8u %12.3f %10.2f %12zu\n", broadphaseNames[typeIndex], colliderCount, threadCount, milliseconds, singleThreadMilliseconds / milliseconds, collidingPairs.size());
+				}
+			}
+		}
+	}
+
+	// Returns false if the broadphases disagree with each other or with the brute force loop.
+	bool RunScenario(const BenchmarkScenario& a_scenario)
+	{
+		const size_t colliderCounts[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+
+		printf("\nScenario: %s\n", a_scenario.name);
+		printf("%10s %14s %14s %14s %14s %14s %14s %12s %12s %12s %14s %14s %14s\n",
+			"colliders", "brute ms/frame", "grid ms/frame", "tree build ms", "tree ms/frame", "sap build ms", "sap ms/frame", "sap deltas", "grid pairs",
+			"overlaps", "grid us/region", "tree us/region", "sap us/region");
+
+		for (const size_t colliderCount : colliderCounts)
+		{
+			// Build the same synthetic scene for every collider count, keeping the collider density constant.
+			std::mt19937 generator(1234);
+			const float worldSize = static_cast<float>(sqrt(static_cast<double>(colliderCount))) * a_scenario.colliderSpacing;
+			std::vector<BroadphaseProxy> proxies = CreateProxies(a_scenario, CreateLayerMatrix(), colliderCount, worldSize, generator);
+
+			UniformGridBroadphase gridBroadphase(worldSize, worldSize, GRID_CELL_SIZE);
+			DynamicAABBTree treeBroadphase(TREE_FAT_MARGIN);
+			SweepAndPruneBroadphase sweepAndPruneBroadphase;
+			std::vector<BroadphasePair> candidatePairs;
+
+			double bruteForceMilliseconds = 0.0;
+			double gridMilliseconds = 0.0;
+			double treeMilliseconds = 0.0;
+			double treeFirstFrameMilliseconds = 0.0;
+			double sweepAndPruneMilliseconds = 0.0;
+			double sweepAndPruneFirstFrameMilliseconds = 0.0;
+			size_t sweepAndPruneDeltas = 0;
+			size_t bruteForceOverlaps = 0;
+			size_t gridCandidates = 0;
+			size_t gridOverlaps = 0;
+			size_t treeOverlaps = 0;
+			size_t sweepAndPruneOverlaps = 0;
+
+			for (int frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				MoveProxies(proxies, a_scenario.maxStep, generator);
+
+				// Time the quadratic loop.
+				if (colliderCount <= BRUTE_FORCE_LIMIT)
+				{
+					const Uint64 bruteForceStart = SDL_GetPerformanceCounter();
+					bruteForceOverlaps = CountOverlapsBruteForce(proxies);
+					bruteForceMilliseconds += MillisecondsSince(bruteForceStart);
+				}
+
+				// Time the broadphase updates, pair queries, and the overlap tests of the candidates.
+				gridMilliseconds += TimePairQuery(gridBroadphase, proxies, candidatePairs, gridOverlaps);
+				gridCandidates = candidatePairs.size();
+
+				// The first tree update inserts every proxy, and the first sweep and prune update sorts from scratch, keep
+				// them apart from the incremental ones.
+				const double treeFrameMilliseconds = TimePairQuery(treeBroadphase, proxies, candidatePairs, treeOverlaps);
+				if (frame == 0)
+					treeFirstFrameMilliseconds = treeFrameMilliseconds;
+				else
+					treeMilliseconds += treeFrameMilliseconds;
+
+				const double sweepAndPruneFrameMilliseconds = TimePairQuery(sweepAndPruneBroadphase, proxies, candidatePairs, sweepAndPruneOverlaps);
+				if (frame == 0)
+				{
+					sweepAndPruneFirstFrameMilliseconds = sweepAndPruneFrameMilliseconds;
+				}
+				else
+				{
+					sweepAndPruneMilliseconds += sweepAndPruneFrameMilliseconds;
+					sweepAndPruneDeltas += sweepAndPruneBroadphase.GetAddedPairs().size() + sweepAndPruneBroadphase.GetRemovedPairs().size();
+				}
+			}
+
+			// Every path must find exactly the same overlaps. Checked in release builds too, as that's what the benchmark
+			// runs in.
+			const bool bruteForceMatches = colliderCount > BRUTE_FORCE_LIMIT || bruteForceOverlaps == gridOverlaps;
+			if (!bruteForceMatches || gridOverlaps != treeOverlaps || gridOverlaps != sweepAndPruneOverlaps)
+			{
+				fprintf(stderr, "%s, %zu colliders: overlaps differ, brute force %zu, grid %zu, tree %zu, sweep and prune %zu.\n",
+					a_scenario.name, colliderCount, bruteForceOverlaps, gridOverlaps, treeOverlaps, sweepAndPruneOverlaps);
+				return false;
+			}
+
+			// Time camera sized region queries scattered over the world.
+			std::uniform_real_distribution<float> regionDistribution(0.0f, worldSize);
+			std::vector<AABB> regions(REGION_QUERY_COUNT);
+			for (AABB& region : regions)
+			{
+				const float x = regionDistribution(generator);
+				const float y = regionDistribution(generator);
+				region = { x, y, x + REGION_WIDTH, y + REGION_HEIGHT };
+			}
+
+			std::vector<unsigned int> proxyIndices;
+			size_t gridRegionResults = 0;
+			size_t treeRegionResults = 0;
+			const double gridRegionMilliseconds = TimeRegionQueries(gridBroadphase, regions, proxyIndices, gridRegionResults);
+			size_t sweepAndPruneRegionResults = 0;
+			const double treeRegionMilliseconds = TimeRegionQueries(treeBroadphase, regions, proxyIndices, treeRegionResults);
+			const double sweepAndPruneRegionMilliseconds = TimeRegionQueries(sweepAndPruneBroadphase, regions, proxyIndices, sweepAndPruneRegionResults);
+			if (gridRegionResults != treeRegionResults || gridRegionResults != sweepAndPruneRegionResults)
+			{
+				fprintf(stderr, "%s, %zu colliders: region query results differ, grid %zu, tree %zu, sweep and prune %zu.\n",
+					a_scenario.name, colliderCount, gridRegionResults, treeRegionResults, sweepAndPruneRegionResults);
+				return false;
+			}
+
+			if (colliderCount <= BRUTE_FORCE_LIMIT)
+				printf("%10zu %14.3f ", colliderCount, bruteForceMilliseconds / FRAME_COUNT);
+			else
+				printf("%10zu %14s ", colliderCount, "-");
+
+			printf("%14.3f %14.3f %14.3f %14.3f %14.3f %12zu %12zu %12zu %14.2f %14.2f %14.2f\n",
+				gridMilliseconds / FRAME_COUNT,
+				treeFirstFrameMilliseconds,
+				treeMilliseconds / (FRAME_COUNT - 1),
+				sweepAndPruneFirstFrameMilliseconds,
+				sweepAndPruneMilliseconds / (FRAME_COUNT - 1),
+				sweepAndPruneDeltas / (FRAME_COUNT - 1),
+				gridCandidates,
+				gridOverlaps,
+				gridRegionMilliseconds * 1000.0 / REGION_QUERY_COUNT,
+				treeRegionMilliseconds * 1000.0 / REGION_QUERY_COUNT,
+				sweepAndPruneRegionMilliseconds * 1000.0 / REGION_QUERY_COUNT);
+		}
+
+		return true;
+	}
+}
+
+bool RunCollisionBenchmark()
+{
+	// Dense world of similarly sized colliders, the case the grid is tuned for.
+	if (!RunScenario({ "uniform", 64.0f, 1, 0, 0.0f, 2.0f, false }))
+		return false;
+
+	// Sparse world with a few colliders far larger than the grid cells, the case the tree is meant for.
+	if (!RunScenario({ "sparse mixed sizes", 256.0f, 1, 100, 512.0f, 2.0f, false }))
+		return false;
+
+	// Crowd of slow NPCs barely moving between frames, the case sweep and prune is meant for.
+	if (!RunScenario({ "slow crowd", 64.0f, 1, 0, 0.0f, 0.25f, false }))
+		return false;
+
+	// Bullet heavy scene, seven in ten colliders are projectiles. With collision layers most pairs are dropped early.
+	if (!RunScenario({ "bullets", 64.0f, 7, 0, 0.0f, 2.0f, false }))
+		return false;
+	if (!RunScenario({ "bullets with layers", 64.0f, 7, 0, 0.0f, 2.0f, true }))
+		return false;
+
+	RunNarrowphaseBenchmark();
+	RunSpatialQueryBenchmark();
+	RunThreadScalingBenchmark();
+	return true;
+}
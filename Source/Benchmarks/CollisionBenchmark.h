@@ -0,0 +1,6 @@
+#pragma once
+
+// Times the collision broadphases against the brute force pair loop over synthetic colliders, along with their region
+// queries, the spatial index queries, and how the collision detection scales with threads, and prints the results.
+// Returns false if the broadphases find different overlaps.
+bool RunCollisionBenchmark();
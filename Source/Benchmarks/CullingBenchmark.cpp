@@ -0,0 +1,116 @@
+#include "PCH.h"
+#include "CullingBenchmark.h"
+#include "Collision\AABB.h"
+#include "Rendering\ViewportCuller.h"
+#include "Timing.h"
+#include <random>
+
+namespace
+{
+	constexpr int FRAME_COUNT = 100;					// Frames simulated per scene.
+	constexpr int TILES_PER_ROW = 1000;					// The world is a square of a million tiles.
+	constexpr float TILE_SIZE = 32.0f;
+	constexpr float VIEWPORT_WIDTH = 800.0f;			// The size of the game window.
+	constexpr float VIEWPORT_HEIGHT = 600.0f;
+	constexpr float CAMERA_SPEED = 4.0f;				// Pixels the camera pans per frame.
+	constexpr float ENTITY_SIZE = 32.0f;				// Size of the moving entities.
+	constexpr float MAX_STEP = 2.0f;					// Largest distance a moving entity covers along an axis per frame.
+
+	// Pan the camera along the diagonal of the world, and time both culling paths over the same frames.
+	void RunScene(size_t a_dynamicCount)
+	{
+		const float worldSize = TILES_PER_ROW * TILE_SIZE;
+		const size_t tileCount = static_cast<size_t>(TILES_PER_ROW) * TILES_PER_ROW;
+
+		// Lay the tiles out in rows, and scatter the moving entities after them.
+		std::vector<BroadphaseProxy> tileProxies(tileCount);
+		for (size_t tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+		{
+			const float x = static_cast<float>(tileIndex % TILES_PER_ROW) * TILE_SIZE;
+			const float y = static_cast<float>(tileIndex / TILES_PER_ROW) * TILE_SIZE;
+			tileProxies[tileIndex] = { { x, y, x + TILE_SIZE, y + TILE_SIZE }, tileIndex };
+		}
+
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float> positionDistribution(0.0f, worldSize - ENTITY_SIZE);
+		std::uniform_real_distribution<float> stepDistribution(-MAX_STEP, MAX_STEP);
+		std::vector<BroadphaseProxy> dynamicProxies(a_dynamicCount);
+		for (size_t dynamicIndex = 0; dynamicIndex < a_dynamicCount; ++dynamicIndex)
+		{
+			const float x = positionDistribution(generator);
+			const float y = positionDistribution(generator);
+			dynamicProxies[dynamicIndex] = { { x, y, x + ENTITY_SIZE, y + ENTITY_SIZE }, tileCount + dynamicIndex };
+		}
+
+		// Place the tiles once.
+		ViewportCuller viewportCuller(worldSize, worldSize);
+		Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (const BroadphaseProxy& tileProxy : tileProxies)
+		{
+			viewportCuller.AddStaticEntity(tileProxy.entity, tileProxy.bounds);
+		}
+		std::vector<Entity> visibleEntities;
+		viewportCuller.QueryVisibleEntities({ 0.0f, 0.0f, 0.0f, 0.0f }, visibleEntities);
+		const double buildMilliseconds = MillisecondsSince(startTicks);
+
+		double scanMilliseconds = 0.0;
+		double cullerMilliseconds = 0.0;
+		size_t visibleCount = 0;
+		for (int frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			for (BroadphaseProxy& dynamicProxy : dynamicProxies)
+			{
+				const float xStep = stepDistribution(generator);
+				const float yStep = stepDistribution(generator);
+				dynamicProxy.bounds = { dynamicProxy.bounds.minX + xStep, dynamicProxy.bounds.minY + yStep, dynamicProxy.bounds.maxX + xStep, dynamicProxy.bounds.maxY + yStep };
+			}
+
+			const float cameraPosition = frame * CAMERA_SPEED;
+			const AABB viewport = { cameraPosition, cameraPosition, cameraPosition + VIEWPORT_WIDTH, cameraPosition + VIEWPORT_HEIGHT };
+
+			// Test every entity against the viewport, the way the render system used to, minus the component lookups.
+			startTicks = SDL_GetPerformanceCounter();
+			size_t scanCount = 0;
+			for (const BroadphaseProxy& tileProxy : tileProxies)
+			{
+				scanCount += AABBOverlap(tileProxy.bounds, viewport) ? 1 : 0;
+			}
+			for (const BroadphaseProxy& dynamicProxy : dynamicProxies)
+			{
+				scanCount += AABBOverlap(dynamicProxy.bounds, viewport) ? 1 : 0;
+			}
+			scanMilliseconds += MillisecondsSince(startTicks);
+
+			// Hand the moving entities over, and query the viewport.
+			startTicks = SDL_GetPerformanceCounter();
+			viewportCuller.UpdateDynamicEntities(dynamicProxies);
+			visibleEntities.clear();
+			viewportCuller.QueryVisibleEntities(viewport, visibleEntities);
+			cullerMilliseconds += MillisecondsSince(startTicks);
+
+			// Both paths must find the same entities.
+			assert(visibleEntities.size() == scanCount);
+			visibleCount = visibleEntities.size();
+		}
+
+		printf("%10zu %10zu %12.2f %14.4f %14.4f %10zu\n",
+			tileCount,
+			a_dynamicCount,
+			buildMilliseconds,
+			scanMilliseconds / FRAME_COUNT,
+			cullerMilliseconds / FRAME_COUNT,
+			visibleCount);
+	}
+}
+
+void RunCullingBenchmark()
+{
+	printf("\nViewport culling: %d frames, %.0fx%.0f viewport\n", FRAME_COUNT, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	printf("%10s %10s %12s %14s %14s %10s\n", "tiles", "moving", "build ms", "scan ms/frame", "cull ms/frame", "visible");
+
+	const size_t dynamicCounts[] = { 0, 1000, 10000, 100000 };
+	for (const size_t dynamicCount : dynamicCounts)
+	{
+		RunScene(dynamicCount);
+	}
+}
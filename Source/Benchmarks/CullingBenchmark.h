@@ -0,0 +1,5 @@
+#pragma once
+
+// Times the viewport culler against testing every entity, on a world of a million tiles and a crowd of moving entities,
+// and prints the results.
+void RunCullingBenchmark();
@@ -0,0 +1,452 @@
+#include "PCH.h"
+#include "ECSBenchmark.h"
+#include "Components\Components.h"
+#include "Constants\Constants.h"
+#include "Engine.h"
+#include "EventManager\EventManager.h"
+#include "Memory\AllocationCounter.h"
+#include "Memory\FrameArena.h"
+#include "Systems\CollisionSystem.h"
+#include "Systems\EntityMovementSystem.h"
+#include "Systems\SpriteUpdateSystem.h"
+#include "Systems\TextureRenderSystem.h"
+#include "Tags\Tags.h"
+#include "Timing.h"
+#include <random>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+namespace
+{
+	constexpr size_t ENTITY_COUNTS[] = { 1000, 10000, 100000, 1000000 };
+	constexpr size_t ENTITY_FRAME_BUDGET = 2000000;		// Entity updates timed per scene and count, spread over the frames.
+	constexpr size_t MIN_FRAME_COUNT = 5;
+	constexpr size_t MAX_FRAME_COUNT = 100;
+	constexpr float SIMULATION_STEP = 1.0f / 60.0f;		// Seconds simulated per frame.
+	constexpr float MAX_SPEED = 100.0f;					// Largest speed of a moving entity along an axis, in pixels per second.
+	constexpr float SPRITE_SPACING = 64.0f;				// World area per sprite, as the edge of a square.
+	constexpr float CHURN_FRACTION = 0.01f;				// Share of the entities despawned and spawned again every frame.
+	constexpr float CAMERA_SPEED = 4.0f;				// Pixels the camera pans per frame along each axis.
+	constexpr int TILE_SIZE = 32;
+	constexpr unsigned int SEED = 1234;
+	constexpr size_t MAX_BASELINE_RESULTS = 256;
+
+	// The synthetic scenes, each built on the systems the game runs.
+	enum class SceneKind : unsigned char
+	{
+		MovementScene = 0,	// Entities moving by their velocity.
+		CollisionScene,		// Moving colliders, at the density asked for.
+		ChurnScene,			// Moving sprites, a share of them despawned and spawned again every frame.
+		TileMapScene,		// A large tile map, with the camera panning over it.
+		RenderScene,		// Moving animated sprites, culled, sorted and batched for the null backend.
+		SceneCount
+	};
+
+	const char* const SCENE_NAMES[] = { "movement", "collision", "churn", "tilemap", "render" };
+
+	struct BenchmarkOptions final
+	{
+		size_t maxEntityCount = 1000000;					// 8 bytes.
+		const char* jsonPath = "./ECSBenchmark.json";		// 8 bytes.
+		const char* baselinePath = nullptr;					// 8 bytes.
+		float colliderSpacing = 64.0f;						// 4 bytes.
+	};														// Total = 32 bytes with padding.
+
+	// The measurements of a scene at an entity count.
+	struct SceneResult final
+	{
+		char sceneName[32] = { '\0' };			// 32 bytes.
+		size_t entityCount = 0;					// 8 bytes.
+		size_t frameCount = 0;					// 8 bytes.
+		double millisecondsPerFrame = 0.0;		// 8 bytes.
+		double nanosecondsPerEntity = 0.0;		// 8 bytes.
+		double allocationsPerFrame = 0.0;		// 8 bytes.
+		double allocatedBytesPerFrame = 0.0;	// 8 bytes.
+		size_t residentGrowthBytes = 0;			// 8 bytes. Resident memory the scene added, from before setup to after its frames.
+	};											// Total = 88 bytes.
+
+	// What a scene needs to keep around between frames.
+	struct SceneState final
+	{
+		std::deque<Entity> liveEntities;			// Entities the churn despawns, oldest first.
+		Entity cameraEntity = INVALID_ENTITY;
+		float worldSize = 0.0f;
+		bool isRendered = false;
+	};
+
+	// Current resident memory of the process, in bytes. The peak would be that of the largest scene run so far, whichever
+	// scene is measured.
+	size_t GetResidentBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS memoryCounters = {};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+			return memoryCounters.WorkingSetSize;
+		return 0;
+#else
+		// The second field of statm is the resident size, in pages.
+		size_t totalPages = 0;
+		size_t residentPages = 0;
+		FILE* file = fopen("/proc/self/statm", "r");
+		if (file == nullptr)
+			return 0;
+		const int fieldCount = fscanf(file, "%zu %zu", &totalPages, &residentPages);
+		fclose(file);
+		return fieldCount == 2 ? residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif // _WIN32
+	}
+
+	void ParseOptions(int argc, char* argv[], BenchmarkOptions& an_options)
+	{
+		for (int argumentIndex = 0; argumentIndex < argc; ++argumentIndex)
+		{
+			if (strcmp(argv[argumentIndex], "--max-entities") == 0 && argumentIndex + 1 < argc)
+				an_options.maxEntityCount = strtoull(argv[++argumentIndex], nullptr, 10);
+			else if (strcmp(argv[argumentIndex], "--spacing") == 0 && argumentIndex + 1 < argc)
+				an_options.colliderSpacing = std::max(1.0f, static_cast<float>(atof(argv[++argumentIndex])));
+			else if (strcmp(argv[argumentIndex], "--json") == 0 && argumentIndex + 1 < argc)
+				an_options.jsonPath = argv[++argumentIndex];
+			else if (strcmp(argv[argumentIndex], "--baseline") == 0 && argumentIndex + 1 < argc)
+				an_options.baselinePath = argv[++argumentIndex];
+		}
+	}
+
+	// Create an entity of the scene somewhere in the world, moving in a random direction.
+	Entity CreateMovingEntity(SceneKind a_sceneKind, float a_worldSize, std::mt19937& a_generator)
+	{
+		static const TextureManager& textureManager = TextureManager::GetInstanceRead();
+		static const TextureId tankTexture = textureManager.GetTextureId("./Assets/Images/Tank.png");
+		static const TextureId airplaneSpritesheet = textureManager.GetTextureId("./Assets/Images/Airplane-Spritesheet.png");
+
+		std::uniform_real_distribution<float> positionDistribution(0.0f, a_worldSize);
+		std::uniform_real_distribution<float> speedDistribution(-MAX_SPEED, MAX_SPEED);
+
+		Registry& registry = Engine::GetInstanceWrite().GetRegistryWrite();
+		const Entity entity = registry.CreateEntity();
+		registry.AddComponent<TransformComponent>(entity, { positionDistribution(a_generator), positionDistribution(a_generator), 0.0f, 1.0f, 1.0f });
+		registry.AddComponent<VelocityComponent>(entity, { speedDistribution(a_generator), speedDistribution(a_generator) });
+
+		switch (a_sceneKind)
+		{
+		case SceneKind::CollisionScene:
+			registry.AddComponent<CollisionComponent>(entity, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
+			break;
+		case SceneKind::ChurnScene:
+			registry.AddComponent<TextureComponent>(entity, { tankTexture, RenderOrder::NPCOrder });
+			break;
+		case SceneKind::RenderScene:
+			registry.AddComponent<TextureComponent>(entity, { airplaneSpritesheet, RenderOrder::NPCOrder });
+			registry.AddComponent<AnimationComponent>(entity, { 125, 0, 32, 32, 1, 3, 0, 0 });
+			break;
+		default:
+			break;
+		}
+
+		return entity;
+	}
+
+	// Add the scene's systems and entities to the registry, and initialize them.
+	void SetUpScene(SceneKind a_sceneKind, size_t an_entityCount, const BenchmarkOptions& an_options, std::mt19937& a_generator, SceneState& a_sceneState)
+	{
+		Engine& engine = Engine::GetInstanceWrite();
+		Registry& registry = engine.GetRegistryWrite();
+		TileManager& tileManager = engine.GetTileManagerWrite();
+
+		// The world grows with the entity count, so their density stays the same.
+		const float spacing = a_sceneKind == SceneKind::CollisionScene ? an_options.colliderSpacing : SPRITE_SPACING;
+		a_sceneState = SceneState();
+		a_sceneState.worldSize = static_cast<float>(sqrt(static_cast<double>(an_entityCount))) * spacing;
+
+		// The order at which the systems sequentially update and render, like in the game.
+		switch (a_sceneKind)
+		{
+		case SceneKind::MovementScene:
+			registry.AddSystem<EntityMovementSystem>();
+			break;
+		case SceneKind::CollisionScene:
+			registry.AddSystem<EntityMovementSystem>();
+			registry.AddSystem<CollisionSystem>().SetBroadphaseType(BroadphaseType::UniformGridType);
+			break;
+		case SceneKind::ChurnScene:
+			registry.AddSystem<EntityMovementSystem>();
+			registry.AddSystem<TextureRenderSystem>();
+			break;
+		case SceneKind::TileMapScene:
+			registry.AddSystem<TextureRenderSystem>();
+			break;
+		case SceneKind::RenderScene:
+			registry.AddSystem<EntityMovementSystem>();
+			registry.AddSystem<SpriteUpdateSystem>();
+			registry.AddSystem<TextureRenderSystem>();
+			break;
+		default:
+			assert(false && "Unknown scene kind.");
+			break;
+		}
+
+		// Tiles come from the tile manager, everything else is scattered over the world.
+		if (a_sceneKind == SceneKind::TileMapScene)
+		{
+			const int tilesPerRow = static_cast<int>(ceil(sqrt(static_cast<double>(an_entityCount))));
+			tileManager.CreateRandomMap("./Assets/Maps/Jungle.png", tilesPerRow, tilesPerRow, TILE_SIZE, TILE_SIZE, SEED);
+			a_sceneState.worldSize = static_cast<float>(tileManager.GetMapWidth());
+		}
+		else
+		{
+			tileManager.SetMapSize(static_cast<int>(ceil(a_sceneState.worldSize)), static_cast<int>(ceil(a_sceneState.worldSize)));
+			for (size_t entityIndex = 0; entityIndex < an_entityCount; ++entityIndex)
+			{
+				a_sceneState.liveEntities.push_back(CreateMovingEntity(a_sceneKind, a_sceneState.worldSize, a_generator));
+			}
+		}
+
+		// The rendered scenes are looked at through a camera panning over the world.
+		a_sceneState.isRendered = a_sceneKind == SceneKind::ChurnScene || a_sceneKind == SceneKind::TileMapScene || a_sceneKind == SceneKind::RenderScene;
+		if (a_sceneState.isRendered)
+		{
+			a_sceneState.cameraEntity = registry.CreateEntity();
+			registry.AddComponent<TransformComponent>(a_sceneState.cameraEntity, { 0.0f, 0.0f, 0.0f });
+			registry.AddComponent<CameraComponent>(a_sceneState.cameraEntity, { engine.GetWindowWidth(), engine.GetWindowHeight() });
+			registry.AddTag<CameraTag>(a_sceneState.cameraEntity);
+		}
+
+		registry.RunSystemsInitialize();
+	}
+
+	// Despawn the oldest entities of the churn scene, and spawn as many new ones. Processed at the next flush.
+	void ChurnEntities(SceneState& a_sceneState, std::mt19937& a_generator)
+	{
+		Registry& registry = Engine::GetInstanceWrite().GetRegistryWrite();
+		const size_t churnCount = std::max<size_t>(1, static_cast<size_t>(a_sceneState.liveEntities.size() * CHURN_FRACTION));
+		for (size_t churnIndex = 0; churnIndex < churnCount; ++churnIndex)
+		{
+			registry.RemoveEntity(a_sceneState.liveEntities.front());
+			a_sceneState.liveEntities.pop_front();
+		}
+		for (size_t churnIndex = 0; churnIndex < churnCount; ++churnIndex)
+		{
+			a_sceneState.liveEntities.push_back(CreateMovingEntity(SceneKind::ChurnScene, a_sceneState.worldSize, a_generator));
+		}
+	}
+
+	// Run a frame the way the engine does: a simulation step, then recording the frame and handing it over.
+	void RunFrame(SceneKind a_sceneKind, size_t a_frameIndex, SceneState& a_sceneState, std::mt19937& a_generator)
+	{
+		Engine& engine = Engine::GetInstanceWrite();
+		Registry& registry = engine.GetRegistryWrite();
+
+		if (a_sceneKind == SceneKind::ChurnScene)
+			ChurnEntities(a_sceneState, a_generator);
+
+		// Pan the camera along the diagonal of the world.
+		if (a_sceneState.cameraEntity != INVALID_ENTITY)
+		{
+			const float panLength = std::max(1.0f, a_sceneState.worldSize - static_cast<float>(std::max(engine.GetWindowWidth(), engine.GetWindowHeight())));
+			TransformComponent& cameraTransform = registry.GetComponentWrite<TransformComponent>(a_sceneState.cameraEntity);
+			cameraTransform.x = fmodf(a_frameIndex * CAMERA_SPEED, panLength);
+			cameraTransform.y = cameraTransform.x;
+		}
+
+		registry.RunSystemsUpdate(SIMULATION_STEP);
+		registry.RunSystemsRender();
+		if (a_sceneState.isRendered)
+			engine.GetRenderThreadWrite().SubmitFrame();
+		EventManager::GetInstanceWrite().EndFrame();
+		FrameArena::GetInstanceWrite().EndFrame();
+	}
+
+	// Remove everything the scene added, and every event subscription its systems made.
+	void TearDownScene()
+	{
+		Engine& engine = Engine::GetInstanceWrite();
+		engine.GetRenderThreadWrite().WaitForIdle();
+		engine.GetSceneManagerWrite().Shutdown();
+		EventManager::GetInstanceWrite().Shutdown();
+	}
+
+	SceneResult RunScene(SceneKind a_sceneKind, size_t an_entityCount, const BenchmarkOptions& an_options)
+	{
+		const size_t startResidentBytes = GetResidentBytes();
+		std::mt19937 generator(SEED);
+		SceneState sceneState;
+		SetUpScene(a_sceneKind, an_entityCount, an_options, generator, sceneState);
+
+		// The first frame sorts the new entities into the culler and the broadphase, which is loading, not running.
+		RunFrame(a_sceneKind, 0, sceneState, generator);
+
+		const size_t frameCount = std::min(MAX_FRAME_COUNT, std::max(MIN_FRAME_COUNT, ENTITY_FRAME_BUDGET / an_entityCount));
+		const AllocationCounts startCounts = GetAllocationCounts();
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (size_t frameIndex = 1; frameIndex <= frameCount; ++frameIndex)
+		{
+			RunFrame(a_sceneKind, frameIndex, sceneState, generator);
+		}
+		const double milliseconds = MillisecondsSince(startTicks);
+		const AllocationCounts endCounts = GetAllocationCounts();
+
+		SceneResult result;
+		snprintf(result.sceneName, sizeof(result.sceneName), "%s", SCENE_NAMES[static_cast<int>(a_sceneKind)]);
+		result.entityCount = an_entityCount;
+		result.frameCount = frameCount;
+		result.millisecondsPerFrame = milliseconds / frameCount;
+		result.nanosecondsPerEntity = result.millisecondsPerFrame * 1000000.0 / an_entityCount;
+		result.allocationsPerFrame = static_cast<double>(endCounts.allocationCount - startCounts.allocationCount) / frameCount;
+		result.allocatedBytesPerFrame = static_cast<double>(endCounts.allocatedBytes - startCounts.allocatedBytes) / frameCount;
+		const size_t endResidentBytes = GetResidentBytes();
+		result.residentGrowthBytes = endResidentBytes > startResidentBytes ? endResidentBytes - startResidentBytes : 0;
+
+		TearDownScene();
+		return result;
+	}
+
+	bool WriteResultsJson(const char* a_filePath, const std::vector<SceneResult>& a_results)
+	{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+		FILE* file = fopen(a_filePath, "w");
+#pragma warning(default : 4996)
+		if (file == nullptr)
+		{
+			fprintf(stderr, "Failed to open %s for writing.\n", a_filePath);
+			return false;
+		}
+
+		// One result per line, so runs read back in with a line at a time.
+		fprintf(file, "{\n\t\"results\": [\n");
+		for (size_t resultIndex = 0; resultIndex < a_results.size(); ++resultIndex)
+		{
+			const SceneResult& result = a_results[resultIndex];
+			fprintf(file, "\t\t{\"scene\":\"%s\",\"entities\":%zu,\"frames\":%zu,\"ms_per_frame\":%.6f,\"ns_per_entity\":%.4f,\"allocations_per_frame\":%.2f,\"allocated_bytes_per_frame\":%.2f,\"rss_growth_bytes\":%zu}%s\n",
+				result.sceneName,
+				result.entityCount,
+				result.frameCount,
+				result.millisecondsPerFrame,
+				result.nanosecondsPerEntity,
+				result.allocationsPerFrame,
+				result.allocatedBytesPerFrame,
+				result.residentGrowthBytes,
+				resultIndex + 1 < a_results.size() ? "," : "");
+		}
+		fprintf(file, "\t]\n}\n");
+
+		fclose(file);
+		return true;
+	}
+
+	// Read the results of an earlier run, as written above.
+	bool ReadResultsJson(const char* a_filePath, std::vector<SceneResult>& a_results)
+	{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+		FILE* file = fopen(a_filePath, "r");
+#pragma warning(default : 4996)
+		if (file == nullptr)
+		{
+			fprintf(stderr, "Failed to open %s for reading.\n", a_filePath);
+			return false;
+		}
+
+		char line[512] = { '\0' };
+		while (fgets(line, sizeof(line), file) && a_results.size() < MAX_BASELINE_RESULTS)
+		{
+			SceneResult result;
+#pragma warning(disable : 4996) // sscanf unsafe warning.
+			const int fieldCount = sscanf(line, " {\"scene\":\"%31[^\"]\",\"entities\":%zu,\"frames\":%zu,\"ms_per_frame\":%lf,\"ns_per_entity\":%lf,\"allocations_per_frame\":%lf,\"allocated_bytes_per_frame\":%lf,\"rss_growth_bytes\":%zu",
+				result.sceneName,
+				&result.entityCount,
+				&result.frameCount,
+				&result.millisecondsPerFrame,
+				&result.nanosecondsPerEntity,
+				&result.allocationsPerFrame,
+				&result.allocatedBytesPerFrame,
+				&result.residentGrowthBytes);
+#pragma warning(default : 4996)
+			if (fieldCount == 8)
+				a_results.push_back(result);
+		}
+
+		fclose(file);
+		return true;
+	}
+
+	// Print how every scene fared against the same scene and entity count in the baseline.
+	void PrintBaselineComparison(const std::vector<SceneResult>& a_baselineResults, const std::vector<SceneResult>& a_results)
+	{
+		printf("\nAgainst the baseline, negative is better\n");
+		printf("%10s %10s %14s %14s %10s %14s %14s\n", "scene", "entities", "base ns/ent", "ns/entity", "change", "base allocs", "allocs/frame");
+		for (const SceneResult& result : a_results)
+		{
+			const auto baselineIterator = std::find_if(a_baselineResults.begin(), a_baselineResults.end(), [&result](const SceneResult& a_baselineResult)
+			{
+				return strcmp(a_baselineResult.sceneName, result.sceneName) == 0 && a_baselineResult.entityCount == result.entityCount;
+			});
+			if (baselineIterator == a_baselineResults.end())
+				continue;
+
+			const double change = baselineIterator->nanosecondsPerEntity > 0.0 ? (result.nanosecondsPerEntity / baselineIterator->nanosecondsPerEntity - 1.0) * 100.0 : 0.0;
+			printf("%10s %10zu %14.3f %14.3f %9.1f%% %14.1f %14.1f\n",
+				result.sceneName,
+				result.entityCount,
+				baselineIterator->nanosecondsPerEntity,
+				result.nanosecondsPerEntity,
+				change,
+				baselineIterator->allocationsPerFrame,
+				result.allocationsPerFrame);
+		}
+	}
+}
+
+void RunECSBenchmark(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	ParseOptions(argc, argv, options);
+
+	// Bring the engine up without a window, drawing nothing, and clear out the demo scene it loads.
+	Engine& engine = Engine::GetInstanceWrite();
+	engine.SetRenderBackend(RenderBackend::NullBackend);
+	engine.SetRenderThreadEnabled(false);
+	engine.Initialize();
+	TearDownScene();
+
+#ifndef ENGINE_ALLOCATION_COUNTER
+	printf("\nAllocations are not counted, build the Benchmark configuration, which defines ENGINE_ALLOCATION_COUNTER, to count them.\n");
+#endif // ENGINE_ALLOCATION_COUNTER
+	printf("\nECS scenes on the null backend, a %.0f ms step per frame\n", SIMULATION_STEP * 1000.0f);
+	printf("%10s %10s %8s %12s %12s %14s %14s %10s\n", "scene", "entities", "frames", "ms/frame", "ns/entity", "allocs/frame", "KB/frame", "RSS +MB");
+
+	std::vector<SceneResult> results;
+	for (int sceneIndex = 0; sceneIndex < static_cast<int>(SceneKind::SceneCount); ++sceneIndex)
+	{
+		for (const size_t entityCount : ENTITY_COUNTS)
+		{
+			if (entityCount > options.maxEntityCount)
+				continue;
+
+			const SceneResult result = RunScene(static_cast<SceneKind>(sceneIndex), entityCount, options);
+			printf("%10s %10zu %8zu %12.4f %12.3f %14.1f %14.1f %10.1f\n",
+				result.sceneName,
+				result.entityCount,
+				result.frameCount,
+				result.millisecondsPerFrame,
+				result.nanosecondsPerEntity,
+				result.allocationsPerFrame,
+				result.allocatedBytesPerFrame / 1024.0,
+				result.residentGrowthBytes / (1024.0 * 1024.0));
+			results.push_back(result);
+		}
+	}
+
+	WriteResultsJson(options.jsonPath, results);
+
+	std::vector<SceneResult> baselineResults;
+	if (options.baselinePath != nullptr && ReadResultsJson(options.baselinePath, baselineResults))
+		PrintBaselineComparison(baselineResults, results);
+
+	engine.Shutdown();
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// Runs synthetic scenes through the registry, the game's systems and the tile manager on the null render backend, at
+// entity counts from a thousand to a million, and reports the time per entity, the allocations per frame and the resident
+// memory every scene added, measured before its setup and after its frames. Memory an earlier scene freed and this one
+// reused doesn't show in it. Results are written as JSON, and compared against an earlier run when given one.
+//
+// Options, following the benchmark flag on the command line:
+//   --max-entities N   Largest entity count to run, a million by default.
+//   --spacing S        World area per collider in the collision scene, as the edge of a square. Lower is denser.
+//   --json PATH        Where to write the results, ECSBenchmark.json by default.
+//   --baseline PATH    Results of an earlier run to compare against.
+void RunECSBenchmark(int argc, char* argv[]);
@@ -0,0 +1,100 @@
+#include "PCH.h"
+#include "RenderSortBenchmark.h"
+#include "Components\Components.h"
+#include "Rendering\RenderQueue.h"
+#include "Timing.h"
+#include <random>
+
+namespace
+{
+	constexpr int FRAME_COUNT = 100;					// Frames sorted per scene.
+	constexpr int TEXTURE_COUNT = 8;					// Textures the entities are spread over.
+	constexpr float WORLD_HEIGHT = 4096.0f;
+	constexpr float MAX_STEP = 2.0f;					// Largest distance an entity drifts along y per frame.
+
+	// Sort the same drifting entities both ways, and time them.
+	void RunScene(size_t an_entityCount)
+	{
+		std::mt19937 generator(1234);
+		std::uniform_int_distribution<int> orderDistribution(static_cast<int>(RenderOrder::NPCOrder), static_cast<int>(RenderOrder::ProjectileOrder));
+		std::uniform_int_distribution<int> textureDistribution(0, TEXTURE_COUNT - 1);
+		std::uniform_real_distribution<float> yDistribution(0.0f, WORLD_HEIGHT);
+		std::uniform_real_distribution<float> stepDistribution(-MAX_STEP, MAX_STEP);
+
+		// Components indexed by entity, standing in for the registry, which only makes the comparator look cheaper.
+		std::vector<TextureComponent> textureComponents(an_entityCount);
+		std::vector<float> depths(an_entityCount);
+		for (size_t entity = 0; entity < an_entityCount; ++entity)
+		{
+			textureComponents[entity] = { static_cast<TextureId>(textureDistribution(generator)), static_cast<RenderOrder>(orderDistribution(generator)) };
+			depths[entity] = yDistribution(generator);
+		}
+
+		// The culler hands the entities over in no particular order.
+		std::vector<Entity> visibleEntities(an_entityCount);
+		for (size_t entity = 0; entity < an_entityCount; ++entity)
+		{
+			visibleEntities[entity] = entity;
+		}
+		std::shuffle(visibleEntities.begin(), visibleEntities.end(), generator);
+
+		double comparatorMilliseconds = 0.0;
+		double queueMilliseconds = 0.0;
+		size_t incrementalSortCount = 0;
+		std::vector<Entity> sortedEntities;
+		RenderQueue renderQueue;
+		for (int frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			for (float& depth : depths)
+			{
+				depth += stepDistribution(generator);
+			}
+
+			// The comparator sort the render system used to do, looking the components up on every comparison.
+			Uint64 startTicks = SDL_GetPerformanceCounter();
+			sortedEntities.assign(visibleEntities.begin(), visibleEntities.end());
+			std::sort(sortedEntities.begin(), sortedEntities.end(), [&textureComponents, &depths](const Entity entity1, const Entity entity2) -> bool
+			{
+				const TextureComponent& textureComponent1 = textureComponents[entity1];
+				const TextureComponent& textureComponent2 = textureComponents[entity2];
+				if (textureComponent1.renderOrder != textureComponent2.renderOrder)
+					return textureComponent1.renderOrder < textureComponent2.renderOrder;
+				if (textureComponent1.textureId != textureComponent2.textureId)
+					return textureComponent1.textureId < textureComponent2.textureId;
+				if (floorf(depths[entity1]) != floorf(depths[entity2]))
+					return floorf(depths[entity1]) < floorf(depths[entity2]);
+				return entity1 < entity2;
+			});
+			comparatorMilliseconds += MillisecondsSince(startTicks);
+
+			// Look the components up once per entity, and sort the keys.
+			startTicks = SDL_GetPerformanceCounter();
+			renderQueue.Clear();
+			for (const Entity entity : visibleEntities)
+			{
+				renderQueue.Push(RenderQueue::MakeSortKey(textureComponents[entity].renderOrder, static_cast<unsigned int>(textureComponents[entity].textureId), depths[entity], entity), entity);
+			}
+			renderQueue.Sort();
+			queueMilliseconds += MillisecondsSince(startTicks);
+			incrementalSortCount += renderQueue.WasLastSortIncremental() ? 1 : 0;
+		}
+
+		printf("%10zu %16.4f %16.4f %12zu\n",
+			an_entityCount,
+			comparatorMilliseconds / FRAME_COUNT,
+			queueMilliseconds / FRAME_COUNT,
+			incrementalSortCount);
+	}
+}
+
+void RunRenderSortBenchmark()
+{
+	printf("\nRender sort: %d frames of entities drifting up to %.0f pixels\n", FRAME_COUNT, MAX_STEP);
+	printf("%10s %16s %16s %12s\n", "visible", "compare ms/frame", "queue ms/frame", "incremental");
+
+	const size_t entityCounts[] = { 100, 1000, 10000, 100000 };
+	for (const size_t entityCount : entityCounts)
+	{
+		RunScene(entityCount);
+	}
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Times sorting the visible entities into render order with a comparator against the radix sorted render queue, over
+// frames of drifting entities, and prints the results.
+void RunRenderSortBenchmark();
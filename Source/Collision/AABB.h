@@ -0,0 +1,110 @@
+#pragma once
+#include "CollisionLayers.h"
+#include "ECS\Types.h"
+
+// Axis aligned bounding box in world space.
+struct AABB final
+{
+	float minX = 0.0f;		// 4 bytes.
+	float minY = 0.0f;		// 4 bytes.
+	float maxX = 0.0f;		// 4 bytes.
+	float maxY = 0.0f;		// 4 bytes.
+};							// Total = 16 bytes.
+
+// A collider as seen by the broadphase.
+struct BroadphaseProxy final
+{
+	AABB bounds;							// 16 bytes.
+	Entity entity = 0;						// 8 bytes.
+	CollisionFilter filter;					// 4 bytes.
+};											// Total = 32 bytes with padding.
+
+// A pair of proxies whose bounds may overlap, stored as indices into the proxy list the broadphase was updated with.
+// The first index is always the lower one.
+struct BroadphasePair final
+{
+	unsigned int proxyIndex1 = 0;			// 4 bytes.
+	unsigned int proxyIndex2 = 0;			// 4 bytes.
+};											// Total = 8 bytes.
+
+// Check if two boxes overlap. Boxes that merely touch along an edge do not overlap.
+inline bool AABBOverlap(const AABB& a_box1, const AABB& a_box2)
+{
+	return a_box1.minX < a_box2.maxX && a_box2.minX < a_box1.maxX
+		&& a_box1.minY < a_box2.maxY && a_box2.minY < a_box1.maxY;
+}
+
+// The smallest box containing both boxes.
+inline AABB AABBUnion(const AABB& a_box1, const AABB& a_box2)
+{
+	return {
+		a_box1.minX < a_box2.minX ? a_box1.minX : a_box2.minX,
+		a_box1.minY < a_box2.minY ? a_box1.minY : a_box2.minY,
+		a_box1.maxX > a_box2.maxX ? a_box1.maxX : a_box2.maxX,
+		a_box1.maxY > a_box2.maxY ? a_box1.maxY : a_box2.maxY
+	};
+}
+
+// Check if the outer box fully contains the inner box.
+inline bool AABBContains(const AABB& an_outerBox, const AABB& an_innerBox)
+{
+	return an_outerBox.minX <= an_innerBox.minX && an_outerBox.minY <= an_innerBox.minY
+		&& an_innerBox.maxX <= an_outerBox.maxX && an_innerBox.maxY <= an_outerBox.maxY;
+}
+
+// Perimeter of the box, used as the cost metric when building bounding volume hierarchies.
+inline float AABBPerimeter(const AABB& a_box)
+{
+	return 2.0f * ((a_box.maxX - a_box.minX) + (a_box.maxY - a_box.minY));
+}
+
+// Squared distance from a point to the closest point of the box, zero when the point is inside.
+inline float AABBDistanceSquared(const AABB& a_box, float a_x, float a_y)
+{
+	const float distanceX = std::max(std::max(a_box.minX - a_x, a_x - a_box.maxX), 0.0f);
+	const float distanceY = std::max(std::max(a_box.minY - a_y, a_y - a_box.maxY), 0.0f);
+	return distanceX * distanceX + distanceY * distanceY;
+}
+
+// Find when a box moving by the given displacement over a frame first overlaps a static box. To sweep two moving boxes,
+// pass the displacement of the first relative to the second. The time of impact is a fraction of the displacement, and
+// is zero when the boxes overlap from the start.
+inline bool SweepAABB(const AABB& a_movingBox, float a_displacementX, float a_displacementY, const AABB& a_staticBox, float& a_timeOfImpact)
+{
+	float entryTime = -std::numeric_limits<float>::infinity();
+	float exitTime = std::numeric_limits<float>::infinity();
+
+	// Narrow down the interval of time the boxes overlap in, one axis at a time.
+	const float movingMins[2] = { a_movingBox.minX, a_movingBox.minY };
+	const float movingMaxs[2] = { a_movingBox.maxX, a_movingBox.maxY };
+	const float staticMins[2] = { a_staticBox.minX, a_staticBox.minY };
+	const float staticMaxs[2] = { a_staticBox.maxX, a_staticBox.maxY };
+	const float displacements[2] = { a_displacementX, a_displacementY };
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		if (displacements[axis] == 0.0f)
+		{
+			// Not moving along this axis, so the boxes either always or never overlap on it.
+			if (!(movingMins[axis] < staticMaxs[axis] && staticMins[axis] < movingMaxs[axis]))
+				return false;
+
+			continue;
+		}
+
+		const float inverseDisplacement = 1.0f / displacements[axis];
+		float axisEntryTime = (staticMins[axis] - movingMaxs[axis]) * inverseDisplacement;
+		float axisExitTime = (staticMaxs[axis] - movingMins[axis]) * inverseDisplacement;
+		if (axisEntryTime > axisExitTime)
+			std::swap(axisEntryTime, axisExitTime);
+
+		entryTime = std::max(entryTime, axisEntryTime);
+		exitTime = std::min(exitTime, axisExitTime);
+	}
+
+	// Boxes that merely touch don't overlap, and contacts outside the frame don't count.
+	if (entryTime >= exitTime || entryTime >= 1.0f || exitTime <= 0.0f)
+		return false;
+
+	a_timeOfImpact = std::max(entryTime, 0.0f);
+	return true;
+}
@@ -0,0 +1,192 @@
+#include "PCH.h"
+#include "AABBNarrowphase.h"
+#include <immintrin.h>
+
+// MSVC compiles intrinsics of any instruction set, GCC and Clang need the functions using them marked.
+#if defined(__GNUC__)
+#define TARGET_SSE __attribute__((target("sse2")))
+#define TARGET_AVX __attribute__((target("avx")))
+#else
+#define TARGET_SSE
+#define TARGET_AVX
+#endif
+
+namespace
+{
+	// Write out the pairs of a group whose lane is set in the mask. Every pair is stored, but the output only advances
+	// past the overlapping ones, which avoids a hard to predict branch per pair.
+	size_t CompactPairs(const BroadphasePair* a_pairs, size_t a_pairCount, int a_mask, BroadphasePair* an_output)
+	{
+		size_t outputCount = 0;
+		for (size_t lane = 0; lane < a_pairCount; ++lane)
+		{
+			an_output[outputCount] = a_pairs[lane];
+			outputCount += (a_mask >> lane) & 1;
+		}
+
+		return outputCount;
+	}
+
+	size_t TestBatchScalar(const float* a_minX1, const float* a_minY1, const float* a_maxX1, const float* a_maxY1,
+		const float* a_minX2, const float* a_minY2, const float* a_maxX2, const float* a_maxY2,
+		const BroadphasePair* a_pairs, size_t a_pairCount, BroadphasePair* an_output)
+	{
+		size_t outputCount = 0;
+		for (size_t index = 0; index < a_pairCount; ++index)
+		{
+			const bool overlap = (a_minX1[index] < a_maxX2[index]) & (a_minX2[index] < a_maxX1[index])
+				& (a_minY1[index] < a_maxY2[index]) & (a_minY2[index] < a_maxY1[index]);
+
+			an_output[outputCount] = a_pairs[index];
+			outputCount += overlap ? 1 : 0;
+		}
+
+		return outputCount;
+	}
+
+	TARGET_SSE size_t TestBatchSSE(const float* a_minX1, const float* a_minY1, const float* a_maxX1, const float* a_maxY1,
+		const float* a_minX2, const float* a_minY2, const float* a_maxX2, const float* a_maxY2,
+		const BroadphasePair* a_pairs, size_t a_pairCount, BroadphasePair* an_output)
+	{
+		size_t outputCount = 0;
+		for (size_t index = 0; index < a_pairCount; index += 4)
+		{
+			const __m128 overlapX = _mm_and_ps(
+				_mm_cmplt_ps(_mm_loadu_ps(a_minX1 + index), _mm_loadu_ps(a_maxX2 + index)),
+				_mm_cmplt_ps(_mm_loadu_ps(a_minX2 + index), _mm_loadu_ps(a_maxX1 + index)));
+			const __m128 overlapY = _mm_and_ps(
+				_mm_cmplt_ps(_mm_loadu_ps(a_minY1 + index), _mm_loadu_ps(a_maxY2 + index)),
+				_mm_cmplt_ps(_mm_loadu_ps(a_minY2 + index), _mm_loadu_ps(a_maxY1 + index)));
+			const int mask = _mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+
+			const size_t laneCount = std::min<size_t>(4, a_pairCount - index);
+			outputCount += CompactPairs(a_pairs + index, laneCount, mask, an_output + outputCount);
+		}
+
+		return outputCount;
+	}
+
+	TARGET_AVX size_t TestBatchAVX(const float* a_minX1, const float* a_minY1, const float* a_maxX1, const float* a_maxY1,
+		const float* a_minX2, const float* a_minY2, const float* a_maxX2, const float* a_maxY2,
+		const BroadphasePair* a_pairs, size_t a_pairCount, BroadphasePair* an_output)
+	{
+		size_t outputCount = 0;
+		for (size_t index = 0; index < a_pairCount; index += 8)
+		{
+			const __m256 overlapX = _mm256_and_ps(
+				_mm256_cmp_ps(_mm256_loadu_ps(a_minX1 + index), _mm256_loadu_ps(a_maxX2 + index), _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(a_minX2 + index), _mm256_loadu_ps(a_maxX1 + index), _CMP_LT_OQ));
+			const __m256 overlapY = _mm256_and_ps(
+				_mm256_cmp_ps(_mm256_loadu_ps(a_minY1 + index), _mm256_loadu_ps(a_maxY2 + index), _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(a_minY2 + index), _mm256_loadu_ps(a_maxY1 + index), _CMP_LT_OQ));
+			const int mask = _mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY));
+
+			const size_t laneCount = std::min<size_t>(8, a_pairCount - index);
+			outputCount += CompactPairs(a_pairs + index, laneCount, mask, an_output + outputCount);
+		}
+
+		return outputCount;
+	}
+}
+
+AABBNarrowphase::AABBNarrowphase()
+	: m_batch(std::make_unique<PairBatch>())
+{
+	if (IsInstructionSetSupported(InstructionSet::AVXInstructions))
+		m_instructionSet = InstructionSet::AVXInstructions;
+	else if (IsInstructionSetSupported(InstructionSet::SSEInstructions))
+		m_instructionSet = InstructionSet::SSEInstructions;
+}
+
+void AABBNarrowphase::TestPairs(const std::vector<BroadphaseProxy>& a_proxies, const std::vector<BroadphasePair>& a_candidatePairs, std::vector<BroadphasePair>& an_overlappingPairs)
+{
+	// Make room for every candidate overlapping, and trim the output to the actual count at the end.
+	const size_t outputStart = an_overlappingPairs.size();
+	an_overlappingPairs.resize(outputStart + a_candidatePairs.size());
+	BroadphasePair* const output = an_overlappingPairs.data() + outputStart;
+	size_t outputCount = 0;
+
+	const PairBatch& batch = *m_batch;
+	const BroadphasePair* const pairs = batch.pairs;
+	size_t candidateIndex = 0;
+	while (candidateIndex < a_candidatePairs.size())
+	{
+		const size_t pairCount = GatherBatch(a_proxies, a_candidatePairs, candidateIndex);
+
+		switch (m_instructionSet)
+		{
+		case InstructionSet::AVXInstructions:
+			outputCount += TestBatchAVX(batch.minX1, batch.minY1, batch.maxX1, batch.maxY1, batch.minX2, batch.minY2, batch.maxX2, batch.maxY2,
+				pairs, pairCount, output + outputCount);
+			break;
+		case InstructionSet::SSEInstructions:
+			outputCount += TestBatchSSE(batch.minX1, batch.minY1, batch.maxX1, batch.maxY1, batch.minX2, batch.minY2, batch.maxX2, batch.maxY2,
+				pairs, pairCount, output + outputCount);
+			break;
+		default:
+			outputCount += TestBatchScalar(batch.minX1, batch.minY1, batch.maxX1, batch.maxY1, batch.minX2, batch.minY2, batch.maxX2, batch.maxY2,
+				pairs, pairCount, output + outputCount);
+			break;
+		}
+	}
+
+	an_overlappingPairs.resize(outputStart + outputCount);
+}
+
+bool AABBNarrowphase::IsInstructionSetSupported(InstructionSet an_instructionSet)
+{
+	switch (an_instructionSet)
+	{
+	case InstructionSet::AVXInstructions:
+		return SDL_HasAVX() == SDL_TRUE;
+	case InstructionSet::SSEInstructions:
+		return SDL_HasSSE2() == SDL_TRUE;
+	default:
+		return true;
+	}
+}
+
+void AABBNarrowphase::SetInstructionSet(InstructionSet an_instructionSet)
+{
+	assert(IsInstructionSetSupported(an_instructionSet) && "The CPU doesn't support this instruction set.");
+	m_instructionSet = an_instructionSet;
+}
+
+size_t AABBNarrowphase::GatherBatch(const std::vector<BroadphaseProxy>& a_proxies, const std::vector<BroadphasePair>& a_candidatePairs, size_t& a_candidateIndex)
+{
+	// Fill the batch with the next candidates whose layers interact, the others are dropped before any geometry test.
+	PairBatch& batch = *m_batch;
+	size_t pairCount = 0;
+	for (; a_candidateIndex < a_candidatePairs.size() && pairCount < BATCH_SIZE; ++a_candidateIndex)
+	{
+		const BroadphasePair& candidatePair = a_candidatePairs[a_candidateIndex];
+		const BroadphaseProxy& proxy1 = a_proxies[candidatePair.proxyIndex1];
+		const BroadphaseProxy& proxy2 = a_proxies[candidatePair.proxyIndex2];
+		if (!CollisionFiltersInteract(proxy1.filter, proxy2.filter))
+			continue;
+
+		const AABB& bounds1 = proxy1.bounds;
+		const AABB& bounds2 = proxy2.bounds;
+		const size_t index = pairCount++;
+
+		batch.pairs[index] = candidatePair;
+		batch.minX1[index] = bounds1.minX;
+		batch.minY1[index] = bounds1.minY;
+		batch.maxX1[index] = bounds1.maxX;
+		batch.maxY1[index] = bounds1.maxY;
+		batch.minX2[index] = bounds2.minX;
+		batch.minY2[index] = bounds2.minY;
+		batch.maxX2[index] = bounds2.maxX;
+		batch.maxY2[index] = bounds2.maxY;
+	}
+
+	// Pad the last group of lanes with boxes that never overlap, so the vector tests can read whole groups.
+	const size_t paddedCount = (pairCount + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+	for (size_t index = pairCount; index < paddedCount; ++index)
+	{
+		batch.minX1[index] = batch.minY1[index] = batch.maxX1[index] = batch.maxY1[index] = 1.0f;
+		batch.minX2[index] = batch.minY2[index] = batch.maxX2[index] = batch.maxY2[index] = 0.0f;
+	}
+
+	return pairCount;
+}
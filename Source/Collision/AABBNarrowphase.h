@@ -0,0 +1,55 @@
+#pragma once
+#include "PCH.h"
+#include "AABB.h"
+
+// Exact overlap test of the candidate pairs found by a broadphase. Pairs are processed in batches: pairs on layers that
+// don't interact are dropped, the bounds of the others gathered into structure of arrays form, tested several pairs per
+// instruction, and the overlapping ones written out compactly.
+class AABBNarrowphase final
+{
+public:
+	// Widest instructions the pair tests may use.
+	enum class InstructionSet : unsigned char
+	{
+		ScalarInstructions = 0,
+		SSEInstructions,
+		AVXInstructions
+	};
+
+	// Picks the widest instruction set the CPU supports.
+	AABBNarrowphase();
+	~AABBNarrowphase() = default;
+
+	// Append the candidate pairs whose proxies overlap and whose collision filters interact, keeping their order.
+	void TestPairs(const std::vector<BroadphaseProxy>& a_proxies, const std::vector<BroadphasePair>& a_candidatePairs, std::vector<BroadphasePair>& an_overlappingPairs);
+
+	static bool IsInstructionSetSupported(InstructionSet an_instructionSet);
+	void SetInstructionSet(InstructionSet an_instructionSet);
+	InstructionSet GetInstructionSet() const { return m_instructionSet; }
+
+private:
+	static constexpr size_t BATCH_SIZE = 256;		// Pairs gathered at once, small enough for the batch to stay in L1.
+	static constexpr size_t LANE_COUNT = 8;			// Pairs tested per instruction at the widest.
+
+	// A batch of pairs, and their bounds with one array per extent. Bounds are padded to a whole number of lanes.
+	struct PairBatch final
+	{
+		BroadphasePair pairs[BATCH_SIZE];
+		float minX1[BATCH_SIZE];
+		float minY1[BATCH_SIZE];
+		float maxX1[BATCH_SIZE];
+		float maxY1[BATCH_SIZE];
+		float minX2[BATCH_SIZE];
+		float minY2[BATCH_SIZE];
+		float maxX2[BATCH_SIZE];
+		float maxY2[BATCH_SIZE];
+	};
+
+	// Gather the next batch of pairs starting at the candidate index, and advance the index past them. Returns the
+	// number of pairs in the batch.
+	size_t GatherBatch(const std::vector<BroadphaseProxy>& a_proxies, const std::vector<BroadphasePair>& a_candidatePairs, size_t& a_candidateIndex);
+
+private:
+	InstructionSet m_instructionSet = InstructionSet::ScalarInstructions;
+	std::unique_ptr<PairBatch> m_batch;
+};
@@ -0,0 +1,88 @@
+#include "PCH.h"
+#include "CollisionDetector.h"
+#include "Jobs\JobPool.h"
+
+CollisionDetector::CollisionDetector(std::unique_ptr<IBroadphase> a_broadphase)
+	: m_broadphase(std::move(a_broadphase))
+{
+}
+
+void CollisionDetector::DetectCollisions(const std::vector<BroadphaseProxy>& a_proxies, const std::vector<unsigned char>& a_proxyIsSwept, JobPool* a_jobPool)
+{
+	// Updating the broadphase mutates shared structures, so it stays on the calling thread.
+	m_broadphase->Update(a_proxies);
+
+	// Give every thread its own narrowphase, as they keep their batch between calls.
+	const unsigned int threadCount = a_jobPool ? a_jobPool->GetThreadCount() : 1;
+	while (m_narrowphases.size() < threadCount)
+	{
+		m_narrowphases.push_back(std::make_unique<AABBNarrowphase>());
+	}
+
+	// Query and test the partitions in parallel.
+	const size_t partitionCount = m_broadphase->PreparePartitions(threadCount);
+	if (m_partitionPairs.size() < partitionCount)
+		m_partitionPairs.resize(partitionCount);
+
+	if (a_jobPool)
+	{
+		a_jobPool->ParallelFor(partitionCount, [this, &a_proxies, &a_proxyIsSwept](size_t a_partitionIndex, unsigned int a_threadIndex)
+		{
+			DetectPartitionCollisions(a_partitionIndex, a_threadIndex, a_proxies, a_proxyIsSwept);
+		});
+	}
+	else
+	{
+		for (size_t partitionIndex = 0; partitionIndex < partitionCount; ++partitionIndex)
+		{
+			DetectPartitionCollisions(partitionIndex, 0, a_proxies, a_proxyIsSwept);
+		}
+	}
+
+	// Merge the partitions. Which partition a pair lands in depends on the thread count, so sort the pairs to keep the
+	// output, and everything reacting to it, the same however many threads ran.
+	m_collidingPairs.clear();
+	m_sweptPairs.clear();
+	for (size_t partitionIndex = 0; partitionIndex < partitionCount; ++partitionIndex)
+	{
+		const PartitionPairs& partitionPairs = m_partitionPairs[partitionIndex];
+		m_collidingPairs.insert(m_collidingPairs.end(), partitionPairs.collidingPairs.begin(), partitionPairs.collidingPairs.end());
+		m_sweptPairs.insert(m_sweptPairs.end(), partitionPairs.sweptPairs.begin(), partitionPairs.sweptPairs.end());
+	}
+
+	SortPairs(m_collidingPairs);
+	SortPairs(m_sweptPairs);
+}
+
+void CollisionDetector::DetectPartitionCollisions(size_t a_partitionIndex, unsigned int a_threadIndex, const std::vector<BroadphaseProxy>& a_proxies, const std::vector<unsigned char>& a_proxyIsSwept)
+{
+	PartitionPairs& partitionPairs = m_partitionPairs[a_partitionIndex];
+	partitionPairs.candidatePairs.clear();
+	partitionPairs.collidingPairs.clear();
+	partitionPairs.sweptPairs.clear();
+
+	m_broadphase->QueryPartitionPairs(a_partitionIndex, partitionPairs.candidatePairs);
+
+	// Move the pairs with a swept proxy out of the candidates.
+	size_t candidateCount = 0;
+	for (const BroadphasePair& candidatePair : partitionPairs.candidatePairs)
+	{
+		if (a_proxyIsSwept[candidatePair.proxyIndex1] || a_proxyIsSwept[candidatePair.proxyIndex2])
+			partitionPairs.sweptPairs.push_back(candidatePair);
+		else
+			partitionPairs.candidatePairs[candidateCount++] = candidatePair;
+	}
+
+	partitionPairs.candidatePairs.resize(candidateCount);
+	m_narrowphases[a_threadIndex]->TestPairs(a_proxies, partitionPairs.candidatePairs, partitionPairs.collidingPairs);
+}
+
+void CollisionDetector::SortPairs(std::vector<BroadphasePair>& a_pairs)
+{
+	std::sort(a_pairs.begin(), a_pairs.end(), [](const BroadphasePair& a_pair1, const BroadphasePair& a_pair2)
+	{
+		if (a_pair1.proxyIndex1 != a_pair2.proxyIndex1)
+			return a_pair1.proxyIndex1 < a_pair2.proxyIndex1;
+		return a_pair1.proxyIndex2 < a_pair2.proxyIndex2;
+	});
+}
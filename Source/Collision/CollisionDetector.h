@@ -0,0 +1,50 @@
+#pragma once
+#include "PCH.h"
+#include "AABB.h"
+#include "AABBNarrowphase.h"
+#include "IBroadphase.h"
+#include "Macros.h"
+
+class JobPool;
+
+// Runs the broadphase and narrowphase over a set of proxies, spreading the pair queries and exact tests across a job
+// pool. The broadphase splits its pairs into partitions, each thread collects and tests the pairs of the partitions it
+// picks up, and the results are merged and sorted, so the output doesn't depend on the number of threads.
+class CollisionDetector final
+{
+public:
+	NO_COPY(CollisionDetector);
+	NO_MOVE(CollisionDetector);
+
+	CollisionDetector(std::unique_ptr<IBroadphase> a_broadphase);
+	~CollisionDetector() = default;
+
+	// Find the pairs of proxies that collide. Pairs with a proxy flagged as swept are set aside untested, for a swept
+	// test over the frame. Runs on the calling thread alone when no job pool is given.
+	void DetectCollisions(const std::vector<BroadphaseProxy>& a_proxies, const std::vector<unsigned char>& a_proxyIsSwept, JobPool* a_jobPool);
+
+	// Pairs found by the last detection, sorted by proxy indices.
+	const std::vector<BroadphasePair>& GetCollidingPairsRead() const { return m_collidingPairs; }
+	const std::vector<BroadphasePair>& GetSweptPairsRead() const { return m_sweptPairs; }
+
+	const IBroadphase& GetBroadphaseRead() const { return *m_broadphase; }
+
+private:
+	// Pairs found within one broadphase partition.
+	struct PartitionPairs final
+	{
+		std::vector<BroadphasePair> candidatePairs;		// Pairs the broadphase found close.
+		std::vector<BroadphasePair> collidingPairs;		// Candidate pairs whose proxies overlap.
+		std::vector<BroadphasePair> sweptPairs;			// Candidate pairs with a swept proxy.
+	};
+
+	void DetectPartitionCollisions(size_t a_partitionIndex, unsigned int a_threadIndex, const std::vector<BroadphaseProxy>& a_proxies, const std::vector<unsigned char>& a_proxyIsSwept);
+	static void SortPairs(std::vector<BroadphasePair>& a_pairs);
+
+private:
+	std::unique_ptr<IBroadphase> m_broadphase;			// Spatial partition producing the candidate pairs to test.
+	std::vector<PartitionPairs> m_partitionPairs;		// Pairs of each broadphase partition, kept to reuse their memory.
+	std::vector<std::unique_ptr<AABBNarrowphase>> m_narrowphases;	// Exact test of the candidate pairs, one per thread.
+	std::vector<BroadphasePair> m_collidingPairs;		// Candidate pairs whose proxies overlap.
+	std::vector<BroadphasePair> m_sweptPairs;			// Candidate pairs with a swept proxy, which need the swept test.
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include "Enums\Enums.h"
+
+constexpr size_t COLLISION_LAYER_COUNT = 16;
+using CollisionLayerMask = unsigned short;
+constexpr CollisionLayerMask ALL_COLLISION_LAYERS = 0xFFFF;
+
+inline CollisionLayerMask GetCollisionLayerBit(CollisionLayer a_layer)
+{
+	return static_cast<CollisionLayerMask>(1u << static_cast<unsigned int>(a_layer));
+}
+
+// The layer of a collider, and the layers it collides with.
+struct CollisionFilter final
+{
+	CollisionLayerMask layerBit = 1;							// 2 bytes.
+	CollisionLayerMask collisionMask = ALL_COLLISION_LAYERS;	// 2 bytes.
+};																// Total = 4 bytes.
+
+// Two colliders interact only if each one collides with the layer of the other. Masks and layer bits may also be the
+// union over a group of colliders, in which case a false result rules out every pair across the groups.
+inline bool CollisionFiltersInteract(const CollisionFilter& a_filter1, const CollisionFilter& a_filter2)
+{
+	return (a_filter1.collisionMask & a_filter2.layerBit) != 0 && (a_filter2.collisionMask & a_filter1.layerBit) != 0;
+}
+
+// Symmetric table of which collision layers interact. Every layer interacts with every layer by default.
+class CollisionLayerMatrix final
+{
+public:
+	CollisionLayerMatrix()
+	{
+		for (CollisionLayerMask& row : m_rows)
+		{
+			row = ALL_COLLISION_LAYERS;
+		}
+	}
+
+	void SetLayersInteract(CollisionLayer a_layer1, CollisionLayer a_layer2, bool an_interact)
+	{
+		const unsigned int layerIndex1 = static_cast<unsigned int>(a_layer1);
+		const unsigned int layerIndex2 = static_cast<unsigned int>(a_layer2);
+		assert(layerIndex1 < COLLISION_LAYER_COUNT && layerIndex2 < COLLISION_LAYER_COUNT && "Collision layer out of range.");
+
+		if (an_interact)
+		{
+			m_rows[layerIndex1] |= GetCollisionLayerBit(a_layer2);
+			m_rows[layerIndex2] |= GetCollisionLayerBit(a_layer1);
+		}
+		else
+		{
+			m_rows[layerIndex1] &= ~GetCollisionLayerBit(a_layer2);
+			m_rows[layerIndex2] &= ~GetCollisionLayerBit(a_layer1);
+		}
+	}
+
+	// Make a layer interact with no layer at all, to whitelist its interactions afterwards.
+	void ClearLayer(CollisionLayer a_layer)
+	{
+		for (size_t layerIndex = 0; layerIndex < COLLISION_LAYER_COUNT; ++layerIndex)
+		{
+			SetLayersInteract(a_layer, static_cast<CollisionLayer>(layerIndex), false);
+		}
+	}
+
+	bool DoLayersInteract(CollisionLayer a_layer1, CollisionLayer a_layer2) const
+	{
+		return (GetLayerMask(a_layer1) & GetCollisionLayerBit(a_layer2)) != 0;
+	}
+
+	CollisionLayerMask GetLayerMask(CollisionLayer a_layer) const
+	{
+		return m_rows[static_cast<unsigned int>(a_layer)];
+	}
+
+private:
+	CollisionLayerMask m_rows[COLLISION_LAYER_COUNT];	// Layers every layer interacts with.
+};
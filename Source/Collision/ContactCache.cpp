@@ -0,0 +1,141 @@
+#include "PCH.h"
+#include "ContactCache.h"
+
+ContactCache::ContactCache()
+	: m_slots(MIN_CAPACITY)
+{
+}
+
+bool ContactCache::TouchContact(Entity an_entity1, Entity an_entity2)
+{
+	const uint64_t pairKey = GetPairKey(an_entity1, an_entity2);
+	const size_t slotMask = m_slots.size() - 1;
+
+	// Probe for the contact, and refresh its stamp if it's there.
+	for (size_t slotIndex = GetHomeSlot(pairKey); m_slots[slotIndex].pairKey != EMPTY_PAIR_KEY; slotIndex = (slotIndex + 1) & slotMask)
+	{
+		ContactSlot& slot = m_slots[slotIndex];
+		if (slot.pairKey == pairKey)
+		{
+			if (slot.frameStamp != m_frameStamp)
+			{
+				slot.frameStamp = m_frameStamp;
+				++m_touchedCount;
+			}
+			return false;
+		}
+	}
+
+	// Keep the table at most half full, so probes stay short.
+	if ((m_contactCount + 1) * 2 > m_slots.size())
+	{
+		std::vector<ContactPair> unusedContacts;
+		RebuildTable(m_slots.size() * 2, [](const ContactSlot&) { return false; }, unusedContacts);
+	}
+
+	InsertContact(pairKey, m_frameStamp);
+	++m_contactCount;
+	++m_touchedCount;
+	return true;
+}
+
+void ContactCache::EndFrame(std::vector<ContactPair>& an_endedContacts)
+{
+	// Only sweep the table if some contact wasn't touched, quiet frames cost nothing.
+	if (m_touchedCount < m_contactCount)
+	{
+		const unsigned int frameStamp = m_frameStamp;
+		RebuildTable(m_slots.size(), [frameStamp](const ContactSlot& a_slot) { return a_slot.frameStamp != frameStamp; }, an_endedContacts);
+	}
+
+	++m_frameStamp;
+	m_touchedCount = 0;
+}
+
+void ContactCache::RemoveEntityContacts(const std::vector<Entity>& an_entities, std::vector<ContactPair>& an_endedContacts)
+{
+	if (an_entities.empty() || m_contactCount == 0)
+		return;
+
+	// Flag the entities, and drop all of their contacts in a single sweep.
+	for (const Entity entity : an_entities)
+	{
+		if (entity >= m_isEntityRemoved.size())
+			m_isEntityRemoved.resize(entity + 1, 0);
+		m_isEntityRemoved[entity] = 1;
+	}
+
+	const std::vector<unsigned char>& isEntityRemoved = m_isEntityRemoved;
+	const unsigned int frameStamp = m_frameStamp;
+	size_t removedTouchedCount = 0;
+	RebuildTable(m_slots.size(), [&isEntityRemoved, frameStamp, &removedTouchedCount](const ContactSlot& a_slot)
+	{
+		const ContactPair contactPair = GetContactPair(a_slot.pairKey);
+		const bool isRemoved = (contactPair.entity1 < isEntityRemoved.size() && isEntityRemoved[contactPair.entity1])
+			|| (contactPair.entity2 < isEntityRemoved.size() && isEntityRemoved[contactPair.entity2]);
+		removedTouchedCount += isRemoved && a_slot.frameStamp == frameStamp ? 1 : 0;
+		return isRemoved;
+	}, an_endedContacts);
+	m_touchedCount -= removedTouchedCount;
+
+	for (const Entity entity : an_entities)
+	{
+		m_isEntityRemoved[entity] = 0;
+	}
+}
+
+uint64_t ContactCache::GetPairKey(Entity an_entity1, Entity an_entity2)
+{
+	// Each entity takes one half of the key, so larger ids would collide with other pairs.
+	assert(an_entity1 <= UINT32_MAX && an_entity2 <= UINT32_MAX && "Entity ids must fit in 32 bits to key a pair.");
+	return an_entity1 < an_entity2
+		? static_cast<uint64_t>(an_entity1) << 32 | an_entity2
+		: static_cast<uint64_t>(an_entity2) << 32 | an_entity1;
+}
+
+ContactCache::ContactPair ContactCache::GetContactPair(uint64_t a_pairKey)
+{
+	return { static_cast<Entity>(a_pairKey >> 32), static_cast<Entity>(a_pairKey & 0xFFFFFFFFull) };
+}
+
+size_t ContactCache::GetHomeSlot(uint64_t a_pairKey) const
+{
+	// Fibonacci hashing, the high bits of the product are well mixed even for keys of nearby entities.
+	return static_cast<size_t>((a_pairKey * 0x9E3779B97F4A7C15ull) >> 32) & (m_slots.size() - 1);
+}
+
+void ContactCache::InsertContact(uint64_t a_pairKey, unsigned int a_frameStamp)
+{
+	const size_t slotMask = m_slots.size() - 1;
+	size_t slotIndex = GetHomeSlot(a_pairKey);
+	while (m_slots[slotIndex].pairKey != EMPTY_PAIR_KEY)
+	{
+		slotIndex = (slotIndex + 1) & slotMask;
+	}
+
+	m_slots[slotIndex] = { a_pairKey, a_frameStamp };
+}
+
+template<typename TPredicate>
+void ContactCache::RebuildTable(size_t a_capacity, TPredicate a_isContactEnded, std::vector<ContactPair>& an_endedContacts)
+{
+	// Move the contacts over to a fresh table, leaving the ended ones behind.
+	m_rebuildSlots.assign(a_capacity, ContactSlot());
+	m_slots.swap(m_rebuildSlots);
+	m_contactCount = 0;
+
+	for (const ContactSlot& slot : m_rebuildSlots)
+	{
+		if (slot.pairKey == EMPTY_PAIR_KEY)
+			continue;
+
+		if (a_isContactEnded(slot))
+		{
+			an_endedContacts.push_back(GetContactPair(slot.pairKey));
+			continue;
+		}
+
+		InsertContact(slot.pairKey, slot.frameStamp);
+		++m_contactCount;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "PCH.h"
+#include "ECS\Types.h"
+
+// Pairs of entities in contact, kept across frames so that only the contacts starting and ending are reported. Contacts
+// live in an open addressing hash table with linear probing, each stamped with the last frame it was touched in.
+// Contacts are only ever removed in bulk, by rebuilding the table without them, so the table needs no tombstones.
+class ContactCache final
+{
+public:
+	// A pair of entities in contact. The first entity is always the lower one.
+	struct ContactPair final
+	{
+		Entity entity1 = 0;				// 8 bytes.
+		Entity entity2 = 0;				// 8 bytes.
+	};									// Total = 16 bytes.
+
+	ContactCache();
+	~ContactCache() = default;
+
+	// Record that the entities are touching this frame. Returns true if they weren't touching before.
+	bool TouchContact(Entity an_entity1, Entity an_entity2);
+
+	// Remove the contacts that weren't touched this frame, append them to the ended contacts, and start a new frame.
+	void EndFrame(std::vector<ContactPair>& an_endedContacts);
+
+	// Remove every contact of the given entities at once, and append them to the ended contacts. Destroyed entities must
+	// be removed before their ids are recycled, or the contacts of the new entities would look ongoing.
+	void RemoveEntityContacts(const std::vector<Entity>& an_entities, std::vector<ContactPair>& an_endedContacts);
+
+	size_t GetContactCount() const { return m_contactCount; }
+
+private:
+	static constexpr uint64_t EMPTY_PAIR_KEY = ~0ull;	// Never a valid key, as the first entity is the lower one.
+	static constexpr size_t MIN_CAPACITY = 64;			// Starting slot count, always a power of two.
+
+	// A slot of the hash table.
+	struct ContactSlot final
+	{
+		uint64_t pairKey = EMPTY_PAIR_KEY;	// 8 bytes. Both entities, the lower one in the high half.
+		unsigned int frameStamp = 0;		// 4 bytes. Last frame the contact was touched in.
+	};										// Total = 16 bytes with padding.
+
+	static uint64_t GetPairKey(Entity an_entity1, Entity an_entity2);
+	static ContactPair GetContactPair(uint64_t a_pairKey);
+	size_t GetHomeSlot(uint64_t a_pairKey) const;
+
+	// Insert a contact known not to be in the table.
+	void InsertContact(uint64_t a_pairKey, unsigned int a_frameStamp);
+
+	// Rebuild the table with the given slot count, leaving out the contacts the predicate flags and appending them to
+	// the ended contacts.
+	template<typename TPredicate> void RebuildTable(size_t a_capacity, TPredicate a_isContactEnded, std::vector<ContactPair>& an_endedContacts);
+
+private:
+	std::vector<ContactSlot> m_slots;			// The hash table, its size a power of two.
+	std::vector<ContactSlot> m_rebuildSlots;	// Table being rebuilt, kept to reuse its memory.
+	std::vector<unsigned char> m_isEntityRemoved;	// Entities whose contacts are being removed, indexed by entity.
+	size_t m_contactCount = 0;
+	size_t m_touchedCount = 0;					// Contacts touched this frame.
+	unsigned int m_frameStamp = 1;
+};
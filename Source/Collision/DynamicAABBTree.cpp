@@ -0,0 +1,417 @@
+#include "PCH.h"
+#include "DynamicAABBTree.h"
+
+DynamicAABBTree::DynamicAABBTree(float a_fatMargin)
+	: m_fatMargin(a_fatMargin)
+{
+	assert(a_fatMargin >= 0.0f && "The fat margin can't be negative.");
+}
+
+void DynamicAABBTree::Update(const std::vector<BroadphaseProxy>& a_proxies)
+{
+	++m_updateStamp;
+
+	// Insert new proxies, and reinsert the ones that moved out of their fat bounds. Proxies still inside their fat bounds
+	// leave the tree untouched.
+	m_proxyBounds.resize(a_proxies.size());
+	for (size_t proxyIndex = 0; proxyIndex < a_proxies.size(); ++proxyIndex)
+	{
+		const BroadphaseProxy& proxy = a_proxies[proxyIndex];
+		if (proxy.entity >= m_entityLeaves.size())
+		{
+			m_entityLeaves.resize(proxy.entity * 2 + 1, NULL_NODE);
+			m_entityStamps.resize(proxy.entity * 2 + 1, 0);
+		}
+
+		// Internal nodes hold the union of the filters below them, so a leaf changing filter is reinserted as well.
+		int leaf = m_entityLeaves[proxy.entity];
+		if (leaf == NULL_NODE)
+		{
+			leaf = AllocateNode();
+			m_nodes[leaf].bounds = FattenBounds(proxy.bounds);
+			m_nodes[leaf].filter = proxy.filter;
+			InsertLeaf(leaf);
+			m_entityLeaves[proxy.entity] = leaf;
+			m_liveEntities.push_back(proxy.entity);
+		}
+		else if (!AABBContains(m_nodes[leaf].bounds, proxy.bounds)
+			|| m_nodes[leaf].filter.layerBit != proxy.filter.layerBit
+			|| m_nodes[leaf].filter.collisionMask != proxy.filter.collisionMask)
+		{
+			RemoveLeaf(leaf);
+			m_nodes[leaf].bounds = FattenBounds(proxy.bounds);
+			m_nodes[leaf].filter = proxy.filter;
+			InsertLeaf(leaf);
+		}
+
+		m_nodes[leaf].proxyIndex = static_cast<unsigned int>(proxyIndex);
+		m_entityStamps[proxy.entity] = m_updateStamp;
+		m_proxyBounds[proxyIndex] = proxy.bounds;
+	}
+
+	// Remove the entities that no longer have a proxy.
+	for (size_t index = 0; index < m_liveEntities.size();)
+	{
+		const Entity entity = m_liveEntities[index];
+		if (m_entityStamps[entity] == m_updateStamp)
+		{
+			++index;
+			continue;
+		}
+
+		const int leaf = m_entityLeaves[entity];
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+		m_entityLeaves[entity] = NULL_NODE;
+
+		// Swap and pop, the order of the live entities doesn't matter.
+		m_liveEntities[index] = m_liveEntities.back();
+		m_liveEntities.pop_back();
+	}
+}
+
+void DynamicAABBTree::QueryPairs(std::vector<BroadphasePair>& a_pairs) const
+{
+	if (m_rootNode == NULL_NODE)
+		return;
+
+	// Collide the tree with itself. A node paired with itself stands for the pairs within its subtree, two distinct nodes
+	// for the pairs across their subtrees. Descending both sides at once visits far fewer nodes, and far more coherently,
+	// than querying the tree once per proxy.
+	m_queryStack.clear();
+	m_queryStack.push_back({ m_rootNode, m_rootNode });
+	CollideNodePairs(m_queryStack, a_pairs);
+}
+
+size_t DynamicAABBTree::PreparePartitions(size_t a_desiredPartitionCount)
+{
+	m_partitionNodePairs.clear();
+	if (m_rootNode == NULL_NODE)
+		return 0;
+
+	// Expand the self collision breadth first until there are a few node pairs per partition, so that uneven subtrees
+	// still balance out between threads. Leaf pairs are kept as they are, so expanding never reports a pair.
+	const size_t targetCount = a_desiredPartitionCount * PARTITIONS_PER_THREAD;
+	m_partitionNodePairs.push_back({ m_rootNode, m_rootNode });
+
+	bool isExpanding = true;
+	while (isExpanding && m_partitionNodePairs.size() < targetCount)
+	{
+		isExpanding = false;
+		m_expandedNodePairs.clear();
+		for (const NodePair& nodePair : m_partitionNodePairs)
+		{
+			if (nodePair.node1 != nodePair.node2 && IsLeaf(nodePair.node1) && IsLeaf(nodePair.node2))
+			{
+				m_expandedNodePairs.push_back(nodePair);
+				continue;
+			}
+
+			ExpandNodePair(nodePair, m_expandedNodePairs, m_unusedPairs);
+			isExpanding = true;
+		}
+		m_partitionNodePairs.swap(m_expandedNodePairs);
+	}
+
+	// Partitions are queried from several threads at once, so each gets its own stack.
+	if (m_partitionStacks.size() < m_partitionNodePairs.size())
+		m_partitionStacks.resize(m_partitionNodePairs.size());
+
+	return m_partitionNodePairs.size();
+}
+
+void DynamicAABBTree::QueryPartitionPairs(size_t a_partitionIndex, std::vector<BroadphasePair>& a_pairs) const
+{
+	std::vector<NodePair>& stack = m_partitionStacks[a_partitionIndex];
+	stack.clear();
+	stack.push_back(m_partitionNodePairs[a_partitionIndex]);
+	CollideNodePairs(stack, a_pairs);
+}
+
+void DynamicAABBTree::CollideNodePairs(std::vector<NodePair>& a_stack, std::vector<BroadphasePair>& a_pairs) const
+{
+	while (!a_stack.empty())
+	{
+		const NodePair nodePair = a_stack.back();
+		a_stack.pop_back();
+		ExpandNodePair(nodePair, a_stack, a_pairs);
+	}
+}
+
+void DynamicAABBTree::ExpandNodePair(const NodePair& a_nodePair, std::vector<NodePair>& a_nodePairs, std::vector<BroadphasePair>& a_pairs) const
+{
+	const TreeNode& node1 = m_nodes[a_nodePair.node1];
+	const TreeNode& node2 = m_nodes[a_nodePair.node2];
+
+	// Skip subtrees with no pair of layers that interact, before looking at their bounds.
+	if (!CollisionFiltersInteract(node1.filter, node2.filter))
+		return;
+
+	// Pairs within a subtree are the pairs within each child, plus the pairs across them.
+	if (a_nodePair.node1 == a_nodePair.node2)
+	{
+		if (!IsLeaf(a_nodePair.node1))
+		{
+			a_nodePairs.push_back({ node1.child1, node1.child2 });
+			a_nodePairs.push_back({ node1.child1, node1.child1 });
+			a_nodePairs.push_back({ node1.child2, node1.child2 });
+		}
+		return;
+	}
+
+	if (!AABBOverlap(node1.bounds, node2.bounds))
+		return;
+
+	const bool isLeaf1 = IsLeaf(a_nodePair.node1);
+	const bool isLeaf2 = IsLeaf(a_nodePair.node2);
+	if (isLeaf1 && isLeaf2)
+	{
+		// The fat bounds overlapping doesn't mean the proxies do.
+		const unsigned int proxyIndex1 = node1.proxyIndex;
+		const unsigned int proxyIndex2 = node2.proxyIndex;
+		if (AABBOverlap(m_proxyBounds[proxyIndex1], m_proxyBounds[proxyIndex2]))
+		{
+			if (proxyIndex1 < proxyIndex2)
+				a_pairs.push_back({ proxyIndex1, proxyIndex2 });
+			else
+				a_pairs.push_back({ proxyIndex2, proxyIndex1 });
+		}
+	}
+	else if (isLeaf2 || (!isLeaf1 && node1.height >= node2.height))
+	{
+		// Descend the taller side.
+		a_nodePairs.push_back({ node1.child1, a_nodePair.node2 });
+		a_nodePairs.push_back({ node1.child2, a_nodePair.node2 });
+	}
+	else
+	{
+		a_nodePairs.push_back({ a_nodePair.node1, node2.child1 });
+		a_nodePairs.push_back({ a_nodePair.node1, node2.child2 });
+	}
+}
+
+void DynamicAABBTree::QueryRegion(const AABB& a_region, std::vector<unsigned int>& a_proxyIndices) const
+{
+	int stack[QUERY_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = m_rootNode;
+
+	while (stackSize > 0)
+	{
+		const int node = stack[--stackSize];
+		if (node == NULL_NODE || !AABBOverlap(m_nodes[node].bounds, a_region))
+			continue;
+
+		if (IsLeaf(node))
+		{
+			// The fat bounds overlapping doesn't mean the proxy does.
+			const unsigned int proxyIndex = m_nodes[node].proxyIndex;
+			if (AABBOverlap(m_proxyBounds[proxyIndex], a_region))
+			{
+				a_proxyIndices.push_back(proxyIndex);
+			}
+		}
+		else
+		{
+			assert(stackSize + 2 <= QUERY_STACK_SIZE && "The tree is too deep for the query stack.");
+			stack[stackSize++] = m_nodes[node].child1;
+			stack[stackSize++] = m_nodes[node].child2;
+		}
+	}
+}
+
+AABB DynamicAABBTree::FattenBounds(const AABB& a_bounds) const
+{
+	return { a_bounds.minX - m_fatMargin, a_bounds.minY - m_fatMargin, a_bounds.maxX + m_fatMargin, a_bounds.maxY + m_fatMargin };
+}
+
+int DynamicAABBTree::AllocateNode()
+{
+	// Grow the pool if there are no free nodes left.
+	if (m_freeNode == NULL_NODE)
+	{
+		m_nodes.emplace_back();
+		return static_cast<int>(m_nodes.size() - 1);
+	}
+
+	const int node = m_freeNode;
+	m_freeNode = m_nodes[node].parent;
+	m_nodes[node] = TreeNode();
+	return node;
+}
+
+void DynamicAABBTree::FreeNode(int a_node)
+{
+	m_nodes[a_node].parent = m_freeNode;
+	m_nodes[a_node].height = -1;
+	m_freeNode = a_node;
+}
+
+void DynamicAABBTree::InsertLeaf(int a_leaf)
+{
+	m_nodes[a_leaf].parent = NULL_NODE;
+	m_nodes[a_leaf].child1 = NULL_NODE;
+	m_nodes[a_leaf].child2 = NULL_NODE;
+	m_nodes[a_leaf].height = 0;
+
+	if (m_rootNode == NULL_NODE)
+	{
+		m_rootNode = a_leaf;
+		return;
+	}
+
+	// Descend towards the sibling that grows the total perimeter of the tree the least.
+	const AABB leafBounds = m_nodes[a_leaf].bounds;
+	int sibling = m_rootNode;
+	while (!IsLeaf(sibling))
+	{
+		const TreeNode& node = m_nodes[sibling];
+		const float perimeter = AABBPerimeter(node.bounds);
+		const float combinedPerimeter = AABBPerimeter(AABBUnion(node.bounds, leafBounds));
+
+		// Cost of pairing the leaf with this node, and the cost every descendant inherits from growing this node.
+		const float cost = 2.0f * combinedPerimeter;
+		const float inheritanceCost = 2.0f * (combinedPerimeter - perimeter);
+
+		// Cost of descending into either child.
+		float childCosts[2] = {};
+		const int children[2] = { node.child1, node.child2 };
+		for (int childIndex = 0; childIndex < 2; ++childIndex)
+		{
+			const TreeNode& child = m_nodes[children[childIndex]];
+			const float childCombinedPerimeter = AABBPerimeter(AABBUnion(child.bounds, leafBounds));
+			childCosts[childIndex] = IsLeaf(children[childIndex])
+				? childCombinedPerimeter + inheritanceCost
+				: childCombinedPerimeter - AABBPerimeter(child.bounds) + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+			break;
+
+		sibling = childCosts[0] < childCosts[1] ? node.child1 : node.child2;
+	}
+
+	// Replace the sibling with a new parent holding both the sibling and the leaf.
+	const int oldParent = m_nodes[sibling].parent;
+	const int newParent = AllocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = a_leaf;
+	CombineChildren(newParent);
+	m_nodes[sibling].parent = newParent;
+	m_nodes[a_leaf].parent = newParent;
+
+	if (oldParent == NULL_NODE)
+		m_rootNode = newParent;
+	else if (m_nodes[oldParent].child1 == sibling)
+		m_nodes[oldParent].child1 = newParent;
+	else
+		m_nodes[oldParent].child2 = newParent;
+
+	RefitAncestors(m_nodes[a_leaf].parent);
+}
+
+void DynamicAABBTree::RemoveLeaf(int a_leaf)
+{
+	if (a_leaf == m_rootNode)
+	{
+		m_rootNode = NULL_NODE;
+		return;
+	}
+
+	// Replace the parent of the leaf with the leaf's sibling.
+	const int parent = m_nodes[a_leaf].parent;
+	const int grandParent = m_nodes[parent].parent;
+	const int sibling = m_nodes[parent].child1 == a_leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	m_nodes[sibling].parent = grandParent;
+	FreeNode(parent);
+
+	if (grandParent == NULL_NODE)
+	{
+		m_rootNode = sibling;
+		return;
+	}
+
+	if (m_nodes[grandParent].child1 == parent)
+		m_nodes[grandParent].child1 = sibling;
+	else
+		m_nodes[grandParent].child2 = sibling;
+
+	RefitAncestors(grandParent);
+}
+
+void DynamicAABBTree::RefitAncestors(int a_node)
+{
+	// Walk up to the root, rebalancing and recomputing the bounds, height, and filter of every node on the way.
+	int node = a_node;
+	while (node != NULL_NODE)
+	{
+		node = Balance(node);
+		CombineChildren(node);
+		node = m_nodes[node].parent;
+	}
+}
+
+void DynamicAABBTree::CombineChildren(int a_node)
+{
+	TreeNode& node = m_nodes[a_node];
+	const TreeNode& child1 = m_nodes[node.child1];
+	const TreeNode& child2 = m_nodes[node.child2];
+
+	node.bounds = AABBUnion(child1.bounds, child2.bounds);
+	node.height = 1 + std::max(child1.height, child2.height);
+	node.filter.layerBit = child1.filter.layerBit | child2.filter.layerBit;
+	node.filter.collisionMask = child1.filter.collisionMask | child2.filter.collisionMask;
+}
+
+int DynamicAABBTree::Balance(int a_node)
+{
+	if (IsLeaf(a_node) || m_nodes[a_node].height < 2)
+		return a_node;
+
+	const int nodeA = a_node;
+	const int nodeB = m_nodes[nodeA].child1;
+	const int nodeC = m_nodes[nodeA].child2;
+	const int balance = m_nodes[nodeC].height - m_nodes[nodeB].height;
+
+	// Rotate the taller child up into the place of the node. The taller grandchild stays under the promoted child, and the
+	// shorter one moves under the demoted node.
+	if (balance > 1 || balance < -1)
+	{
+		const bool rotateC = balance > 1;
+		const int promoted = rotateC ? nodeC : nodeB;
+		const int grandChild1 = m_nodes[promoted].child1;
+		const int grandChild2 = m_nodes[promoted].child2;
+		const bool grandChild1Taller = m_nodes[grandChild1].height > m_nodes[grandChild2].height;
+		const int tallGrandChild = grandChild1Taller ? grandChild1 : grandChild2;
+		const int shortGrandChild = grandChild1Taller ? grandChild2 : grandChild1;
+
+		// Promote the child.
+		m_nodes[promoted].child1 = nodeA;
+		m_nodes[promoted].child2 = tallGrandChild;
+		m_nodes[promoted].parent = m_nodes[nodeA].parent;
+		m_nodes[nodeA].parent = promoted;
+
+		const int promotedParent = m_nodes[promoted].parent;
+		if (promotedParent == NULL_NODE)
+			m_rootNode = promoted;
+		else if (m_nodes[promotedParent].child1 == nodeA)
+			m_nodes[promotedParent].child1 = promoted;
+		else
+			m_nodes[promotedParent].child2 = promoted;
+
+		// Demote the node, keeping its other child and adopting the short grandchild.
+		if (rotateC)
+			m_nodes[nodeA].child2 = shortGrandChild;
+		else
+			m_nodes[nodeA].child1 = shortGrandChild;
+		m_nodes[shortGrandChild].parent = nodeA;
+
+		CombineChildren(nodeA);
+		CombineChildren(promoted);
+		return promoted;
+	}
+
+	return a_node;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "PCH.h"
+#include "AABB.h"
+#include "IBroadphase.h"
+
+// Broadphase keeping proxies in the leaves of a balanced bounding volume hierarchy. Leaves store bounds fattened by a
+// margin, so a proxy is only reinserted once it moves out of its fat bounds. Unlike a grid, the tree adapts to colliders
+// of any size and to worlds that are mostly empty.
+class DynamicAABBTree final : public IBroadphase
+{
+public:
+	DynamicAABBTree(float a_fatMargin = 8.0f);
+	~DynamicAABBTree() = default;
+
+	// Inherited via IBroadphase.
+	void Update(const std::vector<BroadphaseProxy>& a_proxies) override;
+	void QueryPairs(std::vector<BroadphasePair>& a_pairs) const override;
+	void QueryRegion(const AABB& a_region, std::vector<unsigned int>& a_proxyIndices) const override;
+
+	// Partitions are node pairs of the tree's self collision, each standing for a disjoint set of proxy pairs.
+	size_t PreparePartitions(size_t a_desiredPartitionCount) override;
+	void QueryPartitionPairs(size_t a_partitionIndex, std::vector<BroadphasePair>& a_pairs) const override;
+
+	// Walk the tree nearer subtrees first, for queries that narrow down as they find results. The node distance is given
+	// the bounds and filter of a node, and returns how far the node is from the query, or a negative value to skip it.
+	// Nodes are measured again before being descended into, so the distance may prune against the results found so far.
+	// The leaf visitor is given the proxy index and tight bounds of every leaf reached, and returns false to stop.
+	template<typename TNodeDistance, typename TLeafVisitor> void VisitNearestFirst(TNodeDistance a_nodeDistance, TLeafVisitor a_leafVisitor) const;
+
+	int GetHeight() const { return m_rootNode == NULL_NODE ? 0 : m_nodes[m_rootNode].height; }
+	size_t GetLeafCount() const { return m_liveEntities.size(); }
+
+private:
+	static constexpr int NULL_NODE = -1;
+	static constexpr int QUERY_STACK_SIZE = 256;		// Fixed stack of the region and nearest first queries.
+	static constexpr size_t PARTITIONS_PER_THREAD = 4;	// Spare partitions so threads finishing early pick up more work.
+
+	// A node of the tree. Leaves have no children, and internal nodes always have two.
+	struct TreeNode final
+	{
+		AABB bounds;						// 16 bytes. Fat bounds for leaves, union of the children otherwise.
+		int parent = NULL_NODE;				// 4 bytes. Next free node while the node is in the free list.
+		int child1 = NULL_NODE;				// 4 bytes.
+		int child2 = NULL_NODE;				// 4 bytes.
+		int height = 0;						// 4 bytes. Zero for leaves.
+		unsigned int proxyIndex = 0;		// 4 bytes. Index of the leaf's proxy in the current proxy list.
+		CollisionFilter filter;				// 4 bytes. Union of the filters in the subtree for internal nodes.
+	};										// Total = 40 bytes.
+
+	// Two subtrees whose proxies are tested against each other, or a single subtree tested against itself.
+	struct NodePair final
+	{
+		int node1 = NULL_NODE;				// 4 bytes.
+		int node2 = NULL_NODE;				// 4 bytes.
+	};										// Total = 8 bytes.
+
+	bool IsLeaf(int a_node) const { return m_nodes[a_node].child1 == NULL_NODE; }
+	void CollideNodePairs(std::vector<NodePair>& a_stack, std::vector<BroadphasePair>& a_pairs) const;
+	void ExpandNodePair(const NodePair& a_nodePair, std::vector<NodePair>& a_nodePairs, std::vector<BroadphasePair>& a_pairs) const;
+	void CombineChildren(int a_node);
+	AABB FattenBounds(const AABB& a_bounds) const;
+
+	int AllocateNode();
+	void FreeNode(int a_node);
+	void InsertLeaf(int a_leaf);
+	void RemoveLeaf(int a_leaf);
+	void RefitAncestors(int a_node);
+	int Balance(int a_node);
+
+private:
+	float m_fatMargin = 0.0f;
+	int m_rootNode = NULL_NODE;
+	int m_freeNode = NULL_NODE;
+	unsigned int m_updateStamp = 0;
+
+	std::vector<TreeNode> m_nodes;				// Node pool. Freed nodes are chained through their parent index.
+	std::vector<int> m_entityLeaves;			// Leaf of every entity in the tree, indexed by entity.
+	std::vector<unsigned int> m_entityStamps;	// Update during which every entity was last seen, indexed by entity.
+	std::vector<Entity> m_liveEntities;			// Entities currently in the tree.
+	std::vector<AABB> m_proxyBounds;			// Tight bounds of each proxy, indexed like the proxy list.
+	std::vector<NodePair> m_partitionNodePairs;	// Node pair each partition starts from.
+
+	// Scratch buffers kept between frames, so the queries don't allocate once they've grown.
+	std::vector<NodePair> m_expandedNodePairs;
+	std::vector<BroadphasePair> m_unusedPairs;
+	mutable std::vector<NodePair> m_queryStack;
+	mutable std::vector<std::vector<NodePair>> m_partitionStacks;	// Stack of each partition's query.
+};
+
+template<typename TNodeDistance, typename TLeafVisitor>
+void DynamicAABBTree::VisitNearestFirst(TNodeDistance a_nodeDistance, TLeafVisitor a_leafVisitor) const
+{
+	if (m_rootNode == NULL_NODE)
+		return;
+
+	int stack[QUERY_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = m_rootNode;
+
+	while (stackSize > 0)
+	{
+		const int node = stack[--stackSize];
+		const TreeNode& treeNode = m_nodes[node];
+		if (a_nodeDistance(treeNode.bounds, treeNode.filter) < 0.0f)
+			continue;
+
+		if (IsLeaf(node))
+		{
+			if (!a_leafVisitor(treeNode.proxyIndex, m_proxyBounds[treeNode.proxyIndex]))
+				return;
+
+			continue;
+		}
+
+		const TreeNode& child1 = m_nodes[treeNode.child1];
+		const TreeNode& child2 = m_nodes[treeNode.child2];
+		const float distance1 = a_nodeDistance(child1.bounds, child1.filter);
+		const float distance2 = a_nodeDistance(child2.bounds, child2.filter);
+
+		// Push the nearer child last, so it's popped first.
+		assert(stackSize + 2 <= QUERY_STACK_SIZE && "The tree is too deep for the query stack.");
+		const bool isChild1Nearer = distance2 < 0.0f || (distance1 >= 0.0f && distance1 <= distance2);
+		const int nearChild = isChild1Nearer ? treeNode.child1 : treeNode.child2;
+		const int farChild = isChild1Nearer ? treeNode.child2 : treeNode.child1;
+		const float farDistance = isChild1Nearer ? distance2 : distance1;
+		const float nearDistance = isChild1Nearer ? distance1 : distance2;
+		if (farDistance >= 0.0f)
+			stack[stackSize++] = farChild;
+		if (nearDistance >= 0.0f)
+			stack[stackSize++] = nearChild;
+	}
+}
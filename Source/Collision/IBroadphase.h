@@ -0,0 +1,33 @@
+#pragma once
+#include "PCH.h"
+#include "AABB.h"
+#include "Macros.h"
+
+// Common interface of the collision broadphases. The broadphase is synchronized with the full list of colliders every
+// frame, and answers queries in terms of indices into that list.
+class IBroadphase
+{
+public:
+	NO_COPY(IBroadphase);
+	NO_MOVE(IBroadphase);
+
+	IBroadphase() = default;
+	virtual ~IBroadphase() = default;
+
+	// Synchronize with the current bounds of every collider. Proxies must be unique per entity.
+	virtual void Update(const std::vector<BroadphaseProxy>& a_proxies) = 0;
+
+	// Append every pair of proxies whose bounds may overlap and whose collision filters interact. Each pair is appended
+	// once, lower proxy index first.
+	virtual void QueryPairs(std::vector<BroadphasePair>& a_pairs) const = 0;
+
+	// Split the pair query into partitions that can be queried concurrently, aiming for at least the given count. Every
+	// pair belongs to exactly one partition. Returns the number of partitions, broadphases that can't split use one.
+	virtual size_t PreparePartitions(size_t a_desiredPartitionCount) { return 1; }
+
+	// Append the pairs of one partition, like QueryPairs does for all of them.
+	virtual void QueryPartitionPairs(size_t a_partitionIndex, std::vector<BroadphasePair>& a_pairs) const { QueryPairs(a_pairs); }
+
+	// Append the index of every proxy whose bounds overlap the region, regardless of its collision filter.
+	virtual void QueryRegion(const AABB& a_region, std::vector<unsigned int>& a_proxyIndices) const = 0;
+};
@@ -0,0 +1,146 @@
+#include "PCH.h"
+#include "SpatialIndex.h"
+
+SpatialIndex::SpatialIndex(float a_fatMargin)
+	: m_tree(a_fatMargin)
+{
+}
+
+void SpatialIndex::Update(const std::vector<BroadphaseProxy>& a_proxies)
+{
+	m_tree.Update(a_proxies);
+
+	m_proxyEntities.resize(a_proxies.size());
+	for (size_t proxyIndex = 0; proxyIndex < a_proxies.size(); ++proxyIndex)
+	{
+		m_proxyEntities[proxyIndex] = a_proxies[proxyIndex].entity;
+	}
+}
+
+size_t SpatialIndex::QueryRect(const AABB& a_rect, Entity* an_entities, size_t a_capacity, CollisionLayerMask a_layerMask) const
+{
+	size_t entityCount = 0;
+	if (a_capacity == 0)
+		return entityCount;
+
+	m_tree.VisitNearestFirst(
+		[&a_rect, a_layerMask](const AABB& a_bounds, const CollisionFilter& a_filter)
+		{
+			return (a_filter.layerBit & a_layerMask) != 0 && AABBOverlap(a_bounds, a_rect) ? 0.0f : -1.0f;
+		},
+		[this, &a_rect, an_entities, a_capacity, &entityCount](unsigned int a_proxyIndex, const AABB& a_bounds)
+		{
+			if (AABBOverlap(a_bounds, a_rect))
+				an_entities[entityCount++] = m_proxyEntities[a_proxyIndex];
+
+			return entityCount < a_capacity;
+		});
+
+	return entityCount;
+}
+
+size_t SpatialIndex::QueryCircle(float a_centerX, float a_centerY, float a_radius, Entity* an_entities, size_t a_capacity, CollisionLayerMask a_layerMask) const
+{
+	size_t entityCount = 0;
+	if (a_capacity == 0)
+		return entityCount;
+
+	// Keep to the boxes whose closest point lies within the circle.
+	const float radiusSquared = a_radius * a_radius;
+	m_tree.VisitNearestFirst(
+		[a_centerX, a_centerY, radiusSquared, a_layerMask](const AABB& a_bounds, const CollisionFilter& a_filter)
+		{
+			const float distanceSquared = AABBDistanceSquared(a_bounds, a_centerX, a_centerY);
+			return (a_filter.layerBit & a_layerMask) != 0 && distanceSquared < radiusSquared ? distanceSquared : -1.0f;
+		},
+		[this, a_centerX, a_centerY, radiusSquared, an_entities, a_capacity, &entityCount](unsigned int a_proxyIndex, const AABB& a_bounds)
+		{
+			if (AABBDistanceSquared(a_bounds, a_centerX, a_centerY) < radiusSquared)
+				an_entities[entityCount++] = m_proxyEntities[a_proxyIndex];
+
+			return entityCount < a_capacity;
+		});
+
+	return entityCount;
+}
+
+bool SpatialIndex::Raycast(float an_originX, float an_originY, float a_directionX, float a_directionY, float a_maxDistance, SpatialQueryHit& a_hit, CollisionLayerMask a_layerMask) const
+{
+	const float directionLength = sqrtf(a_directionX * a_directionX + a_directionY * a_directionY);
+	if (directionLength == 0.0f || a_maxDistance <= 0.0f)
+		return false;
+
+	// Cast the ray as a point swept over the whole distance. Times of impact are fractions of the distance, and every
+	// hit shortens the ray, so only boxes the ray reaches before the closest hit so far are descended into.
+	const AABB origin = { an_originX, an_originY, an_originX, an_originY };
+	const float displacementX = a_directionX / directionLength * a_maxDistance;
+	const float displacementY = a_directionY / directionLength * a_maxDistance;
+	float closestTimeOfImpact = 1.0f;
+	bool isHit = false;
+
+	m_tree.VisitNearestFirst(
+		[&origin, displacementX, displacementY, &closestTimeOfImpact, a_layerMask](const AABB& a_bounds, const CollisionFilter& a_filter)
+		{
+			float timeOfImpact = 0.0f;
+			const bool isReached = (a_filter.layerBit & a_layerMask) != 0 && SweepAABB(origin, displacementX, displacementY, a_bounds, timeOfImpact);
+			return isReached && timeOfImpact <= closestTimeOfImpact ? timeOfImpact : -1.0f;
+		},
+		[this, &origin, displacementX, displacementY, &closestTimeOfImpact, &isHit, &a_hit](unsigned int a_proxyIndex, const AABB& a_bounds)
+		{
+			float timeOfImpact = 0.0f;
+			if (SweepAABB(origin, displacementX, displacementY, a_bounds, timeOfImpact) && (!isHit || timeOfImpact < closestTimeOfImpact))
+			{
+				closestTimeOfImpact = timeOfImpact;
+				a_hit.entity = m_proxyEntities[a_proxyIndex];
+				isHit = true;
+			}
+
+			return true;
+		});
+
+	if (isHit)
+		a_hit.distance = closestTimeOfImpact * a_maxDistance;
+
+	return isHit;
+}
+
+size_t SpatialIndex::NearestK(float a_x, float a_y, size_t a_count, SpatialQueryHit* a_hits, CollisionLayerMask a_layerMask) const
+{
+	size_t hitCount = 0;
+	if (a_count == 0)
+		return hitCount;
+
+	// Keep the closest hits found so far sorted in the caller's buffer, by squared distance until the end. Once the
+	// buffer is full, only boxes closer than the farthest hit can improve it.
+	m_tree.VisitNearestFirst(
+		[a_x, a_y, a_count, a_hits, &hitCount, a_layerMask](const AABB& a_bounds, const CollisionFilter& a_filter)
+		{
+			const float distanceSquared = AABBDistanceSquared(a_bounds, a_x, a_y);
+			const bool canImprove = hitCount < a_count || distanceSquared < a_hits[hitCount - 1].distance;
+			return (a_filter.layerBit & a_layerMask) != 0 && canImprove ? distanceSquared : -1.0f;
+		},
+		[this, a_x, a_y, a_count, a_hits, &hitCount](unsigned int a_proxyIndex, const AABB& a_bounds)
+		{
+			const float distanceSquared = AABBDistanceSquared(a_bounds, a_x, a_y);
+			if (hitCount == a_count && distanceSquared >= a_hits[hitCount - 1].distance)
+				return true;
+
+			// Insert the hit in order, dropping the farthest one if the buffer is full.
+			size_t hitIndex = hitCount < a_count ? hitCount++ : hitCount - 1;
+			while (hitIndex > 0 && a_hits[hitIndex - 1].distance > distanceSquared)
+			{
+				a_hits[hitIndex] = a_hits[hitIndex - 1];
+				--hitIndex;
+			}
+
+			a_hits[hitIndex] = { m_proxyEntities[a_proxyIndex], distanceSquared };
+			return true;
+		});
+
+	for (size_t hitIndex = 0; hitIndex < hitCount; ++hitIndex)
+	{
+		a_hits[hitIndex].distance = sqrtf(a_hits[hitIndex].distance);
+	}
+
+	return hitCount;
+}
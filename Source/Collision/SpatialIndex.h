@@ -0,0 +1,48 @@
+#pragma once
+#include "PCH.h"
+#include "AABB.h"
+#include "CollisionLayers.h"
+#include "Constants\Constants.h"
+#include "DynamicAABBTree.h"
+#include "Macros.h"
+
+// An entity found by a spatial query, and how far it is.
+struct SpatialQueryHit final
+{
+	Entity entity = INVALID_ENTITY;		// 8 bytes.
+	float distance = 0.0f;				// 4 bytes. Along the ray for raycasts, from the query point for nearest queries.
+};										// Total = 16 bytes with padding.
+
+// Answers "what is near here" for every collider, kept up to date by the collision system. Colliders live in a dynamic
+// tree over their exact bounds, so queries descend only into the subtrees that can hold results, and subtrees without
+// any of the queried layers are skipped whole. Results go into buffers the caller owns, and queries never allocate.
+class SpatialIndex final
+{
+public:
+	NO_COPY(SpatialIndex);
+	NO_MOVE(SpatialIndex);
+
+	SpatialIndex(float a_fatMargin = 8.0f);
+	~SpatialIndex() = default;
+
+	// Move the colliders to their bounds this frame, adding and removing them as needed.
+	void Update(const std::vector<BroadphaseProxy>& a_proxies);
+
+	// Write out the entities overlapping the rectangle, up to the capacity. Returns how many were written.
+	size_t QueryRect(const AABB& a_rect, Entity* an_entities, size_t a_capacity, CollisionLayerMask a_layerMask = ALL_COLLISION_LAYERS) const;
+
+	// Write out the entities overlapping the circle, up to the capacity. Returns how many were written.
+	size_t QueryCircle(float a_centerX, float a_centerY, float a_radius, Entity* an_entities, size_t a_capacity, CollisionLayerMask a_layerMask = ALL_COLLISION_LAYERS) const;
+
+	// Find the first entity the ray enters within the distance. A ray starting inside an entity hits it at distance zero.
+	bool Raycast(float an_originX, float an_originY, float a_directionX, float a_directionY, float a_maxDistance, SpatialQueryHit& a_hit, CollisionLayerMask a_layerMask = ALL_COLLISION_LAYERS) const;
+
+	// Write out the closest entities to the point, nearest first, up to the count. Returns how many were written.
+	size_t NearestK(float a_x, float a_y, size_t a_count, SpatialQueryHit* a_hits, CollisionLayerMask a_layerMask = ALL_COLLISION_LAYERS) const;
+
+	size_t GetEntityCount() const { return m_proxyEntities.size(); }
+
+private:
+	DynamicAABBTree m_tree;					// Bounds of every collider.
+	std::vector<Entity> m_proxyEntities;	// Entity of each proxy in the tree, indexed like the proxy list.
+};
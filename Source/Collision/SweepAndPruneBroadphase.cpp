@@ -0,0 +1,351 @@
+#include "PCH.h"
+#include "SweepAndPruneBroadphase.h"
+
+SweepAndPruneBroadphase::SweepAndPruneBroadphase(bool a_sortBothAxes)
+	: m_axisCount(a_sortBothAxes ? 2 : 1)
+{
+}
+
+void SweepAndPruneBroadphase::Update(const std::vector<BroadphaseProxy>& a_proxies)
+{
+	// Entities tracked after the previous update carry its stamp, anything else is new.
+	const unsigned int previousStamp = m_updateStamp++;
+
+	m_newEntities.clear();
+	m_changedEntities.clear();
+	m_maxWidth = 0.0f;
+	for (size_t proxyIndex = 0; proxyIndex < a_proxies.size(); ++proxyIndex)
+	{
+		const BroadphaseProxy& proxy = a_proxies[proxyIndex];
+		assert(proxy.entity < (1u << 31) && "The entity doesn't fit in an endpoint.");
+		if (proxy.entity >= m_entityBounds.size())
+		{
+			m_entityBounds.resize(proxy.entity * 2 + 1);
+			m_entityPreviousBounds.resize(proxy.entity * 2 + 1);
+			m_entityFilters.resize(proxy.entity * 2 + 1);
+			m_entityProxyIndices.resize(proxy.entity * 2 + 1, 0);
+			m_entityStamps.resize(proxy.entity * 2 + 1, 0);
+		}
+
+		if (m_entityStamps[proxy.entity] != previousStamp)
+		{
+			m_newEntities.push_back(proxy.entity);
+			m_entityPreviousBounds[proxy.entity] = proxy.bounds;
+		}
+		else if (m_entityFilters[proxy.entity].layerBit != proxy.filter.layerBit
+			|| m_entityFilters[proxy.entity].collisionMask != proxy.filter.collisionMask)
+		{
+			m_changedEntities.push_back(proxy.entity);
+			m_entityPreviousBounds[proxy.entity] = proxy.bounds;
+		}
+		else
+		{
+			m_entityPreviousBounds[proxy.entity] = m_entityBounds[proxy.entity];
+		}
+
+		m_entityBounds[proxy.entity] = proxy.bounds;
+		m_entityFilters[proxy.entity] = proxy.filter;
+		m_entityProxyIndices[proxy.entity] = static_cast<unsigned int>(proxyIndex);
+		m_entityStamps[proxy.entity] = m_updateStamp;
+		m_maxWidth = std::max(m_maxWidth, proxy.bounds.maxX - proxy.bounds.minX);
+	}
+
+	// Entities changing filter may start or end overlaps without any endpoint moving, so they are removed as if stale
+	// and added back as new.
+	for (const Entity entity : m_changedEntities)
+	{
+		m_entityStamps[entity] = previousStamp;
+	}
+
+	m_touchedPairs.clear();
+	RemoveStaleEntities();
+
+	for (const Entity entity : m_changedEntities)
+	{
+		m_entityStamps[entity] = m_updateStamp;
+		m_newEntities.push_back(entity);
+	}
+
+	// Add the endpoints of the new entities, with their final values.
+	for (const Entity entity : m_newEntities)
+	{
+		m_liveEntities.push_back(entity);
+		for (int axis = 0; axis < m_axisCount; ++axis)
+		{
+			m_endpoints[axis].push_back({ 0.0f, static_cast<unsigned int>(entity << 1) });
+			m_endpoints[axis].push_back({ 0.0f, static_cast<unsigned int>(entity << 1 | 1) });
+		}
+	}
+
+	// Refresh the values of every endpoint from the current bounds.
+	for (int axis = 0; axis < m_axisCount; ++axis)
+	{
+		for (Endpoint& endpoint : m_endpoints[axis])
+		{
+			endpoint.value = GetEndpointValue(endpoint, axis);
+		}
+	}
+
+	// Fix the endpoints up incrementally, unless so many entities are new that sorting from scratch is cheaper.
+	if (m_newEntities.size() * REBUILD_NEW_PROXY_DIVISOR > m_liveEntities.size())
+	{
+		RebuildPairs();
+	}
+	else
+	{
+		for (int axis = 0; axis < m_axisCount; ++axis)
+		{
+			InsertionSortAxis(axis);
+		}
+	}
+
+	CollectPairDeltas();
+}
+
+void SweepAndPruneBroadphase::QueryPairs(std::vector<BroadphasePair>& a_pairs) const
+{
+	for (const auto& pairEntry : m_pairStates)
+	{
+		const Entity entity1 = static_cast<Entity>(pairEntry.first >> 32);
+		const Entity entity2 = static_cast<Entity>(pairEntry.first & 0xFFFFFFFF);
+
+		// With only the x axis sorted, the pairs still need to overlap on y.
+		if (m_axisCount == 1 && !AABBOverlap(m_entityBounds[entity1], m_entityBounds[entity2]))
+			continue;
+
+		const unsigned int proxyIndex1 = m_entityProxyIndices[entity1];
+		const unsigned int proxyIndex2 = m_entityProxyIndices[entity2];
+		if (proxyIndex1 < proxyIndex2)
+			a_pairs.push_back({ proxyIndex1, proxyIndex2 });
+		else
+			a_pairs.push_back({ proxyIndex2, proxyIndex1 });
+	}
+}
+
+void SweepAndPruneBroadphase::QueryRegion(const AABB& a_region, std::vector<unsigned int>& a_proxyIndices) const
+{
+	// No proxy starting further left than the widest proxy can reach into the region.
+	const std::vector<Endpoint>& endpoints = m_endpoints[0];
+	const Endpoint firstCandidate = { a_region.minX - m_maxWidth, 0 };
+	auto endpointIterator = std::lower_bound(endpoints.begin(), endpoints.end(), firstCandidate, EndpointLess);
+
+	// Walk the min endpoints until they pass the right edge of the region.
+	for (; endpointIterator != endpoints.end() && endpointIterator->value < a_region.maxX; ++endpointIterator)
+	{
+		if (IsMaxEndpoint(*endpointIterator))
+			continue;
+
+		const Entity entity = GetEndpointEntity(*endpointIterator);
+		if (AABBOverlap(m_entityBounds[entity], a_region))
+		{
+			a_proxyIndices.push_back(m_entityProxyIndices[entity]);
+		}
+	}
+}
+
+bool SweepAndPruneBroadphase::EndpointLess(const Endpoint& an_endpoint1, const Endpoint& an_endpoint2)
+{
+	// On equal values max endpoints come first, so boxes that merely touch don't overlap, like with AABBOverlap.
+	if (an_endpoint1.value != an_endpoint2.value)
+		return an_endpoint1.value < an_endpoint2.value;
+
+	return IsMaxEndpoint(an_endpoint1) && !IsMaxEndpoint(an_endpoint2);
+}
+
+uint64_t SweepAndPruneBroadphase::GetPairKey(Entity an_entity1, Entity an_entity2)
+{
+	// Each entity takes one half of the key, so larger ids would collide with other pairs.
+	assert(an_entity1 <= UINT32_MAX && an_entity2 <= UINT32_MAX && "Entity ids must fit in 32 bits to key a pair.");
+	return an_entity1 < an_entity2
+		? static_cast<uint64_t>(an_entity1) << 32 | an_entity2
+		: static_cast<uint64_t>(an_entity2) << 32 | an_entity1;
+}
+
+float SweepAndPruneBroadphase::GetEndpointValue(const Endpoint& an_endpoint, int an_axis) const
+{
+	const AABB& bounds = m_entityBounds[GetEndpointEntity(an_endpoint)];
+	if (an_axis == 0)
+		return IsMaxEndpoint(an_endpoint) ? bounds.maxX : bounds.minX;
+
+	return IsMaxEndpoint(an_endpoint) ? bounds.maxY : bounds.minY;
+}
+
+bool SweepAndPruneBroadphase::TestInteraction(Entity an_entity1, Entity an_entity2) const
+{
+	// Skip pairs on layers that don't interact, before looking at their bounds.
+	if (!CollisionFiltersInteract(m_entityFilters[an_entity1], m_entityFilters[an_entity2]))
+		return false;
+
+	const AABB& bounds1 = m_entityBounds[an_entity1];
+	const AABB& bounds2 = m_entityBounds[an_entity2];
+
+	// With only the x axis sorted, the tracked pairs are the ones overlapping on x.
+	if (m_axisCount == 1)
+		return bounds1.minX < bounds2.maxX && bounds2.minX < bounds1.maxX;
+
+	return AABBOverlap(bounds1, bounds2);
+}
+
+bool SweepAndPruneBroadphase::TestPreviousInteraction(Entity an_entity1, Entity an_entity2) const
+{
+	// Filters of tracked entities never change, changed ones are removed and added back.
+	if (!CollisionFiltersInteract(m_entityFilters[an_entity1], m_entityFilters[an_entity2]))
+		return false;
+
+	const AABB& bounds1 = m_entityPreviousBounds[an_entity1];
+	const AABB& bounds2 = m_entityPreviousBounds[an_entity2];
+
+	if (m_axisCount == 1)
+		return bounds1.minX < bounds2.maxX && bounds2.minX < bounds1.maxX;
+
+	return AABBOverlap(bounds1, bounds2);
+}
+
+void SweepAndPruneBroadphase::RemoveStaleEntities()
+{
+	// Drop the entities that no longer have a proxy.
+	const auto isStale = [this](Entity an_entity) { return m_entityStamps[an_entity] != m_updateStamp; };
+	const auto staleIterator = std::remove_if(m_liveEntities.begin(), m_liveEntities.end(), isStale);
+	if (staleIterator == m_liveEntities.end())
+		return;
+
+	m_liveEntities.erase(staleIterator, m_liveEntities.end());
+
+	// Drop their endpoints, keeping the others sorted.
+	const auto isStaleEndpoint = [&isStale](const Endpoint& an_endpoint) { return isStale(GetEndpointEntity(an_endpoint)); };
+	for (int axis = 0; axis < m_axisCount; ++axis)
+	{
+		std::vector<Endpoint>& endpoints = m_endpoints[axis];
+		endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), isStaleEndpoint), endpoints.end());
+	}
+
+	// And end their overlaps.
+	for (auto& pairEntry : m_pairStates)
+	{
+		if (isStale(static_cast<Entity>(pairEntry.first >> 32)) || isStale(static_cast<Entity>(pairEntry.first & 0xFFFFFFFF)))
+		{
+			pairEntry.second &= ~PAIR_OVERLAPPING;
+			m_touchedPairs.push_back(pairEntry.first);
+		}
+	}
+}
+
+void SweepAndPruneBroadphase::InsertionSortAxis(int an_axis)
+{
+	std::vector<Endpoint>& endpoints = m_endpoints[an_axis];
+	for (size_t index = 1; index < endpoints.size(); ++index)
+	{
+		const Endpoint movingEndpoint = endpoints[index];
+		const Entity movingEntity = GetEndpointEntity(movingEndpoint);
+
+		// Shift the endpoint left to its place. Passing the opposite endpoint of another entity changes whether the two
+		// overlap on this axis: a min passing a max starts an overlap, and a max passing a min ends it.
+		size_t insertIndex = index;
+		while (insertIndex > 0 && EndpointLess(movingEndpoint, endpoints[insertIndex - 1]))
+		{
+			const Endpoint& passedEndpoint = endpoints[insertIndex - 1];
+			const Entity passedEntity = GetEndpointEntity(passedEndpoint);
+			if (IsMaxEndpoint(movingEndpoint) != IsMaxEndpoint(passedEndpoint) && movingEntity != passedEntity)
+			{
+				// The values are final already, so test the overlap the pair ends up with rather than the intermediate one.
+				// Only pairs that overlapped before the update can have an overlap to end, which spares most lookups.
+				if (!IsMaxEndpoint(movingEndpoint) && TestInteraction(movingEntity, passedEntity))
+					AddPair(movingEntity, passedEntity);
+				else if (IsMaxEndpoint(movingEndpoint) && TestPreviousInteraction(movingEntity, passedEntity))
+					RemovePair(movingEntity, passedEntity);
+			}
+
+			endpoints[insertIndex] = passedEndpoint;
+			--insertIndex;
+		}
+
+		endpoints[insertIndex] = movingEndpoint;
+	}
+}
+
+void SweepAndPruneBroadphase::RebuildPairs()
+{
+	// Mark every known pair as ended, the sweep below restarts the ones still overlapping.
+	for (auto& pairEntry : m_pairStates)
+	{
+		pairEntry.second &= ~PAIR_OVERLAPPING;
+		m_touchedPairs.push_back(pairEntry.first);
+	}
+
+	for (int axis = 0; axis < m_axisCount; ++axis)
+	{
+		std::sort(m_endpoints[axis].begin(), m_endpoints[axis].end(), EndpointLess);
+	}
+
+	// Sweep the x axis, testing every entity against the entities whose interval is still open.
+	std::vector<Entity> openEntities;
+	std::vector<unsigned int> openPositions(m_entityBounds.size(), 0);
+	for (const Endpoint& endpoint : m_endpoints[0])
+	{
+		const Entity entity = GetEndpointEntity(endpoint);
+		if (IsMaxEndpoint(endpoint))
+		{
+			// Close the interval, swapping the last open entity into its place.
+			const unsigned int position = openPositions[entity];
+			openEntities[position] = openEntities.back();
+			openPositions[openEntities[position]] = position;
+			openEntities.pop_back();
+			continue;
+		}
+
+		for (const Entity openEntity : openEntities)
+		{
+			if (TestInteraction(entity, openEntity))
+				AddPair(entity, openEntity);
+		}
+
+		openPositions[entity] = static_cast<unsigned int>(openEntities.size());
+		openEntities.push_back(entity);
+	}
+}
+
+void SweepAndPruneBroadphase::AddPair(Entity an_entity1, Entity an_entity2)
+{
+	const uint64_t pairKey = GetPairKey(an_entity1, an_entity2);
+	m_pairStates[pairKey] |= PAIR_OVERLAPPING;
+	m_touchedPairs.push_back(pairKey);
+}
+
+void SweepAndPruneBroadphase::RemovePair(Entity an_entity1, Entity an_entity2)
+{
+	const auto pairIterator = m_pairStates.find(GetPairKey(an_entity1, an_entity2));
+	if (pairIterator == m_pairStates.end())
+		return;
+
+	pairIterator->second &= ~PAIR_OVERLAPPING;
+	m_touchedPairs.push_back(pairIterator->first);
+}
+
+void SweepAndPruneBroadphase::CollectPairDeltas()
+{
+	m_addedPairs.clear();
+	m_removedPairs.clear();
+
+	// Compare the state of every touched pair with its state at the start of the update. A pair may have started and
+	// ended several times along the way, only the net change is reported.
+	for (const uint64_t pairKey : m_touchedPairs)
+	{
+		const auto pairIterator = m_pairStates.find(pairKey);
+		if (pairIterator == m_pairStates.end())
+			continue;
+
+		const EntityPair entityPair = { static_cast<Entity>(pairKey >> 32), static_cast<Entity>(pairKey & 0xFFFFFFFF) };
+		const bool isOverlapping = (pairIterator->second & PAIR_OVERLAPPING) != 0;
+		const bool wasOverlapping = (pairIterator->second & PAIR_WAS_OVERLAPPING) != 0;
+		if (isOverlapping && !wasOverlapping)
+			m_addedPairs.push_back(entityPair);
+		else if (!isOverlapping && wasOverlapping)
+			m_removedPairs.push_back(entityPair);
+
+		// Settle the pair, so duplicates of it in the touched list are skipped.
+		if (isOverlapping)
+			pairIterator->second = PAIR_OVERLAPPING | PAIR_WAS_OVERLAPPING;
+		else
+			m_pairStates.erase(pairIterator);
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "PCH.h"
+#include "AABB.h"
+#include "IBroadphase.h"
+
+// Broadphase keeping the endpoints of every proxy sorted along the x axis, and optionally the y axis too. Most colliders
+// move a few pixels a frame, so the endpoints are nearly sorted already and an insertion sort fixes them up in close to
+// linear time. Every swap of a min and a max endpoint starts or ends an overlap, so the overlapping pairs are kept up to
+// date incrementally and reported as deltas. Pairs whose collision filters don't interact are never tracked.
+class SweepAndPruneBroadphase final : public IBroadphase
+{
+public:
+	// A pair of entities whose overlap started or ended during the last update. The first entity is always the lower one.
+	struct EntityPair final
+	{
+		Entity entity1 = 0;				// 8 bytes.
+		Entity entity2 = 0;				// 8 bytes.
+	};									// Total = 16 bytes.
+
+	// Sorting only the x axis halves the sorting work, but keeps every pair overlapping on x, so it only pays off in
+	// worlds that are short along y.
+	SweepAndPruneBroadphase(bool a_sortBothAxes = true);
+	~SweepAndPruneBroadphase() = default;
+
+	// Inherited via IBroadphase.
+	void Update(const std::vector<BroadphaseProxy>& a_proxies) override;
+	void QueryPairs(std::vector<BroadphasePair>& a_pairs) const override;
+	void QueryRegion(const AABB& a_region, std::vector<unsigned int>& a_proxyIndices) const override;
+
+	// Overlaps that started and ended during the last update.
+	const std::vector<EntityPair>& GetAddedPairs() const { return m_addedPairs; }
+	const std::vector<EntityPair>& GetRemovedPairs() const { return m_removedPairs; }
+
+	size_t GetPairCount() const { return m_pairStates.size(); }
+
+private:
+	// A min or max endpoint of a proxy along an axis. The entity and the endpoint kind are packed together, with the
+	// lowest bit set for max endpoints.
+	struct Endpoint final
+	{
+		float value = 0.0f;				// 4 bytes.
+		unsigned int data = 0;			// 4 bytes.
+	};									// Total = 8 bytes.
+
+	// Bits of a pair state.
+	static constexpr unsigned char PAIR_OVERLAPPING = 1 << 0;		// The pair overlaps now.
+	static constexpr unsigned char PAIR_WAS_OVERLAPPING = 1 << 1;	// The pair overlapped at the start of the update.
+
+	// When more than this fraction of the proxies is new, sorting from scratch beats inserting them one by one.
+	static constexpr size_t REBUILD_NEW_PROXY_DIVISOR = 8;
+
+	static bool IsMaxEndpoint(const Endpoint& an_endpoint) { return (an_endpoint.data & 1) != 0; }
+	static Entity GetEndpointEntity(const Endpoint& an_endpoint) { return an_endpoint.data >> 1; }
+	static bool EndpointLess(const Endpoint& an_endpoint1, const Endpoint& an_endpoint2);
+	static uint64_t GetPairKey(Entity an_entity1, Entity an_entity2);
+
+	float GetEndpointValue(const Endpoint& an_endpoint, int an_axis) const;
+	bool TestInteraction(Entity an_entity1, Entity an_entity2) const;
+	bool TestPreviousInteraction(Entity an_entity1, Entity an_entity2) const;
+
+	void RemoveStaleEntities();
+	void InsertionSortAxis(int an_axis);
+	void RebuildPairs();
+	void AddPair(Entity an_entity1, Entity an_entity2);
+	void RemovePair(Entity an_entity1, Entity an_entity2);
+	void CollectPairDeltas();
+
+private:
+	int m_axisCount = 2;
+	unsigned int m_updateStamp = 1;					// Starts above the stamp of unseen entities, see Update.
+	float m_maxWidth = 0.0f;						// Widest proxy, bounds how far back a region query looks.
+
+	std::vector<Endpoint> m_endpoints[2];			// Sorted endpoints of every live entity, per axis.
+	std::vector<AABB> m_entityBounds;				// Current bounds of every entity, indexed by entity.
+	std::vector<AABB> m_entityPreviousBounds;		// Bounds of every entity in the previous update, indexed by entity.
+	std::vector<CollisionFilter> m_entityFilters;	// Collision filter of every entity, indexed by entity.
+	std::vector<unsigned int> m_entityProxyIndices;	// Index of every entity in the current proxy list, indexed by entity.
+	std::vector<unsigned int> m_entityStamps;		// Update during which every entity was last seen, indexed by entity.
+	std::vector<Entity> m_liveEntities;				// Entities currently tracked.
+	std::vector<Entity> m_newEntities;				// Entities first seen in this update.
+	std::vector<Entity> m_changedEntities;			// Entities whose collision filter changed in this update.
+
+	std::unordered_map<uint64_t, unsigned char> m_pairStates;	// State of every pair overlapping now or at the start of the update.
+	std::vector<uint64_t> m_touchedPairs;			// Pairs whose state changed during the update, may hold duplicates.
+	std::vector<EntityPair> m_addedPairs;
+	std::vector<EntityPair> m_removedPairs;
+};
@@ -0,0 +1,168 @@
+#include "PCH.h"
+#include "UniformGridBroadphase.h"
+
+UniformGridBroadphase::UniformGridBroadphase(float a_worldWidth, float a_worldHeight, float a_cellSize)
+	: m_cellSize(a_cellSize)
+	, m_inverseCellSize(1.0f / a_cellSize)
+{
+	assert(a_cellSize > 0.0f);
+
+	// Cover the whole world with cells. Anything outside of it gets clamped into the border cells.
+	m_columnCount = static_cast<int>(ceil(fmax(a_worldWidth, a_cellSize) * m_inverseCellSize));
+	m_rowCount = static_cast<int>(ceil(fmax(a_worldHeight, a_cellSize) * m_inverseCellSize));
+	m_cellStarts.resize(static_cast<size_t>(m_columnCount) * m_rowCount + 1);
+}
+
+void UniformGridBroadphase::Update(const std::vector<BroadphaseProxy>& a_proxies)
+{
+	// Reset the cell counters.
+	std::fill(m_cellStarts.begin(), m_cellStarts.end(), 0);
+
+	// Find the cells every proxy covers, and count the entries of each cell.
+	m_proxyCellRanges.resize(a_proxies.size());
+	m_proxyBounds.resize(a_proxies.size());
+	m_proxyFilters.resize(a_proxies.size());
+	for (size_t proxyIndex = 0; proxyIndex < a_proxies.size(); ++proxyIndex)
+	{
+		const CellRange cellRange = GetCellRange(a_proxies[proxyIndex].bounds);
+		m_proxyCellRanges[proxyIndex] = cellRange;
+		m_proxyBounds[proxyIndex] = a_proxies[proxyIndex].bounds;
+		m_proxyFilters[proxyIndex] = a_proxies[proxyIndex].filter;
+
+		for (int row = cellRange.minRow; row <= cellRange.maxRow; ++row)
+		{
+			for (int column = cellRange.minColumn; column <= cellRange.maxColumn; ++column)
+			{
+				++m_cellStarts[static_cast<size_t>(row) * m_columnCount + column];
+			}
+		}
+	}
+
+	// Turn the counts into end offsets.
+	unsigned int entryCount = 0;
+	for (unsigned int& cellStart : m_cellStarts)
+	{
+		entryCount += cellStart;
+		cellStart = entryCount;
+	}
+
+	// Place every proxy in its cells, walking the end offsets back down to the start offsets.
+	m_cellEntries.resize(entryCount);
+	for (size_t proxyIndex = a_proxies.size(); proxyIndex-- > 0;)
+	{
+		const CellRange& cellRange = m_proxyCellRanges[proxyIndex];
+		for (int row = cellRange.minRow; row <= cellRange.maxRow; ++row)
+		{
+			for (int column = cellRange.minColumn; column <= cellRange.maxColumn; ++column)
+			{
+				m_cellEntries[--m_cellStarts[static_cast<size_t>(row) * m_columnCount + column]] = static_cast<unsigned int>(proxyIndex);
+			}
+		}
+	}
+}
+
+void UniformGridBroadphase::QueryPairs(std::vector<BroadphasePair>& a_pairs) const
+{
+	QueryPairsInRows(0, m_rowCount, a_pairs);
+}
+
+size_t UniformGridBroadphase::PreparePartitions(size_t a_desiredPartitionCount)
+{
+	m_partitionCount = static_cast<int>(std::min(std::max<size_t>(a_desiredPartitionCount, 1), static_cast<size_t>(m_rowCount)));
+	return m_partitionCount;
+}
+
+void UniformGridBroadphase::QueryPartitionPairs(size_t a_partitionIndex, std::vector<BroadphasePair>& a_pairs) const
+{
+	// Spread the rows evenly over the partitions.
+	const int partitionIndex = static_cast<int>(a_partitionIndex);
+	const int firstRow = partitionIndex * m_rowCount / m_partitionCount;
+	const int endRow = (partitionIndex + 1) * m_rowCount / m_partitionCount;
+	QueryPairsInRows(firstRow, endRow, a_pairs);
+}
+
+void UniformGridBroadphase::QueryPairsInRows(int a_firstRow, int an_endRow, std::vector<BroadphasePair>& a_pairs) const
+{
+	// Every pair is reported from a single cell, so disjoint row ranges report disjoint sets of pairs.
+	for (int row = a_firstRow; row < an_endRow; ++row)
+	{
+		for (int column = 0; column < m_columnCount; ++column)
+		{
+			// Get the range of entries in this cell. Entries are sorted by proxy index.
+			const size_t cellIndex = static_cast<size_t>(row) * m_columnCount + column;
+			const unsigned int cellStart = m_cellStarts[cellIndex];
+			const unsigned int cellEnd = m_cellStarts[cellIndex + 1];
+
+			for (unsigned int entry1 = cellStart; entry1 < cellEnd; ++entry1)
+			{
+				const unsigned int proxyIndex1 = m_cellEntries[entry1];
+				const CellRange& cellRange1 = m_proxyCellRanges[proxyIndex1];
+				const CollisionFilter& filter1 = m_proxyFilters[proxyIndex1];
+
+				for (unsigned int entry2 = entry1 + 1; entry2 < cellEnd; ++entry2)
+				{
+					// Skip pairs on layers that don't interact.
+					const unsigned int proxyIndex2 = m_cellEntries[entry2];
+					if (!CollisionFiltersInteract(filter1, m_proxyFilters[proxyIndex2]))
+						continue;
+
+					const CellRange& cellRange2 = m_proxyCellRanges[proxyIndex2];
+
+					// Proxies spanning several cells share more than one cell. Only report the pair from the first cell
+					// they share, the one at the larger of their minimum cell coordinates, so every pair is reported once.
+					const int firstSharedColumn = cellRange1.minColumn > cellRange2.minColumn ? cellRange1.minColumn : cellRange2.minColumn;
+					const int firstSharedRow = cellRange1.minRow > cellRange2.minRow ? cellRange1.minRow : cellRange2.minRow;
+					if (firstSharedColumn == column && firstSharedRow == row)
+					{
+						a_pairs.push_back({ proxyIndex1, proxyIndex2 });
+					}
+				}
+			}
+		}
+	}
+}
+
+void UniformGridBroadphase::QueryRegion(const AABB& a_region, std::vector<unsigned int>& a_proxyIndices) const
+{
+	const CellRange regionCellRange = GetCellRange(a_region);
+
+	for (int row = regionCellRange.minRow; row <= regionCellRange.maxRow; ++row)
+	{
+		for (int column = regionCellRange.minColumn; column <= regionCellRange.maxColumn; ++column)
+		{
+			const size_t cellIndex = static_cast<size_t>(row) * m_columnCount + column;
+			for (unsigned int entry = m_cellStarts[cellIndex]; entry < m_cellStarts[cellIndex + 1]; ++entry)
+			{
+				const unsigned int proxyIndex = m_cellEntries[entry];
+				const CellRange& proxyCellRange = m_proxyCellRanges[proxyIndex];
+
+				// Only report the proxy from the first cell it shares with the region, so it is reported once.
+				const int firstSharedColumn = proxyCellRange.minColumn > regionCellRange.minColumn ? proxyCellRange.minColumn : regionCellRange.minColumn;
+				const int firstSharedRow = proxyCellRange.minRow > regionCellRange.minRow ? proxyCellRange.minRow : regionCellRange.minRow;
+				if (firstSharedColumn == column && firstSharedRow == row && AABBOverlap(m_proxyBounds[proxyIndex], a_region))
+				{
+					a_proxyIndices.push_back(proxyIndex);
+				}
+			}
+		}
+	}
+}
+
+UniformGridBroadphase::CellRange UniformGridBroadphase::GetCellRange(const AABB& a_bounds) const
+{
+	return { GetColumn(a_bounds.minX), GetRow(a_bounds.minY), GetColumn(a_bounds.maxX), GetRow(a_bounds.maxY) };
+}
+
+int UniformGridBroadphase::GetColumn(float a_x) const
+{
+	// Clamp positions outside of the world into the border columns.
+	const int column = static_cast<int>(floor(a_x * m_inverseCellSize));
+	return column < 0 ? 0 : (column >= m_columnCount ? m_columnCount - 1 : column);
+}
+
+int UniformGridBroadphase::GetRow(float a_y) const
+{
+	// Clamp positions outside of the world into the border rows.
+	const int row = static_cast<int>(floor(a_y * m_inverseCellSize));
+	return row < 0 ? 0 : (row >= m_rowCount ? m_rowCount - 1 : row);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "PCH.h"
+#include "AABB.h"
+#include "IBroadphase.h"
+
+// Broadphase bucketing proxies into a uniform grid of square cells covering the world. Proxies are re-bucketed every
+// update with a counting sort into a flat cell array, and only proxies sharing a cell are reported as candidate pairs.
+class UniformGridBroadphase final : public IBroadphase
+{
+public:
+	UniformGridBroadphase(float a_worldWidth, float a_worldHeight, float a_cellSize);
+	~UniformGridBroadphase() = default;
+
+	// Inherited via IBroadphase.
+	void Update(const std::vector<BroadphaseProxy>& a_proxies) override;
+	void QueryPairs(std::vector<BroadphasePair>& a_pairs) const override;
+	void QueryRegion(const AABB& a_region, std::vector<unsigned int>& a_proxyIndices) const override;
+
+	// Partitions are bands of rows. Pairs spanning several bands are reported by the band of the first cell they share.
+	size_t PreparePartitions(size_t a_desiredPartitionCount) override;
+	void QueryPartitionPairs(size_t a_partitionIndex, std::vector<BroadphasePair>& a_pairs) const override;
+
+	int GetColumnCount() const { return m_columnCount; }
+	int GetRowCount() const { return m_rowCount; }
+	float GetCellSize() const { return m_cellSize; }
+
+private:
+	// Inclusive range of cells covered by a proxy.
+	struct CellRange final
+	{
+		int minColumn = 0;		// 4 bytes.
+		int minRow = 0;			// 4 bytes.
+		int maxColumn = 0;		// 4 bytes.
+		int maxRow = 0;			// 4 bytes.
+	};							// Total = 16 bytes.
+
+	void QueryPairsInRows(int a_firstRow, int an_endRow, std::vector<BroadphasePair>& a_pairs) const;
+	CellRange GetCellRange(const AABB& a_bounds) const;
+	int GetColumn(float a_x) const;
+	int GetRow(float a_y) const;
+
+private:
+	float m_cellSize = 0.0f;
+	float m_inverseCellSize = 0.0f;
+	int m_columnCount = 0;
+	int m_rowCount = 0;
+	int m_partitionCount = 1;
+
+	std::vector<unsigned int> m_cellStarts;		// Offset of the first entry of each cell, plus one trailing end offset.
+	std::vector<unsigned int> m_cellEntries;	// Proxy indices bucketed by cell.
+	std::vector<CellRange> m_proxyCellRanges;	// Cells covered by each proxy, indexed like the proxy list.
+	std::vector<AABB> m_proxyBounds;			// Bounds of each proxy, indexed like the proxy list.
+	std::vector<CollisionFilter> m_proxyFilters;	// Collision filter of each proxy, indexed like the proxy list.
+};
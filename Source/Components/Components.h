@@ -20,18 +20,18 @@ struct alignas(32) TransformComponent final
 struct alignas(16) TextureComponent final
 {
 	// Texture Id required to fetch the texture.
-	TextureId textureId = 0;									// 8 bytes.
+	TextureId textureId = INVALID_TEXTURE_ID;					// 4 bytes.
 
 	// The render priority of this texture. Lower integers get rendered first.
 	RenderOrder renderOrder = RenderOrder::UnsetRenderOrder;	// 1 byte.
-																// Total = 9 bytes.
+																// Total = 5 bytes.
 };
 
 struct alignas(64) AnimationComponent final
 {
 	// Sprite change speed.
 	size_t updateTime = 0; // In milliseconds.			// 8 bytes.
-	size_t lastUpdateTime = 0; // In milliseconds.		// 8 bytes.
+	float elapsedTime = 0.0f; // In milliseconds.		// 4 bytes. Simulated time since the last sprite change.
 
 	// Single sprite dimensions.
 	int spriteWidth = 0;								// 4 bytes.
@@ -44,13 +44,13 @@ struct alignas(64) AnimationComponent final
 	// Current row and column of the sprite sheet.
 	int currentRow = 0;									// 4 bytes.
 	int currentColumn = 0;								// 4 bytes.
-														// Total = 40 bytes.
+														// Total = 36 bytes.
 };
 
 struct alignas(16) WeaponComponent final
 {
 	unsigned int emissionCadence = 0; // Measured in milliseconds.				// 4 bytes.
-	unsigned int lastEmissionTime = 0; // Measured in milliseconds.				// 4 bytes.
+	float elapsedTime = 0.0f; // Measured in milliseconds.						// 4 bytes. Simulated time since the last emission.
 
 	int damage = 0;																// 4 bytes.
 
@@ -110,7 +110,16 @@ struct CollisionComponent final
 	// Box dimensions for AABB collision detection.
 	float colliderWidth = 0;		// 4 bytes.
 	float colliderHeight = 0;		// 4 bytes.
-};									// Total 8 bytes.
+
+	// Layer of the collider.
+	CollisionLayer layer = CollisionLayer::DefaultLayer;	// 1 byte.
+
+	// Fast movers are swept along their velocity over the frame, so they can't tunnel through thin colliders.
+	bool continuousCollision = false;						// 1 byte.
+
+	// Layers the collider may collide with. The collision layer matrix can only narrow this down.
+	unsigned short layerMask = 0xFFFF;						// 2 bytes.
+};															// Total 12 bytes.
 
 struct HealthComponent final
 {
@@ -1,5 +1,18 @@
 #include "PCH.h"
 #include "Registry.h"
+#include "Memory\AllocationCounter.h"
+
+Registry::Registry()
+{
+	// Let the event manager resolve entity tags when dispatching tag filtered pair events.
+	m_eventManager.SetEntityCategories(&m_entityTagKeys);
+}
+
+Registry::~Registry()
+{
+	// Stop the event manager from reading the tags of this registry once it's gone.
+	m_eventManager.ResetEntityCategories(&m_entityTagKeys);
+}
 
 void Registry::RunSystemsInitialize()
 {
@@ -17,14 +30,20 @@ void Registry::RunSystemsInitialize()
 
 void Registry::RunSystemsUpdate(float a_delatTime)
 {
+	PROFILE_SCOPE("Registry::RunSystemsUpdate");
+	ALLOCATION_SCOPE(AllocationTag::ECS);
+
 	// Run the update routine of a system, then process all pending events and requests it may have emitted.
-	for (const std::unique_ptr<ISystem>& system : m_systems)
+	for (size_t systemIndex = 0; systemIndex < m_systems.size(); ++systemIndex)
 	{
-		m_isInSystemUpdate = true;
-		system->Update(a_delatTime);
-		m_isInSystemUpdate = false;
+		{
+			PROFILE_SCOPE(m_systemUpdateScopeNames[systemIndex]);
+			m_isInSystemUpdate = true;
+			m_systems[systemIndex]->Update(a_delatTime);
+			m_isInSystemUpdate = false;
+		}
 
-		m_eventManager.Update();
+		UpdateEvents();
 		ProcessPendingComponents();
 		ProcessPendingEntities();
 		ProcessPendingTags();
@@ -33,34 +52,75 @@ void Registry::RunSystemsUpdate(float a_delatTime)
 
 void Registry::RunSystemsRender()
 {
+	PROFILE_SCOPE("Registry::RunSystemsRender");
+	ALLOCATION_SCOPE(AllocationTag::Render);
+
 	// Run the render routine of a system, then process all pending events and requests it may have emitted.
-	for (const std::unique_ptr<ISystem>& system : m_systems)
+	for (size_t systemIndex = 0; systemIndex < m_systems.size(); ++systemIndex)
 	{
-		m_isInSystemRender = true;
-		system->Render();
-		m_isInSystemRender = false;
+		{
+			PROFILE_SCOPE(m_systemRenderScopeNames[systemIndex]);
+			m_isInSystemRender = true;
+			m_systems[systemIndex]->Render();
+			m_isInSystemRender = false;
+		}
 
-		m_eventManager.Update();
+		UpdateEvents();
 		ProcessPendingComponents();
 		ProcessPendingEntities();
 		ProcessPendingTags();
 	}
 }
 
+// These run after every system, and most systems queue nothing. Return before opening the profiler and allocation
+// scopes when there is no work, so idle passes cost a few comparisons.
+void Registry::UpdateEvents()
+{
+	if (!m_eventManager.HasPendingEvents())
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("EventManager::Update");
+	ALLOCATION_SCOPE(AllocationTag::Events);
+	m_eventManager.Update();
+}
+
 void Registry::ProcessPendingEntities()
 {
+	if (m_removedEntities.empty() && m_addedEntities.empty())
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("Registry::ProcessPendingEntities");
+	ALLOCATION_SCOPE(AllocationTag::ECS);
 	ProcessEntityRemovals();
 	ProcessEntityAdditions();
 }
 
 void Registry::ProcessPendingComponents()
 {
+	if (m_addComponentRequests.empty() && m_removeComponentRequests.empty())
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("Registry::ProcessPendingComponents");
+	ALLOCATION_SCOPE(AllocationTag::ECS);
 	ProcessComponentAdditions();
 	ProcessComponnetRemovals();
 }
 
 void Registry::ProcessPendingTags()
 {
+	if (m_addTagRequests.empty() && m_removeTagRequests.empty())
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("Registry::ProcessPendingTags");
+	ALLOCATION_SCOPE(AllocationTag::ECS);
 	ProcessTagAdditions();
 	ProcessTagRemovals();
 }
@@ -76,10 +136,25 @@ void Registry::Shutdown()
 		m_deletedEntities.pop();
 	}
 
-	// Clear all component sets, entity component key sets, and systems.
+	// Clear all component sets, entity component key sets, entity tag key sets, and systems.
 	m_componentSets.clear();
 	m_entityComponentKeys.clear();
+	m_tagToEntityMap.clear();
+	m_entityToTagMap.clear();
+	m_entityTagKeys.clear();
 	m_systems.clear();
+
+	// Drop the requests still pending, so a registry set up again starts out empty.
+	m_addedEntities.clear();
+	m_removedEntities.clear();
+	DestroyRequests(m_addComponentRequests);
+	DestroyRequests(m_removeComponentRequests);
+	DestroyRequests(m_addTagRequests);
+	DestroyRequests(m_removeTagRequests);
+#ifdef ENGINE_PROFILER
+	m_systemUpdateScopeNames.clear();
+	m_systemRenderScopeNames.clear();
+#endif // ENGINE_PROFILER
 }
 
 Entity Registry::CreateEntity()
@@ -111,6 +186,13 @@ void Registry::RemoveEntity(Entity an_entity)
 	m_removedEntities.push_back(an_entity);
 }
 
+const TagKey& Registry::GetTagKey(Entity an_entity) const
+{
+	// Entities that never had a tag have no tag key entry.
+	static const TagKey emptyTagKey;
+	return an_entity < m_entityTagKeys.size() ? m_entityTagKeys[an_entity] : emptyTagKey;
+}
+
 void Registry::ProcessEntityAdditions()
 {
 	for (const Entity entity : m_addedEntities)
@@ -158,12 +240,21 @@ void Registry::ProcessEntityRemovals()
 		}
 		entityTags.clear();
 
+		// Reset the entity tag key set.
+		if (entity < m_entityTagKeys.size())
+		{
+			m_entityTagKeys[entity].reset();
+		}
+
 		// Remove the entity from all systems.
 		for (std::unique_ptr<ISystem>& genericSystem : m_systems)
 		{
 			genericSystem->RemoveEntity(entity);
 		}
 
+		// Drop the event subscriptions filtered on the entity, they must not carry over to an entity recycling its id.
+		m_eventManager.RemoveEntitySubscriptions(entity);
+
 		// Reset the entity component key set.
 		m_entityComponentKeys[entity].reset();
 
@@ -178,48 +269,48 @@ void Registry::ProcessEntityRemovals()
 void Registry::ProcessTagAdditions()
 {
 	// Execute each pending entity tag add request.
-	for (std::unique_ptr<IRegistryRequestTag>& addTagRequest : m_addTagRequests)
+	for (IRegistryRequestTag* addTagRequest : m_addTagRequests)
 	{
 		addTagRequest->Execute();
 	}
 
-	// Clear the list of pending tag requests.
-	m_addTagRequests.clear();
+	// Destroy and clear the list of pending tag requests.
+	DestroyRequests(m_addTagRequests);
 }
 
 void Registry::ProcessTagRemovals()
 {
 	// Execute each pending entity tag remove request.
-	for (std::unique_ptr<IRegistryRequestTag>& removeTagRequest : m_removeTagRequests)
+	for (IRegistryRequestTag* removeTagRequest : m_removeTagRequests)
 	{
 		removeTagRequest->Execute();
 	}
 
-	// Clear the list of pending tag removal requests.
-	m_removeTagRequests.clear();
+	// Destroy and clear the list of pending tag removal requests.
+	DestroyRequests(m_removeTagRequests);
 }
 
 void Registry::ProcessComponentAdditions()
 {
 	// Execute each pending component addition request.
-	for (std::unique_ptr<IRegistryRequestAddComponent>& addComponentRequest : m_addComponentRequests)
+	for (IRegistryRequestAddComponent* addComponentRequest : m_addComponentRequests)
 	{
 		addComponentRequest->Execute();
 	}
 
-	// Clear the set of pending component addition requests.
-	m_addComponentRequests.clear();
+	// Destroy and clear the set of pending component addition requests.
+	DestroyRequests(m_addComponentRequests);
 }
 
 void Registry::ProcessComponnetRemovals()
 {
 	// Execute each pending component removal request.
-	for (std::unique_ptr<IRegistryRequestRemoveComponent>& removeComponentRequest : m_removeComponentRequests)
+	for (IRegistryRequestRemoveComponent* removeComponentRequest : m_removeComponentRequests)
 	{
 		removeComponentRequest->Execute();
 	}
 
-	// Clear the set of pending component removal requests.
-	m_removeComponentRequests.clear();
+	// Destroy and clear the set of pending component removal requests.
+	DestroyRequests(m_removeComponentRequests);
 }
 
@@ -4,6 +4,8 @@
 #include "ComponentSet.h"
 #include "EventManager\EventManager.h"
 #include "Macros.h"
+#include "Memory\FrameArena.h"
+#include "Profiler\Profiler.h"
 #include "System.h"
 #include "TagIdGenerator.h"
 #include "Types.h"
@@ -119,13 +121,14 @@ class Registry final
 public:
 //--------------------------------------------------------------------------------------------------------------------------------
 
-	Registry() = default;
-	~Registry() = default;
+	Registry();
+	~Registry();
 
 	void RunSystemsInitialize();
 	void RunSystemsUpdate(float a_delatTime);
 	void RunSystemsRender();
 
+	void UpdateEvents();
 	void ProcessPendingEntities();
 	void ProcessPendingComponents();
 	void ProcessPendingTags();
@@ -164,12 +167,13 @@ public:
 
 	template<typename TTag> void AddTag(Entity an_entity, RequestPriority a_priority = RequestPriority::Deferred);
 	template<typename TTag> bool HaveTag(Entity an_entity) const;
+	const TagKey& GetTagKey(Entity an_entity) const;
 	template<typename TTag> const std::vector<Entity>& GetEntitiesWithTag();
 	template<typename TTag> void RemoveTag(Entity an_entity, RequestPriority a_priority = RequestPriority::Deferred);
 
 //--------------------------------------------------------------------------------------------------------------------------------
 
-	template<typename TSystem> void AddSystem();
+	template<typename TSystem> TSystem& AddSystem();
 	const std::vector<std::unique_ptr<ISystem>>& GetSystems() const { return m_systems; }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -190,6 +194,10 @@ public:
 
 //--------------------------------------------------------------------------------------------------------------------------------
 
+private:
+	// Destroy the pending requests, their memory goes away with the frame arena's.
+	template<typename TRequest> static void DestroyRequests(std::vector<TRequest*>& a_requests);
+
 private:
 	Entity m_nextEntity = 0;
 
@@ -200,19 +208,27 @@ private:
 
 	std::unordered_map<TagId, std::vector<Entity>> m_tagToEntityMap; // The set of all entities a tag belongs to.
 	std::unordered_map<Entity, std::vector<TagId>> m_entityToTagMap; // The set of all tags an entity has.
+	std::vector<TagKey> m_entityTagKeys; // Set bits indicate which tags are currently present on the entity.
 
 	std::vector<std::unique_ptr<ISystem>> m_systems; // The set of all entity updating and rendering systems.
 
+#ifdef ENGINE_PROFILER
+	std::vector<const char*> m_systemUpdateScopeNames; // Profiler scope names of the update routine of each system.
+	std::vector<const char*> m_systemRenderScopeNames; // Profiler scope names of the render routine of each system.
+#endif // ENGINE_PROFILER
+
 	std::vector<Entity> m_addedEntities; // The set of new entities awaiting addition into existing systems.
 	std::vector<Entity> m_removedEntities; // The set of entities awaiting complete removal.
 
 	EventManager& m_eventManager = EventManager::GetInstanceWrite();
 
-	std::vector<std::unique_ptr<IRegistryRequestAddComponent>> m_addComponentRequests; // The set of pending add component to entity requests.
-	std::vector<std::unique_ptr<IRegistryRequestRemoveComponent>> m_removeComponentRequests; // The set of pending remove component from entity requests.
+	FrameArena& m_frameArena = FrameArena::GetInstanceWrite(); // Pending requests live in the frame arena, until they execute.
+
+	std::vector<IRegistryRequestAddComponent*> m_addComponentRequests; // The set of pending add component to entity requests.
+	std::vector<IRegistryRequestRemoveComponent*> m_removeComponentRequests; // The set of pending remove component from entity requests.
 
-	std::vector<std::unique_ptr<IRegistryRequestTag>> m_addTagRequests; // The set of pending add tag to entity requests.
-	std::vector<std::unique_ptr<IRegistryRequestTag>> m_removeTagRequests; // The set of pending remove tag from entity requests.
+	std::vector<IRegistryRequestTag*> m_addTagRequests; // The set of pending add tag to entity requests.
+	std::vector<IRegistryRequestTag*> m_removeTagRequests; // The set of pending remove tag from entity requests.
 
 	bool m_isInSystemUpdate = false; // Is the registry in the middle of some system update routine.
 	bool m_isInSystemRender = false; // Is the registry in the middle of some system render routine.
@@ -324,23 +340,11 @@ void Registry::AddTag(Entity an_entity, RequestPriority a_priority)
 template<typename TTag>
 bool Registry::HaveTag(Entity an_entity) const
 {
-	bool foundTag = false;
-
-	// Search for an entry of this entity in the entity-tag map.
-	const auto iterator = m_entityToTagMap.find(an_entity);
-	if (iterator != m_entityToTagMap.end())
-	{
-		// Get the entity tag list.
-		const std::vector<TagId>& entityTagIds = iterator->second;
-
-		// Get the tag id.
-		static const TagId tagId = TagIdGenerator::GetTagId<TTag>();
-
-		// Search for the corresponding tag id in the entity's tag id list.
-		foundTag = std::find(entityTagIds.begin(), entityTagIds.end(), tagId) != entityTagIds.end();
-	}
+	// Get the tag id.
+	static const TagId tagId = TagIdGenerator::GetTagId<TTag>();
 
-	return foundTag;
+	// Check the tag key for presence of the corresponding tag id.
+	return an_entity < m_entityTagKeys.size() && m_entityTagKeys[an_entity].test(tagId);
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -377,27 +381,30 @@ void Registry::RemoveTag(Entity an_entity, RequestPriority a_priority)
 //--------------------------------------------------------------------------------------------------------------------------------
 
 template<typename TSystem>
-void Registry::AddSystem()
+TSystem& Registry::AddSystem()
 {
 	auto system = new TSystem(*this);
 	std::unique_ptr<ISystem> genericSystem(static_cast<ISystem*>(system));
 	m_systems.push_back(std::move(genericSystem));
+
+#ifdef ENGINE_PROFILER
+	// Name the system's routines once, rather than every time they are profiled.
+	Profiler& profiler = Profiler::GetInstanceWrite();
+	m_systemUpdateScopeNames.push_back(profiler.InternName(std::string(typeid(TSystem).name()) + "::Update"));
+	m_systemRenderScopeNames.push_back(profiler.InternName(std::string(typeid(TSystem).name()) + "::Render"));
+#endif // ENGINE_PROFILER
+
+	// Hand the system back so the caller can configure it before initialization.
+	return *system;
 }
 
 template<typename TComponent>
 inline void Registry::HandleAddComponentDeferred(Entity an_entity, const TComponent& a_component)
 {
-// Initially allocating a component on the heap my cause it to not be byte aligned as declared,
-// but this is temporary as the component will be placed in the appropriate array where they will reside byte aligned.
-#pragma warning(disable : 4316)
-	// Allocate the component addition request.
-	RegistryRequestAddComponent<TComponent, decltype(&Registry::HandleAddComponentImmediate<TComponent>)>* newRegistryRequest
-		= new RegistryRequestAddComponent<TComponent, decltype(&Registry::HandleAddComponentImmediate<TComponent>)>(this, &Registry::HandleAddComponentImmediate<TComponent>, an_entity, a_component);
-#pragma warning(default : 4316)
-
-	// Wrap the request in a unique pointer, and add it to the set of pending component additions.
-	std::unique_ptr<IRegistryRequestAddComponent> genericRequest(static_cast<IRegistryRequestAddComponent*>(newRegistryRequest));
-	m_addComponentRequests.push_back(std::move(genericRequest));
+	// Allocate the component addition request from the frame arena, which keeps it byte aligned as declared, and add it
+	// to the set of pending component additions.
+	using Request = RegistryRequestAddComponent<TComponent, decltype(&Registry::HandleAddComponentImmediate<TComponent>)>;
+	m_addComponentRequests.push_back(m_frameArena.New<Request>(this, &Registry::HandleAddComponentImmediate<TComponent>, an_entity, a_component));
 }
 
 template<typename TComponent>
@@ -441,13 +448,9 @@ inline void Registry::HandleAddComponentImmediate(Entity an_entity, const TCompo
 template<typename TComponent>
 inline void Registry::HandleRemoveComponentDeferred(Entity an_entity)
 {
-	// Allocate the component removal request.
-	RegistryRequestRemoveComponent<TComponent, decltype(&Registry::HandleRemoveComponenImmediate<TComponent>)>* newRegistryRequest
-		= new RegistryRequestRemoveComponent<TComponent, decltype(&Registry::HandleRemoveComponenImmediate<TComponent>)>(this, &Registry::HandleRemoveComponenImmediate<TComponent>, an_entity);
-
-	// Wrap the request in a unique pointer, and add it to the set of pending component removals.
-	std::unique_ptr<IRegistryRequestRemoveComponent> genericRequest(static_cast<IRegistryRequestRemoveComponent*>(newRegistryRequest));
-	m_removeComponentRequests.push_back(std::move(genericRequest));
+	// Allocate the component removal request from the frame arena, and add it to the set of pending component removals.
+	using Request = RegistryRequestRemoveComponent<TComponent, decltype(&Registry::HandleRemoveComponenImmediate<TComponent>)>;
+	m_removeComponentRequests.push_back(m_frameArena.New<Request>(this, &Registry::HandleRemoveComponenImmediate<TComponent>, an_entity));
 }
 
 template<typename TComponent>
@@ -502,13 +505,9 @@ inline void Registry::HandleRemoveComponenImmediate(Entity an_entity)
 template<typename TTag>
 inline void Registry::HandleAddTagDeferred(Entity an_entity)
 {
-	// Allocate the tag addition request.
-	RegistryRequestTag<TTag, decltype(&Registry::HandleAddTagImmediate<TTag>)>* newRegistryRequest
-		= new RegistryRequestTag<TTag, decltype(&Registry::HandleAddTagImmediate<TTag>)>(this, &Registry::HandleAddTagImmediate<TTag>, an_entity);
-
-	// Wrap the request in a unique pointer, and add it to the set of pending tag additions.
-	std::unique_ptr<IRegistryRequestTag> genericRequest(static_cast<IRegistryRequestTag*>(newRegistryRequest));
-	m_addTagRequests.push_back(std::move(genericRequest));
+	// Allocate the tag addition request from the frame arena, and add it to the set of pending tag additions.
+	using Request = RegistryRequestTag<TTag, decltype(&Registry::HandleAddTagImmediate<TTag>)>;
+	m_addTagRequests.push_back(m_frameArena.New<Request>(this, &Registry::HandleAddTagImmediate<TTag>, an_entity));
 }
 
 template<typename TTag>
@@ -522,24 +521,30 @@ inline void Registry::HandleAddTagImmediate(Entity an_entity)
 
 	// Get the tag id.
 	static const TagId tagId = TagIdGenerator::GetTagId<TTag>();
+	assert(tagId < TAG_COUNT);
 
 	// Append the entity to the list of entities with this tag.
 	m_tagToEntityMap[tagId].push_back(an_entity);
 
 	// Append the tag id to the list of tags the entity has.
 	m_entityToTagMap[an_entity].push_back(tagId);
+
+	// Make room for the entity tag key if necessary.
+	if (an_entity >= m_entityTagKeys.size())
+	{
+		m_entityTagKeys.resize(an_entity * 2 + 1);
+	}
+
+	// Mark the tag as present in the entity tag key.
+	m_entityTagKeys[an_entity].set(tagId);
 }
 
 template<typename TTag>
 inline void Registry::HandleRemoveTagDeferred(Entity an_entity)
 {
-	// Allocate the tag addition request.
-	RegistryRequestTag<TTag, decltype(&Registry::HandleRemoveTagImmediate<TTag>)>* newRegistryRequest
-		= new RegistryRequestTag<TTag, decltype(&Registry::HandleRemoveTagImmediate<TTag>)>(this, &Registry::HandleRemoveTagImmediate<TTag>, an_entity);
-
-	// Wrap the request in a unique pointer, and add it to the set of pending tag additions.
-	std::unique_ptr<IRegistryRequestTag> genericRequest(static_cast<IRegistryRequestTag*>(newRegistryRequest));
-	m_removeTagRequests.push_back(std::move(genericRequest));
+	// Allocate the tag removal request from the frame arena, and add it to the set of pending tag removals.
+	using Request = RegistryRequestTag<TTag, decltype(&Registry::HandleRemoveTagImmediate<TTag>)>;
+	m_removeTagRequests.push_back(m_frameArena.New<Request>(this, &Registry::HandleRemoveTagImmediate<TTag>, an_entity));
 }
 
 template<typename TTag>
@@ -548,8 +553,11 @@ inline void Registry::HandleRemoveTagImmediate(Entity an_entity)
 	// We cannot remove tags when in the middle of a system update or render routine.
 	assert(!m_isInSystemUpdate && !m_isInSystemRender);
 
-	// Check if we have the tag we are removing in the first place.
+	// Check if we have the tag we are removing in the first place. Entities past the tag keys, or without the tag, have
+	// nothing to remove, and going on would write past the tag keys and erase end iterators in release builds.
 	assert(HaveTag<TTag>(an_entity));
+	if (!HaveTag<TTag>(an_entity))
+		return;
 
 	// Get the tag id.
 	static const TagId tagId = TagIdGenerator::GetTagId<TTag>();
@@ -573,15 +581,18 @@ inline void Registry::HandleRemoveTagImmediate(Entity an_entity)
 	if (tagSetIterator != m_entityToTagMap.end())
 	{
 		// Get the set of tags that this entity has.
-		const std::vector<TagId>& entityTags = tagSetIterator->second;
+		std::vector<TagId>& entityTags = tagSetIterator->second;
 
 		// Find the tag that we want to erase.
 		const auto tagIterator = std::find(entityTags.begin(), entityTags.end(), tagId);
 
 		// Erase the tag from the set of tags this entity has.
-		m_entityToTagMap.erase(tagIterator);
+		entityTags.erase(tagIterator);
 	}
 
+	// Clear the tag from the entity tag key.
+	m_entityTagKeys[an_entity].reset(tagId);
+
 	// We should always find the tag in either both sets or neither.
 	assert((entitySetIterator == m_tagToEntityMap.find(tagId) && tagSetIterator == m_entityToTagMap.find(an_entity)) ||
 		(entitySetIterator != m_tagToEntityMap.find(tagId) && tagSetIterator != m_entityToTagMap.find(an_entity)));
@@ -589,3 +600,12 @@ inline void Registry::HandleRemoveTagImmediate(Entity an_entity)
 
 //--------------------------------------------------------------------------------------------------------------------------------
 
+template<typename TRequest>
+inline void Registry::DestroyRequests(std::vector<TRequest*>& a_requests)
+{
+	for (TRequest* request : a_requests)
+	{
+		request->~TRequest();
+	}
+	a_requests.clear();
+}
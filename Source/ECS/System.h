@@ -19,14 +19,20 @@ public:
 	virtual void Update(float a_deltaTime) = 0;
 	virtual void Render() = 0;
 
-	void AddEntity(Entity an_entity) { m_entities.insert(an_entity); }
-	void RemoveEntity(Entity an_entity) { m_entities.erase(an_entity); }
+	void AddEntity(Entity an_entity) { if (m_entities.insert(an_entity).second) OnEntityAdded(an_entity); }
+	void RemoveEntity(Entity an_entity) { if (m_entities.erase(an_entity) > 0) OnEntityRemoved(an_entity); }
 
 	const ComponentKey& GetRequiredComponents() const { return m_requiredComponents; }
 
 protected:
 	template<typename TComponent> void RequireComponent();
 
+	// Called once an entity starts being processed by this system. Its tags may not be in yet.
+	virtual void OnEntityAdded(Entity an_entity) {}
+
+	// Called once an entity is no longer processed by this system, because it was destroyed or lost a required component.
+	virtual void OnEntityRemoved(Entity an_entity) {}
+
 protected:
 	std::set<Entity> m_entities;		// The set of entities processed by this system.
 	ComponentKey m_requiredComponents;	// The set of all required components to process an entity.
@@ -7,3 +7,6 @@ using TagId = size_t;
 constexpr size_t COMPONENT_COUNT = 16;
 using ComponentKey = std::bitset<COMPONENT_COUNT>;
 
+constexpr size_t TAG_COUNT = 16;
+using TagKey = std::bitset<TAG_COUNT>;
+
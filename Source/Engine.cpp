@@ -2,9 +2,14 @@
 #include "Engine.h"
 #include "EventManager\EventManager.h"
 #include "Events\Events.h"
+#include "Memory\AllocationTracker.h"
+#include "Memory\FrameArena.h"
 #include "Constants\Constants.h"
 #include "TextureManager\TextureManager.h"
 #include "Components\Components.h"
+#include "Profiler\Profiler.h"
+#include "Systems\TextureRenderSystem.h"
+#include "Timing.h"
 
 Engine::Engine()
 	: m_sceneManager(m_registry)
@@ -13,9 +18,27 @@ Engine::Engine()
 
 void Engine::Initialize()
 {
-	InitializeWindow();
+	PROFILE_THREAD("Main");
+
+	if (m_renderBackend == RenderBackend::WindowBackend)
+		InitializeWindow();
+	else
+		InitializeHeadless();
 	SubscribeToEvents();
+
+	// One worker per hardware thread, the main thread works alongside them.
+	const unsigned int hardwareThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	m_jobPool.Initialize(hardwareThreadCount - 1, m_isThreadPinningEnabled);
+
 	m_sceneManager.Initialize();
+
+	// Frames are only recorded from here on, and played back on the main thread unless the render thread was asked for.
+	// SDL wants rendering on the main thread, so the window backend never gets one, and the headless backends only on
+	// request.
+	m_renderThread.Initialize(m_renderer.get(), m_isRenderThreadEnabled && m_renderBackend != RenderBackend::WindowBackend);
+
+	// Simulated time starts now, rather than counting the time spent loading.
+	m_lastUpdateTicks = SDL_GetPerformanceCounter();
 	m_isRunning = true;
 }
 
@@ -23,16 +46,67 @@ void Engine::Run()
 {
 	while (m_isRunning)
 	{
+		PROFILE_FRAME();
+
 		ProcessInput();
 		Update();
 		Render();
+
+		{
+			ALLOCATION_SCOPE(AllocationTag::Events);
+			EventManager::GetInstanceWrite().EndFrame();
+		}
+		FrameArena::GetInstanceWrite().EndFrame();
+#ifdef ENGINE_ALLOCATION_TRACKING
+		AllocationTracker::GetInstanceWrite().EndFrame();
+#endif // ENGINE_ALLOCATION_TRACKING
+
+		// Stop once the requested number of frames ran.
+		++m_runStatistics.frameCount;
+		if (m_frameLimit > 0 && m_runStatistics.frameCount >= m_frameLimit)
+			m_isRunning = false;
 	}
+
+	// Let the last frame finish drawing.
+	m_renderThread.WaitForIdle();
+
+	// Report on timed and headless runs, which are there to be measured.
+	if (m_frameLimit > 0 || m_renderBackend != RenderBackend::WindowBackend)
+		ReportRun();
 }
 
 void Engine::Shutdown()
 {
+#ifdef ENGINE_EVENT_STATS
+	// Dump the event bus instrumentation gathered over the session.
+	const EventStatistics& eventStatistics = EventManager::GetInstanceRead().GetStatisticsRead();
+	eventStatistics.WriteEventsCsv("./EventStatistics_Events.csv");
+	eventStatistics.WriteHandlersCsv("./EventStatistics_Handlers.csv");
+	eventStatistics.WriteJson("./EventStatistics.json");
+#endif // ENGINE_EVENT_STATS
+
+#ifdef ENGINE_PROFILER
+	// Dump the scopes captured over the last frames, the workers and the render thread are idle by now.
+	const Profiler& profiler = Profiler::GetInstanceRead();
+	profiler.WriteChromeTrace("./ProfileTrace.json");
+	profiler.WriteFrameSummaryCsv("./ProfileFrames.csv");
+#endif // ENGINE_PROFILER
+
+#ifdef ENGINE_ALLOCATION_TRACKING
+	// Dump what every subsystem allocated in the last frames, next to the profiler captures.
+	AllocationTracker::GetInstanceRead().WriteFramesCsv("./AllocationFrames.csv");
+#endif // ENGINE_ALLOCATION_TRACKING
+
+	// Stop the workers and the render thread before anything they may be using goes away.
+	m_jobPool.Shutdown();
+	m_renderThread.Shutdown();
+
+	// Tear the scene down while the renderer is still there, as systems may own textures.
+	m_sceneManager.Shutdown();
+
 	// Release all allocated resources and shutdown SDL.
 	m_renderer.reset();
+	m_renderSurface.reset();
 	m_window.reset();
 	SDL_Quit();
 }
@@ -57,6 +131,9 @@ void Engine::OnKeyUp(const KeyUpEvent& a_keyUpEvent)
 
 void Engine::ProcessInput()
 {
+	PROFILE_SCOPE("Engine::ProcessInput");
+	ALLOCATION_SCOPE(AllocationTag::Events);
+
 	// Event manager to notify all event subscribers
 	static EventManager& eventManager = EventManager::GetInstanceWrite();
 
@@ -80,6 +157,12 @@ void Engine::ProcessInput()
 			eventManager.EmitEvent<KeyUpEvent>({ sdlEvent.key.keysym.sym }, EventPriority::Immediate);
 			break;
 		}
+		case SDL_RENDER_TARGETS_RESET:
+		case SDL_RENDER_DEVICE_RESET:
+		{
+			eventManager.EmitEvent<RenderTargetsResetEvent>({}, EventPriority::Immediate);
+			break;
+		}
 		default:
 			break;
 		}
@@ -88,26 +171,49 @@ void Engine::ProcessInput()
 
 void Engine::Update()
 {
-#ifdef _DEBUG
-	const float deltaTime = static_cast<float>(fmin(0.05f, (SDL_GetTicks() - m_lastUpdateTime) / 1000.0f));
-#else
-	const float deltaTime = static_cast<float>(SDL_GetTicks() - m_lastUpdateTime) / 1000.0f;
-#endif // _DEBUG
+	PROFILE_SCOPE("Engine::Update");
+	static const double secondsPerTick = 1.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
 
-	m_sceneManager.Update(deltaTime);
+	// Bank the real time since the last update. A long stall, like a breakpoint or a dragged window, is capped so the
+	// simulation falls behind instead of trying to catch up in a burst of steps that makes the next frame slow too.
+	const double elapsedTime = static_cast<double>(startTicks - m_lastUpdateTicks) * secondsPerTick;
+	m_accumulatedTime += std::min(elapsedTime, m_simulationStep * MAX_STEPS_PER_FRAME);
+	m_lastUpdateTicks = startTicks;
 
-	m_lastUpdateTime = SDL_GetTicks();
+	// Simulate the banked time in whole steps, so the results don't depend on the frame rate.
+	unsigned int stepCount = 0;
+	while (m_accumulatedTime >= m_simulationStep && stepCount < MAX_STEPS_PER_FRAME)
+	{
+		m_sceneManager.Update(static_cast<float>(m_simulationStep));
+		m_accumulatedTime -= m_simulationStep;
+		++stepCount;
+	}
+
+	// What is left over is how far the frame lies past the last step, which rendering interpolates towards.
+	m_interpolationAlpha = static_cast<float>(std::min(1.0, m_accumulatedTime / m_simulationStep));
+
+	m_runStatistics.stepCount += stepCount;
+	m_runStatistics.updateMilliseconds += MillisecondsSince(startTicks);
 }
 
 void Engine::Render()
 {
-	// Set the render window draw color.
-	SDL_SetRenderDrawColor(m_renderer.get(), 0, 0, 255, 255);
+	PROFILE_SCOPE("Engine::Render");
+	ALLOCATION_SCOPE(AllocationTag::Render);
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
 
-	// Clear the render window.
-	SDL_RenderClear(m_renderer.get());
+	// Clear the render window, recorded along with the rest of the frame.
+	m_renderThread.GetRecordingBufferWrite().RecordClear({ 0, 0, 255, 255 });
 
 	m_sceneManager.Render();
+
+	// Tally what the scene drew.
+	if (const TextureRenderSystem* textureRenderSystem = m_sceneManager.GetTextureRenderSystemRead())
+	{
+		m_runStatistics.drawCallCount += textureRenderSystem->GetBatchStatisticsRead().drawCallCount;
+		m_runStatistics.quadCount += textureRenderSystem->GetBatchStatisticsRead().quadCount;
+	}
 	/*
 	static const auto once = [&m_registry = const_cast<Registry&>(m_registry)]() -> bool
 		{
@@ -131,8 +237,16 @@ void Engine::Render()
 	SDL_Rect rect = { 50, 50, 4, 4, };
 	SDL_RenderCopy(m_renderer.get(), texture, nullptr, &rect);
 	*/
-	// Swap the SDL front and back buffers in the window.
-	SDL_RenderPresent(m_renderer.get());
+	// Hand the frame over to be drawn and presented while the next one is simulated.
+	m_renderThread.SubmitFrame();
+	m_runStatistics.recordMilliseconds += MillisecondsSince(startTicks);
+
+	// Dumping reads the surface the frame is drawn into, so the frame has to be done first.
+	if (!m_frameDumpDirectory.empty() && m_renderBackend == RenderBackend::SoftwareBackend)
+	{
+		m_renderThread.WaitForIdle();
+		DumpFrame();
+	}
 }
 
 void Engine::InitializeWindow()
@@ -177,6 +291,61 @@ void Engine::InitializeWindow()
 	}
 }
 
+void Engine::InitializeHeadless()
+{
+	// The dummy video driver needs no display, and still delivers the events the engine polls for.
+	SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0)
+	{
+		fprintf(stderr, "Error initializing SDL: %s\n", SDL_GetError());
+		assert(false);
+		exit(EXIT_FAILURE);
+	}
+
+	// Draw into a surface the size of the window.
+	m_renderSurface.reset(SDL_CreateRGBSurfaceWithFormat(0, m_windowWidth, m_windowHeight, 32, SDL_PIXELFORMAT_ARGB8888));
+	if (!m_renderSurface)
+	{
+		fprintf(stderr, "Error creating render surface: %s\n", SDL_GetError());
+		assert(false);
+		exit(EXIT_FAILURE);
+	}
+
+	m_renderer.reset(SDL_CreateSoftwareRenderer(m_renderSurface.get()));
+	if (!m_renderer)
+	{
+		fprintf(stderr, "Error creating software renderer: %s\n", SDL_GetError());
+		assert(false);
+		exit(EXIT_FAILURE);
+	}
+}
+
+void Engine::DumpFrame()
+{
+	// Frames are numbered from one, in the order they were drawn.
+	char framePath[512] = { '\0' };
+	snprintf(framePath, sizeof(framePath), "%s/Frame%06zu.png", m_frameDumpDirectory.c_str(), m_runStatistics.frameCount + 1);
+	if (IMG_SavePNG(m_renderSurface.get(), framePath) != 0)
+		fprintf(stderr, "Failed to write frame %s: %s\n", framePath, IMG_GetError());
+}
+
+void Engine::ReportRun() const
+{
+	const char* backendNames[] = { "window", "software", "null" };
+	const double frameCount = static_cast<double>(std::max<size_t>(1, m_runStatistics.frameCount));
+	printf("\nRun: %zu frames on the %s backend, %s\n", m_runStatistics.frameCount, backendNames[static_cast<int>(m_renderBackend)],
+		m_renderThread.IsThreaded() ? "drawn on the render thread" : "drawn on the main thread");
+	printf("%16s %16s %16s %16s %16s %16s %16s\n", "steps/frame", "update ms/frame", "record ms/frame", "wait ms/frame", "draw ms/frame", "draws/frame", "quads/frame");
+	printf("%16.2f %16.4f %16.4f %16.4f %16.4f %16.1f %16.1f\n",
+		m_runStatistics.stepCount / frameCount,
+		m_runStatistics.updateMilliseconds / frameCount,
+		m_runStatistics.recordMilliseconds / frameCount,
+		m_renderThread.GetWaitMilliseconds() / frameCount,
+		m_renderThread.GetExecuteMilliseconds() / frameCount,
+		m_runStatistics.drawCallCount / frameCount,
+		m_runStatistics.quadCount / frameCount);
+}
+
 void Engine::SubscribeToEvents()
 {
 	// Subscribe callbacks to the desired events.
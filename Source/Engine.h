@@ -1,6 +1,10 @@
 #pragma once
+#include "Collision\SpatialIndex.h"
+#include "Enums\Enums.h"
 #include "Events\Events.h"
+#include "Jobs\JobPool.h"
 #include "Macros.h"
+#include "Rendering\RenderThread.h"
 #include "SceneManager\SceneManager.h"
 #include "TileManager\TileManager.h"
 
@@ -20,6 +24,33 @@ public:
 	void OnKeyDown(const KeyDownEvent& a_keyDownEvent);
 	void OnKeyUp(const KeyUpEvent& a_keyUpEvent);
 
+	// Options for running without a window, such as on build and simulation machines. Set them before initializing.
+	void SetRenderBackend(RenderBackend a_renderBackend) { m_renderBackend = a_renderBackend; }
+	RenderBackend GetRenderBackend() const { return m_renderBackend; }
+
+	// Stop running after the number of frames, and report how long they took. Zero runs until quit.
+	void SetFrameLimit(size_t a_frameLimit) { m_frameLimit = a_frameLimit; }
+
+	// Run the simulation at a fixed number of steps per second, however fast frames are rendered.
+	void SetSimulationRate(double a_stepsPerSecond) { m_simulationStep = 1.0 / a_stepsPerSecond; }
+	float GetSimulationStep() const { return static_cast<float>(m_simulationStep); }
+
+	// How far the frame being rendered lies between the last two simulation steps, from zero to one.
+	float GetInterpolationAlpha() const { return m_interpolationAlpha; }
+
+	// Play the recorded frames back on a render thread, overlapping them with the simulation of the next frame, instead of
+	// on the main thread right after recording. Off by default: SDL requires every rendering call to come from the main
+	// thread, and a renderer used from another thread only works by luck, so this is an experiment for the headless
+	// backends only. The window backend always plays frames back on the main thread, so windowed runs get no overlap and
+	// are not sped up by the command buffers.
+	void SetRenderThreadEnabled(bool an_isRenderThreadEnabled) { m_isRenderThreadEnabled = an_isRenderThreadEnabled; }
+
+	// Keep the job system's threads on a core each, the main thread on the first one.
+	void SetThreadPinningEnabled(bool an_isThreadPinningEnabled) { m_isThreadPinningEnabled = an_isThreadPinningEnabled; }
+
+	// Write every frame drawn by the software backend as a PNG image into the directory. Empty writes nothing.
+	void SetFrameDumpDirectory(const char* a_frameDumpDirectory) { m_frameDumpDirectory = a_frameDumpDirectory; }
+
 	int GetWindowWidth() const { return m_windowWidth; }
 	int GetWindowHeight() const { return m_windowHeight; }
 
@@ -35,6 +66,15 @@ public:
 	const TileManager& GetTileManagerRead() const { return m_tileManager; }
 	TileManager& GetTileManagerWrite() { return m_tileManager; }
 
+	const SpatialIndex& GetSpatialIndexRead() const { return m_spatialIndex; }
+	SpatialIndex& GetSpatialIndexWrite() { return m_spatialIndex; }
+
+	const JobPool& GetJobPoolRead() const { return m_jobPool; }
+	JobPool& GetJobPoolWrite() { return m_jobPool; }
+
+	const RenderThread& GetRenderThreadRead() const { return m_renderThread; }
+	RenderThread& GetRenderThreadWrite() { return m_renderThread; }
+
 	int GetMapWidth() const { return m_tileManager.GetMapWidth(); }
 	int GetMapHeight() const { return m_tileManager.GetMapHeight(); }
 
@@ -44,16 +84,47 @@ private:
 	void Render();
 
 	void InitializeWindow();
+	void InitializeHeadless();
 	void SubscribeToEvents();
 
+	void DumpFrame();
+	void ReportRun() const;
+
 private:
 	Registry m_registry;
 	TileManager m_tileManager;
 	SceneManager m_sceneManager;
-
-	size_t m_lastUpdateTime = 0; // Stored in milliseconds.
+	JobPool m_jobPool;
+	RenderThread m_renderThread;
+	SpatialIndex m_spatialIndex;
+
+	static constexpr unsigned int MAX_STEPS_PER_FRAME = 5;	// Catch up steps run in a single frame at most.
+
+	double m_simulationStep = 1.0 / 60.0;	// Seconds simulated per step.
+	double m_accumulatedTime = 0.0;			// Real time not yet simulated, in seconds.
+	Uint64 m_lastUpdateTicks = 0;			// Performance counter value of the last update.
+	float m_interpolationAlpha = 0.0f;
+
+	// Timings of the frames run so far.
+	struct RunStatistics final
+	{
+		size_t frameCount = 0;				// 8 bytes.
+		size_t stepCount = 0;				// 8 bytes. Simulation steps run.
+		size_t drawCallCount = 0;			// 8 bytes. Draw calls the scene submitted, or would have on the null backend.
+		size_t quadCount = 0;				// 8 bytes.
+		double updateMilliseconds = 0.0;	// 8 bytes.
+		double recordMilliseconds = 0.0;	// 8 bytes. Recording and submitting the frame, on the main thread.
+	};										// Total = 48 bytes.
+
+	RunStatistics m_runStatistics;
+	RenderBackend m_renderBackend = RenderBackend::WindowBackend;
+	size_t m_frameLimit = 0;
+	bool m_isRenderThreadEnabled = false;
+	bool m_isThreadPinningEnabled = false;
+	std::string m_frameDumpDirectory;
 
 	std::unique_ptr<SDL_Window, void(*)(SDL_Window*)> m_window{ nullptr, SDL_DestroyWindow };
+	std::unique_ptr<SDL_Surface, void(*)(SDL_Surface*)> m_renderSurface{ nullptr, SDL_FreeSurface }; // Target of the headless backends.
 	std::unique_ptr<SDL_Renderer, void(*)(SDL_Renderer*)> m_renderer{ nullptr, SDL_DestroyRenderer };
 
 	const int m_windowWidth = 800;
@@ -19,3 +19,28 @@ enum class RenderOrder : unsigned char
 	UnsetRenderOrder
 };
 
+
+// Where the engine draws its frames.
+enum class RenderBackend : unsigned char
+{
+	WindowBackend = 0,	// A window and the default, usually hardware, renderer.
+	SoftwareBackend,	// SDL's software renderer drawing into an offscreen surface, with no window or GPU needed.
+	NullBackend			// Like the software backend, but draws are only counted and never submitted.
+};
+
+// Spatial partition used by the collision system to find the pairs of colliders that may be touching.
+enum class BroadphaseType : unsigned char
+{
+	UniformGridType = 0,
+	DynamicTreeType,
+	SweepAndPruneType
+};
+
+// Collision layer of a collider. Which layers collide with each other is decided by the collision layer matrix.
+enum class CollisionLayer : unsigned char
+{
+	DefaultLayer = 0,
+	PlayerLayer,
+	NPCLayer,
+	ProjectileLayer
+};
@@ -2,6 +2,9 @@
 #include "PCH.h"
 #include "Macros.h"
 #include "EventIdGenerator.h"
+#include "EventStatistics.h"
+#include "ECS\TagIdGenerator.h"
+#include "ECS\Types.h"
 
 //--------------------------------------------------------------------------------------------------------------------------------
 
@@ -75,6 +78,13 @@ public:
 	IEventHandler() = default;
 	virtual ~IEventHandler() = default;
 	virtual void HandleEvent(const void* an_event) const = 0;
+
+#ifdef ENGINE_EVENT_STATS
+	void SetStatistics(EventHandlerStatistics* a_statistics) { m_statistics = a_statistics; }
+
+protected:
+	EventHandlerStatistics* m_statistics = nullptr; // Where the handler records its invocation timings.
+#endif // ENGINE_EVENT_STATS
 };
 
 template<typename TEvent, typename TOwner>
@@ -104,8 +114,181 @@ void EventHandler<TEvent, TOwner>::HandleEvent(const void* an_event) const
 	// Cast the incoming event to is true type.
 	const TEvent* specificEvent = static_cast<const TEvent*>(an_event);
 
+#ifdef ENGINE_EVENT_STATS
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
+#endif // ENGINE_EVENT_STATS
+
 	// Invoke the event callback on the event.
 	(m_owner->*m_callback)(*specificEvent);
+
+#ifdef ENGINE_EVENT_STATS
+	// Record how long the callback took.
+	if (m_statistics != nullptr)
+		m_statistics->RecordInvocation(SDL_GetPerformanceCounter() - startTicks);
+#endif // ENGINE_EVENT_STATS
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// Filtered dispatch for pair events, i.e. events carrying an entity1 and entity2 member.
+class IPairEventDispatcher
+{
+public:
+	NO_COPY(IPairEventDispatcher);
+	NO_MOVE(IPairEventDispatcher);
+
+	IPairEventDispatcher() = default;
+	virtual ~IPairEventDispatcher() = default;
+	virtual void DispatchEvent(const void* an_event, const std::vector<TagKey>& an_entityCategories) const = 0;
+	virtual void RemoveEntityHandlers(Entity an_entity) = 0;
+};
+
+template<typename TEvent>
+class PairEventDispatcher final : public IPairEventDispatcher
+{
+public:
+	PairEventDispatcher();
+	~PairEventDispatcher() = default;
+
+	void AddEntityHandler(Entity an_entity, std::unique_ptr<IEventHandler> an_eventHandler);
+	void AddCategoryHandler(TagId a_category1, TagId a_category2, std::unique_ptr<IEventHandler> an_eventHandler);
+	void DispatchEvent(const void* an_event, const std::vector<TagKey>& an_entityCategories) const override;
+	void RemoveEntityHandlers(Entity an_entity) override;
+
+private:
+	struct CategoryHandler final
+	{
+		const IEventHandler* eventHandler = nullptr;	// 8 bytes.
+		bool swapEntities = false;						// 1 byte.
+	};													// Total = 9 bytes.
+
+	std::vector<std::unique_ptr<IEventHandler>> m_eventHandlers;							// Owns every filtered handler of this event type.
+	std::unordered_map<Entity, std::vector<const IEventHandler*>> m_entityHandlerMap;		// Handlers filtered on a specific entity.
+	std::vector<std::vector<CategoryHandler>> m_categoryHandlerTable;						// TAG_COUNT x TAG_COUNT table indexed by the entities' categories.
+	TagKey m_handledCategories;																// Categories with at least one handler, in either order.
+};
+
+template<typename TEvent>
+PairEventDispatcher<TEvent>::PairEventDispatcher()
+	: IPairEventDispatcher::IPairEventDispatcher()
+	, m_categoryHandlerTable(TAG_COUNT * TAG_COUNT)
+{
+}
+
+template<typename TEvent>
+void PairEventDispatcher<TEvent>::AddEntityHandler(Entity an_entity, std::unique_ptr<IEventHandler> an_eventHandler)
+{
+	// Index the handler by the entity it is interested in, and take ownership of it.
+	m_entityHandlerMap[an_entity].push_back(an_eventHandler.get());
+	m_eventHandlers.push_back(std::move(an_eventHandler));
+}
+
+template<typename TEvent>
+void PairEventDispatcher<TEvent>::AddCategoryHandler(TagId a_category1, TagId a_category2, std::unique_ptr<IEventHandler> an_eventHandler)
+{
+	assert(a_category1 < TAG_COUNT && a_category2 < TAG_COUNT);
+
+	// Register the handler in the cell matching the requested category order.
+	m_categoryHandlerTable[a_category1 * TAG_COUNT + a_category2].push_back({ an_eventHandler.get(), false });
+
+	// Register the handler in the mirrored cell as well, asking the dispatcher to swap the entities so the handler always
+	// receives the entity of the first category as entity1.
+	if (a_category1 != a_category2)
+	{
+		m_categoryHandlerTable[a_category2 * TAG_COUNT + a_category1].push_back({ an_eventHandler.get(), true });
+	}
+
+	// Update the category mask used to quickly reject events no handler cares about. Handlers sit in both orders, so a
+	// single mask covers both entities.
+	m_handledCategories.set(a_category1).set(a_category2);
+
+	m_eventHandlers.push_back(std::move(an_eventHandler));
+}
+
+template<typename TEvent>
+void PairEventDispatcher<TEvent>::RemoveEntityHandlers(Entity an_entity)
+{
+	const auto entityIterator = m_entityHandlerMap.find(an_entity);
+	if (entityIterator == m_entityHandlerMap.end())
+		return;
+
+	// Release the handlers filtered on the entity, so an entity later recycling its id doesn't inherit them.
+	for (const IEventHandler* eventHandler : entityIterator->second)
+	{
+		m_eventHandlers.erase(std::find_if(m_eventHandlers.begin(), m_eventHandlers.end(), [eventHandler](const std::unique_ptr<IEventHandler>& an_ownedHandler)
+		{
+			return an_ownedHandler.get() == eventHandler;
+		}));
+	}
+
+	m_entityHandlerMap.erase(entityIterator);
+}
+
+template<typename TEvent>
+void PairEventDispatcher<TEvent>::DispatchEvent(const void* an_event, const std::vector<TagKey>& an_entityCategories) const
+{
+	// Cast the incoming event to is true type.
+	const TEvent& specificEvent = *static_cast<const TEvent*>(an_event);
+
+	// Run the event through the handlers filtered on either of its entities.
+	if (!m_entityHandlerMap.empty())
+	{
+		const auto entity1Iterator = m_entityHandlerMap.find(specificEvent.entity1);
+		if (entity1Iterator != m_entityHandlerMap.end())
+		{
+			for (const IEventHandler* eventHandler : entity1Iterator->second)
+			{
+				eventHandler->HandleEvent(&specificEvent);
+			}
+		}
+
+		const auto entity2Iterator = specificEvent.entity2 != specificEvent.entity1 ? m_entityHandlerMap.find(specificEvent.entity2) : m_entityHandlerMap.end();
+		if (entity2Iterator != m_entityHandlerMap.end())
+		{
+			for (const IEventHandler* eventHandler : entity2Iterator->second)
+			{
+				eventHandler->HandleEvent(&specificEvent);
+			}
+		}
+	}
+
+	// Retrieve the categories of both entities, restricted to the categories that have handlers.
+	const bool haveCategories1 = specificEvent.entity1 < an_entityCategories.size();
+	const bool haveCategories2 = specificEvent.entity2 < an_entityCategories.size();
+	if (!haveCategories1 || !haveCategories2)
+		return;
+
+	const TagKey categories1 = an_entityCategories[specificEvent.entity1] & m_handledCategories;
+	const TagKey categories2 = an_entityCategories[specificEvent.entity2] & m_handledCategories;
+	if (categories1.none() || categories2.none())
+		return;
+
+	// The same event with its entities swapped, for handlers registered in the mirrored cells.
+	TEvent swappedEvent = specificEvent;
+	std::swap(swappedEvent.entity1, swappedEvent.entity2);
+
+	// Look up each category pair in the dispatch table, and run the event through the handlers found there.
+	for (TagId category1 = 0; category1 < TAG_COUNT; ++category1)
+	{
+		if (!categories1.test(category1))
+			continue;
+
+		for (TagId category2 = 0; category2 < TAG_COUNT; ++category2)
+		{
+			if (!categories2.test(category2))
+				continue;
+
+			for (const CategoryHandler& categoryHandler : m_categoryHandlerTable[category1 * TAG_COUNT + category2])
+			{
+				// A handler sits in its own cell and in the mirrored one. When the entities match the handler's category
+				// order as well, leave it to its own cell, so it handles the event only once.
+				if (categoryHandler.swapEntities && categories1.test(category2) && categories2.test(category1))
+					continue;
+
+				categoryHandler.eventHandler->HandleEvent(categoryHandler.swapEntities ? &swappedEvent : &specificEvent);
+			}
+		}
+	}
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -119,18 +302,49 @@ public:
 	~EventManager() = default;
 
 	template<typename TEvent, typename TOwner> void SubscribeToEvent(TOwner* an_owner, void(TOwner::*a_callback)(const TEvent& an_event));
+	template<typename TEvent, typename TOwner> void SubscribeToEntityEvent(Entity an_entity, TOwner* an_owner, void(TOwner::*a_callback)(const TEvent& an_event));
+	template<typename TEvent, typename TTag1, typename TTag2, typename TOwner> void SubscribeToPairEvent(TOwner* an_owner, void(TOwner::*a_callback)(const TEvent& an_event));
 	template<typename TEvent> void EmitEvent(const TEvent& an_event, EventPriority a_priority);
 
+	// Drop every subscription filtered on the entity. The registry calls this as it removes the entity.
+	void RemoveEntitySubscriptions(Entity an_entity);
+
+	// The tag key of every entity, provided by the registry, which must reset them before it goes away. Only one registry
+	// may provide them at a time.
+	void SetEntityCategories(const std::vector<TagKey>* an_entityCategories);
+	void ResetEntityCategories(const std::vector<TagKey>* an_entityCategories);
+
+	// Whether any deferred event is waiting for the next update.
+	bool HasPendingEvents() const { return m_pendingEventCount != 0; }
+
 	void Update();
+	void EndFrame();
 	void Shutdown();
 
+#ifdef ENGINE_EVENT_STATS
+	const EventStatistics& GetStatisticsRead() const { return m_statistics; }
+	EventStatistics& GetStatisticsWrite() { return m_statistics; }
+#endif // ENGINE_EVENT_STATS
+
 private:
 	template<typename TEvent> void HandleDeferredEvent(const TEvent& an_event);
 	template<typename TEvent> void HandleImmediateEvent(const TEvent& an_event);
+	template<typename TEvent> PairEventDispatcher<TEvent>& GetPairEventDispatcher();
+	template<typename TEvent, typename TOwner> void RegisterHandlerStatistics(IEventHandler& an_eventHandler, const char* a_filterName);
+
+	const std::vector<TagKey>& GetEntityCategories() const;
 	
 private:
 	std::unordered_map<EventId, std::vector<std::unique_ptr<IEventHandler>>> m_eventHandlerMap;
+	std::unordered_map<EventId, std::unique_ptr<IPairEventDispatcher>> m_pairEventDispatcherMap;
 	std::unordered_map<EventId, std::unique_ptr<IEventVector>> m_pendingEventMap;
+	size_t m_pendingEventCount = 0; // Deferred events emitted since the last update began.
+
+	const std::vector<TagKey>* m_entityCategories = nullptr; // The tag key of every entity, indexed by entity.
+
+#ifdef ENGINE_EVENT_STATS
+	EventStatistics m_statistics; // Per event type and per handler instrumentation.
+#endif // ENGINE_EVENT_STATS
 };
 
 template<typename TEvent, typename TOwner>
@@ -144,14 +358,50 @@ inline void EventManager::SubscribeToEvent(TOwner* an_owner, void(TOwner::* a_ca
 
 	// Cast the event handler to its generic version, and wrap it in a smart pointer.
 	std::unique_ptr<IEventHandler> genericEventHandler(static_cast<IEventHandler*>(eventHandler));
+	RegisterHandlerStatistics<TEvent, TOwner>(*genericEventHandler, "");
 
 	// Move the event handler into the current set of event handlers for this event.
 	m_eventHandlerMap[eventId].push_back(std::move(genericEventHandler));
 }
 
+template<typename TEvent, typename TOwner>
+inline void EventManager::SubscribeToEntityEvent(Entity an_entity, TOwner* an_owner, void(TOwner::* a_callback)(const TEvent& an_event))
+{
+	// Allocate the corresponding event handler, and wrap it in a smart pointer.
+	std::unique_ptr<IEventHandler> genericEventHandler(static_cast<IEventHandler*>(new EventHandler<TEvent, TOwner>(an_owner, a_callback)));
+	RegisterHandlerStatistics<TEvent, TOwner>(*genericEventHandler, " [entity]");
+
+	// Hand the event handler over to the filtered dispatcher of this event, keyed by the entity of interest.
+	GetPairEventDispatcher<TEvent>().AddEntityHandler(an_entity, std::move(genericEventHandler));
+}
+
+template<typename TEvent, typename TTag1, typename TTag2, typename TOwner>
+inline void EventManager::SubscribeToPairEvent(TOwner* an_owner, void(TOwner::* a_callback)(const TEvent& an_event))
+{
+	// Get the tag ids acting as the entity categories.
+	static const TagId tagId1 = TagIdGenerator::GetTagId<TTag1>();
+	static const TagId tagId2 = TagIdGenerator::GetTagId<TTag2>();
+
+	// Allocate the corresponding event handler, and wrap it in a smart pointer.
+	std::unique_ptr<IEventHandler> genericEventHandler(static_cast<IEventHandler*>(new EventHandler<TEvent, TOwner>(an_owner, a_callback)));
+#ifdef ENGINE_EVENT_STATS
+	const std::string filterName = std::string(" [") + typeid(TTag1).name() + ", " + typeid(TTag2).name() + "]";
+	RegisterHandlerStatistics<TEvent, TOwner>(*genericEventHandler, filterName.c_str());
+#endif // ENGINE_EVENT_STATS
+
+	// Hand the event handler over to the filtered dispatcher of this event, keyed by the pair of tags.
+	GetPairEventDispatcher<TEvent>().AddCategoryHandler(tagId1, tagId2, std::move(genericEventHandler));
+}
+
 template<typename TEvent>
 void EventManager::EmitEvent(const TEvent& an_event, EventPriority a_priority)
 {
+#ifdef ENGINE_EVENT_STATS
+	// Count the emission against the event type.
+	static const EventId eventId = EventIdGenerator::GetEventId<TEvent>();
+	m_statistics.RecordEmit(eventId, typeid(TEvent).name(), a_priority == EventPriority::Deferred);
+#endif // ENGINE_EVENT_STATS
+
 	// Check the priority of the event and handle it accordingly.
 	switch (a_priority)
 	{
@@ -183,6 +433,12 @@ void EventManager::HandleDeferredEvent(const TEvent& an_event)
 
 	// Add the event.
 	eventVector->AddEvent(std::move(an_event));
+	++m_pendingEventCount;
+
+#ifdef ENGINE_EVENT_STATS
+	// Track how deep the deferred queue of this event type gets.
+	m_statistics.RecordPendingDepth(eventId, eventVector->GetElementCount());
+#endif // ENGINE_EVENT_STATS
 }
 
 template<typename TEvent>
@@ -200,10 +456,75 @@ void EventManager::HandleImmediateEvent(const TEvent& an_event)
 			eventHandler->HandleEvent(&an_event);
 		}
 	}
+
+	// If we have filtered subscriptions for this event, run the event through the dispatch table.
+	const auto dispatcherIterator = m_pairEventDispatcherMap.find(eventId);
+	if (dispatcherIterator != m_pairEventDispatcherMap.end())
+	{
+		dispatcherIterator->second->DispatchEvent(&an_event, GetEntityCategories());
+	}
+}
+
+template<typename TEvent>
+PairEventDispatcher<TEvent>& EventManager::GetPairEventDispatcher()
+{
+	// Get the corresponding event Id.
+	static const EventId eventId = EventIdGenerator::GetEventId<TEvent>();
+
+	// If we don't have a corresponding dispatcher, create one.
+	std::unique_ptr<IPairEventDispatcher>& genericDispatcher = m_pairEventDispatcherMap[eventId];
+	if (genericDispatcher == nullptr)
+	{
+		genericDispatcher.reset(static_cast<IPairEventDispatcher*>(new PairEventDispatcher<TEvent>()));
+	}
+
+	return *static_cast<PairEventDispatcher<TEvent>*>(genericDispatcher.get());
+}
+
+template<typename TEvent, typename TOwner>
+inline void EventManager::RegisterHandlerStatistics(IEventHandler& an_eventHandler, const char* a_filterName)
+{
+#ifdef ENGINE_EVENT_STATS
+	// Name the handler after its owner, event, and filter, and point it at its statistics entry.
+	static const EventId eventId = EventIdGenerator::GetEventId<TEvent>();
+	const std::string handlerName = std::string(typeid(TOwner).name()) + " <- " + typeid(TEvent).name() + a_filterName;
+	an_eventHandler.SetStatistics(&m_statistics.RegisterHandler(eventId, handlerName));
+#endif // ENGINE_EVENT_STATS
+}
+
+inline void EventManager::SetEntityCategories(const std::vector<TagKey>* an_entityCategories)
+{
+	assert((m_entityCategories == nullptr || m_entityCategories == an_entityCategories) && "Another registry already provides the entity categories.");
+	m_entityCategories = an_entityCategories;
+}
+
+inline void EventManager::ResetEntityCategories(const std::vector<TagKey>* an_entityCategories)
+{
+	// Only let go of the categories if they are still the ones given.
+	if (m_entityCategories == an_entityCategories)
+		m_entityCategories = nullptr;
+}
+
+inline const std::vector<TagKey>& EventManager::GetEntityCategories() const
+{
+	// Without a registry to provide entity categories, every entity is treated as uncategorized.
+	static const std::vector<TagKey> noEntityCategories;
+	return m_entityCategories != nullptr ? *m_entityCategories : noEntityCategories;
+}
+
+inline void EventManager::RemoveEntitySubscriptions(Entity an_entity)
+{
+	for (std::pair<const EventId, std::unique_ptr<IPairEventDispatcher>>& dispatcherPair : m_pairEventDispatcherMap)
+	{
+		dispatcherPair.second->RemoveEntityHandlers(an_entity);
+	}
 }
 
 inline void EventManager::Update()
 {
+	// Events emitted by the handlers below count towards the next update.
+	m_pendingEventCount = 0;
+
 	// For every pending event pair...
 	for (std::pair<const EventId, std::unique_ptr<IEventVector>>& pendingEventPair : m_pendingEventMap)
 	{
@@ -221,15 +542,36 @@ inline void EventManager::Update()
 			}
 		}
 
+		// If this event type has filtered subscriptions, run each pending event through the dispatch table.
+		const auto dispatcherIterator = m_pairEventDispatcherMap.find(eventId);
+		if (dispatcherIterator != m_pairEventDispatcherMap.end())
+		{
+			const std::vector<TagKey>& entityCategories = GetEntityCategories();
+			for (size_t index = 0; index < eventVector->GetElementCount(); ++index)
+			{
+				dispatcherIterator->second->DispatchEvent(eventVector->GetEvent(index), entityCategories);
+			}
+		}
+
 		// Clear the now processed set of events.
 		eventVector->Clear();
 	}
 }
 
+inline void EventManager::EndFrame()
+{
+#ifdef ENGINE_EVENT_STATS
+	// Close the per frame event counters.
+	m_statistics.EndFrame();
+#endif // ENGINE_EVENT_STATS
+}
+
 inline void EventManager::Shutdown()
 {
 	m_eventHandlerMap.clear();
+	m_pairEventDispatcherMap.clear();
 	m_pendingEventMap.clear();
+	m_pendingEventCount = 0;
 }
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,227 @@
+#include "PCH.h"
+#include "EventStatistics.h"
+
+#ifdef ENGINE_EVENT_STATS
+
+namespace
+{
+	// Write a string as a JSON string literal, escaping the characters JSON requires.
+	void WriteJsonString(FILE* a_file, const std::string& a_string)
+	{
+		fputc('"', a_file);
+		for (const char character : a_string)
+		{
+			if (character == '"' || character == '\\')
+				fputc('\\', a_file);
+			fputc(character, a_file);
+		}
+		fputc('"', a_file);
+	}
+
+	// Write a string as a CSV field, quoting it and doubling any quotes inside.
+	void WriteCsvString(FILE* a_file, const std::string& a_string)
+	{
+		fputc('"', a_file);
+		for (const char character : a_string)
+		{
+			if (character == '"')
+				fputc('"', a_file);
+			fputc(character, a_file);
+		}
+		fputc('"', a_file);
+	}
+}
+
+void EventHandlerStatistics::RecordInvocation(Uint64 a_ticks)
+{
+	++invocationCount;
+	totalTicks += a_ticks;
+	maxTicks = a_ticks > maxTicks ? a_ticks : maxTicks;
+}
+
+void EventStatistics::RecordEmit(EventId an_eventId, const char* an_eventName, bool an_isDeferred)
+{
+	EventTypeStatistics& eventStatistics = GetEventTypeStatistics(an_eventId);
+
+	// Name the event type the first time we see it.
+	if (eventStatistics.eventName.empty())
+		eventStatistics.eventName = an_eventName;
+
+	++eventStatistics.emittedThisFrame;
+	if (an_isDeferred)
+		++eventStatistics.deferredEmitted;
+	else
+		++eventStatistics.immediateEmitted;
+}
+
+void EventStatistics::RecordPendingDepth(EventId an_eventId, size_t a_pendingDepth)
+{
+	EventTypeStatistics& eventStatistics = GetEventTypeStatistics(an_eventId);
+	eventStatistics.pendingHighWaterMark = a_pendingDepth > eventStatistics.pendingHighWaterMark ? a_pendingDepth : eventStatistics.pendingHighWaterMark;
+}
+
+EventHandlerStatistics& EventStatistics::RegisterHandler(EventId an_eventId, const std::string& a_handlerName)
+{
+	// Make sure the event type has an entry, even if it is never emitted.
+	GetEventTypeStatistics(an_eventId);
+
+	m_handlerStatistics.push_back({ a_handlerName, an_eventId });
+	return m_handlerStatistics.back();
+}
+
+void EventStatistics::EndFrame()
+{
+	// Roll the per frame counters of every event type over to the next frame.
+	for (EventTypeStatistics& eventStatistics : m_eventStatistics)
+	{
+		eventStatistics.emittedLastFrame = eventStatistics.emittedThisFrame;
+		eventStatistics.maxEmittedPerFrame = eventStatistics.emittedThisFrame > eventStatistics.maxEmittedPerFrame ? eventStatistics.emittedThisFrame : eventStatistics.maxEmittedPerFrame;
+		eventStatistics.emittedThisFrame = 0;
+	}
+
+	++m_frameCount;
+}
+
+void EventStatistics::Clear()
+{
+	for (EventTypeStatistics& eventStatistics : m_eventStatistics)
+	{
+		std::string eventName = std::move(eventStatistics.eventName);
+		eventStatistics = EventTypeStatistics();
+		eventStatistics.eventName = std::move(eventName);
+	}
+
+	for (EventHandlerStatistics& handlerStatistics : m_handlerStatistics)
+	{
+		handlerStatistics.invocationCount = 0;
+		handlerStatistics.totalTicks = 0;
+		handlerStatistics.maxTicks = 0;
+	}
+
+	m_frameCount = 0;
+}
+
+double EventStatistics::TicksToMilliseconds(Uint64 a_ticks) const
+{
+	static const double millisecondsPerTick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	return static_cast<double>(a_ticks) * millisecondsPerTick;
+}
+
+bool EventStatistics::WriteEventsCsv(const char* a_filePath) const
+{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+	FILE* file = fopen(a_filePath, "w");
+#pragma warning(default : 4996)
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s for writing.\n", a_filePath);
+		return false;
+	}
+
+	fprintf(file, "event_id,event,immediate,deferred,last_frame,max_per_frame,avg_per_frame,pending_high_water\n");
+	for (EventId eventId = 0; eventId < m_eventStatistics.size(); ++eventId)
+	{
+		const EventTypeStatistics& eventStatistics = m_eventStatistics[eventId];
+		const size_t totalEmitted = eventStatistics.immediateEmitted + eventStatistics.deferredEmitted;
+
+		fprintf(file, "%zu,", eventId);
+		WriteCsvString(file, eventStatistics.eventName);
+		fprintf(file, ",%zu,%zu,%zu,%zu,%.3f,%zu\n",
+			eventStatistics.immediateEmitted,
+			eventStatistics.deferredEmitted,
+			eventStatistics.emittedLastFrame,
+			eventStatistics.maxEmittedPerFrame,
+			m_frameCount > 0 ? static_cast<double>(totalEmitted) / m_frameCount : 0.0,
+			eventStatistics.pendingHighWaterMark);
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool EventStatistics::WriteHandlersCsv(const char* a_filePath) const
+{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+	FILE* file = fopen(a_filePath, "w");
+#pragma warning(default : 4996)
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s for writing.\n", a_filePath);
+		return false;
+	}
+
+	fprintf(file, "handler,event_id,invocations,total_ms,max_ms,avg_us\n");
+	for (const EventHandlerStatistics& handlerStatistics : m_handlerStatistics)
+	{
+		const double totalMilliseconds = TicksToMilliseconds(handlerStatistics.totalTicks);
+
+		WriteCsvString(file, handlerStatistics.handlerName);
+		fprintf(file, ",%zu,%zu,%.6f,%.6f,%.3f\n",
+			handlerStatistics.eventId,
+			handlerStatistics.invocationCount,
+			totalMilliseconds,
+			TicksToMilliseconds(handlerStatistics.maxTicks),
+			handlerStatistics.invocationCount > 0 ? totalMilliseconds * 1000.0 / handlerStatistics.invocationCount : 0.0);
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool EventStatistics::WriteJson(const char* a_filePath) const
+{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+	FILE* file = fopen(a_filePath, "w");
+#pragma warning(default : 4996)
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s for writing.\n", a_filePath);
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"frames\": %zu,\n\t\"events\": [", m_frameCount);
+	for (EventId eventId = 0; eventId < m_eventStatistics.size(); ++eventId)
+	{
+		const EventTypeStatistics& eventStatistics = m_eventStatistics[eventId];
+
+		fprintf(file, "%s\n\t\t{ \"id\": %zu, \"name\": ", eventId > 0 ? "," : "", eventId);
+		WriteJsonString(file, eventStatistics.eventName);
+		fprintf(file, ", \"immediate\": %zu, \"deferred\": %zu, \"lastFrame\": %zu, \"maxPerFrame\": %zu, \"pendingHighWater\": %zu }",
+			eventStatistics.immediateEmitted,
+			eventStatistics.deferredEmitted,
+			eventStatistics.emittedLastFrame,
+			eventStatistics.maxEmittedPerFrame,
+			eventStatistics.pendingHighWaterMark);
+	}
+
+	fprintf(file, "\n\t],\n\t\"handlers\": [");
+	for (size_t index = 0; index < m_handlerStatistics.size(); ++index)
+	{
+		const EventHandlerStatistics& handlerStatistics = m_handlerStatistics[index];
+
+		fprintf(file, "%s\n\t\t{ \"name\": ", index > 0 ? "," : "");
+		WriteJsonString(file, handlerStatistics.handlerName);
+		fprintf(file, ", \"eventId\": %zu, \"invocations\": %zu, \"totalMs\": %.6f, \"maxMs\": %.6f }",
+			handlerStatistics.eventId,
+			handlerStatistics.invocationCount,
+			TicksToMilliseconds(handlerStatistics.totalTicks),
+			TicksToMilliseconds(handlerStatistics.maxTicks));
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+	fclose(file);
+	return true;
+}
+
+EventTypeStatistics& EventStatistics::GetEventTypeStatistics(EventId an_eventId)
+{
+	// Make room for the event type if necessary.
+	if (an_eventId >= m_eventStatistics.size())
+	{
+		m_eventStatistics.resize(an_eventId + 1);
+	}
+
+	return m_eventStatistics[an_eventId];
+}
+
+#endif // ENGINE_EVENT_STATS
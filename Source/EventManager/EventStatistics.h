@@ -0,0 +1,71 @@
+#pragma once
+#include "PCH.h"
+#include "EventIdGenerator.h"
+
+// Event bus instrumentation, compiled in only when ENGINE_EVENT_STATS is defined.
+#ifdef ENGINE_EVENT_STATS
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// Emission counters and deferred queue depth of a single event type.
+struct EventTypeStatistics final
+{
+	std::string eventName;				// Name of the event type.
+	size_t emittedThisFrame = 0;		// Events emitted so far in the current frame.
+	size_t emittedLastFrame = 0;		// Events emitted in the previous frame.
+	size_t maxEmittedPerFrame = 0;		// Most events emitted in a single frame.
+	size_t immediateEmitted = 0;		// Total events emitted with immediate priority.
+	size_t deferredEmitted = 0;			// Total events emitted with deferred priority.
+	size_t pendingHighWaterMark = 0;	// Deepest the deferred queue of this event type has been.
+};
+
+// Invocation count and timings of a single event handler, measured in performance counter ticks.
+struct EventHandlerStatistics final
+{
+	std::string handlerName;			// Owner, event, and filter of the subscription.
+	EventId eventId = 0;				// The event type the handler is subscribed to.
+	size_t invocationCount = 0;			// Number of events run through the handler.
+	Uint64 totalTicks = 0;				// Cumulative time spent in the handler.
+	Uint64 maxTicks = 0;				// Longest single invocation of the handler.
+
+	void RecordInvocation(Uint64 a_ticks);
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+class EventStatistics final
+{
+public:
+	EventStatistics() = default;
+	~EventStatistics() = default;
+
+	void RecordEmit(EventId an_eventId, const char* an_eventName, bool an_isDeferred);
+	void RecordPendingDepth(EventId an_eventId, size_t a_pendingDepth);
+	EventHandlerStatistics& RegisterHandler(EventId an_eventId, const std::string& a_handlerName);
+	void EndFrame();
+
+	// Zero every counter. The entries themselves stay, as the subscribed handlers keep pointers to them.
+	void Clear();
+
+	const std::vector<EventTypeStatistics>& GetEventStatistics() const { return m_eventStatistics; }
+	const std::deque<EventHandlerStatistics>& GetHandlerStatistics() const { return m_handlerStatistics; }
+	size_t GetFrameCount() const { return m_frameCount; }
+
+	double TicksToMilliseconds(Uint64 a_ticks) const;
+
+	bool WriteEventsCsv(const char* a_filePath) const;
+	bool WriteHandlersCsv(const char* a_filePath) const;
+	bool WriteJson(const char* a_filePath) const;
+
+private:
+	EventTypeStatistics& GetEventTypeStatistics(EventId an_eventId);
+
+private:
+	std::vector<EventTypeStatistics> m_eventStatistics;		// Indexed by event id.
+	std::deque<EventHandlerStatistics> m_handlerStatistics;	// Deque so handlers can safely keep a pointer to their entry.
+	size_t m_frameCount = 0;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+#endif // ENGINE_EVENT_STATS
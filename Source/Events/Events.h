@@ -15,7 +15,38 @@ struct KeyUpEvent final
 	SDL_Keycode m_keyCode = 0;
 };
 
-struct CollisionEvent final
+// The renderer lost what was drawn into its render targets, which must be drawn again.
+struct RenderTargetsResetEvent final
+{
+};
+
+// A tile or piece of scenery moved or changed how it looks, so anything drawn ahead of time from it is stale. Emitted
+// by whoever changes it.
+struct StaticEntityChangedEvent final
+{
+	Entity entity = INVALID_ENTITY;
+};
+
+// Two colliders started touching this frame.
+struct CollisionEnterEvent final
+{
+	Entity entity1 = INVALID_ENTITY;
+	Entity entity2 = INVALID_ENTITY;
+
+	// Fraction of the frame's motion after which the colliders first touched. Only fast movers are swept, collisions
+	// between other colliders are found at the end of the frame.
+	float timeOfImpact = 1.0f;
+};
+
+// Two colliders that were already touching still are. Only emitted when the collision system is asked to.
+struct CollisionStayEvent final
+{
+	Entity entity1 = INVALID_ENTITY;
+	Entity entity2 = INVALID_ENTITY;
+};
+
+// Two colliders stopped touching this frame, or one of them was destroyed.
+struct CollisionExitEvent final
 {
 	Entity entity1 = INVALID_ENTITY;
 	Entity entity2 = INVALID_ENTITY;
@@ -0,0 +1,266 @@
+#include "PCH.h"
+#include "JobPool.h"
+#include "Profiler\Profiler.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif // _WIN32
+
+namespace
+{
+	// The pool a worker belongs to, and its index in it. Threads outside any pool have none.
+	struct PoolThread final
+	{
+		const JobPool* pool = nullptr;	// 8 bytes.
+		unsigned int threadIndex = 0;	// 4 bytes.
+	};									// Total = 16 bytes with padding.
+
+	thread_local PoolThread t_poolThread;
+}
+
+JobPool::~JobPool()
+{
+	Shutdown();
+}
+
+void JobPool::Initialize(unsigned int a_workerCount, bool a_pinThreads)
+{
+	assert(m_workers.empty() && "The job pool is already initialized.");
+
+	m_isShuttingDown = false;
+	m_ownerThreadId = std::this_thread::get_id();
+
+	// A queue for every thread, the calling thread included.
+	m_queues.clear();
+	for (unsigned int threadIndex = 0; threadIndex <= a_workerCount; ++threadIndex)
+	{
+		m_queues.push_back(std::make_unique<WorkStealingQueue>());
+	}
+
+	if (a_pinThreads)
+		PinCallingThread(0);
+
+	for (unsigned int workerIndex = 0; workerIndex < a_workerCount; ++workerIndex)
+	{
+		m_workers.emplace_back(&JobPool::WorkerLoop, this, workerIndex + 1, a_pinThreads);
+	}
+}
+
+void JobPool::Shutdown()
+{
+	// Wake every worker up to exit, and wait for them.
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShuttingDown = true;
+	}
+	m_workAvailable.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	m_workers.clear();
+	m_queues.clear();
+}
+
+void JobPool::Run(const TaskJob& a_job, JobCounter& a_counter)
+{
+	// Nobody to share it with.
+	if (m_workers.empty())
+	{
+		a_job(0);
+		return;
+	}
+
+	a_counter.m_pendingCount.fetch_add(1, std::memory_order_relaxed);
+	Push({ &JobPool::RunTaskJob, &a_job, &a_counter }, GetCallingThreadIndex());
+}
+
+void JobPool::Wait(JobCounter& a_counter)
+{
+	if (a_counter.IsDone())
+		return;
+
+	// Help out rather than block, the jobs waited on may well be in our own queue.
+	const unsigned int threadIndex = GetCallingThreadIndex();
+	JobTaskValue task;
+	while (!a_counter.IsDone())
+	{
+		if (FindTask(threadIndex, task))
+			ExecuteTask(task, threadIndex);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobPool::ParallelFor(size_t a_count, size_t a_grainSize, const Job& a_job)
+{
+	const size_t grainSize = std::max<size_t>(1, a_grainSize);
+	const size_t grainCount = (a_count + grainSize - 1) / grainSize;
+
+	// Not worth waking anyone up for.
+	const unsigned int threadIndex = m_workers.empty() ? 0 : GetCallingThreadIndex();
+	if (m_workers.empty() || grainCount <= 1)
+	{
+		for (size_t index = 0; index < a_count; ++index)
+		{
+			a_job(index, threadIndex);
+		}
+		return;
+	}
+
+	// Queue a job per thread that could help, each claiming grains until none are left, and claim grains alongside them.
+	// Helpers that get to their job late find nothing left and return right away.
+	ParallelLoop loop;
+	loop.job = &a_job;
+	loop.count = a_count;
+	loop.grainSize = grainSize;
+
+	JobCounter counter;
+	const size_t helperCount = std::min<size_t>(grainCount - 1, m_workers.size());
+	counter.m_pendingCount.fetch_add(helperCount, std::memory_order_relaxed);
+	for (size_t helperIndex = 0; helperIndex < helperCount; ++helperIndex)
+	{
+		Push({ &JobPool::RunLoopJob, &loop, &counter }, threadIndex);
+	}
+
+	RunLoopIndices(loop, threadIndex);
+	Wait(counter);
+}
+
+void JobPool::RunTaskJob(const void* a_data, unsigned int a_threadIndex)
+{
+	(*static_cast<const TaskJob*>(a_data))(a_threadIndex);
+}
+
+void JobPool::RunLoopJob(const void* a_data, unsigned int a_threadIndex)
+{
+	RunLoopIndices(*static_cast<ParallelLoop*>(const_cast<void*>(a_data)), a_threadIndex);
+}
+
+void JobPool::RunLoopIndices(ParallelLoop& a_loop, unsigned int a_threadIndex)
+{
+	// Claim grains until none are left.
+	while (true)
+	{
+		const size_t firstIndex = a_loop.nextIndex.fetch_add(a_loop.grainSize, std::memory_order_relaxed);
+		if (firstIndex >= a_loop.count)
+			return;
+
+		const size_t endIndex = std::min(firstIndex + a_loop.grainSize, a_loop.count);
+		for (size_t index = firstIndex; index < endIndex; ++index)
+		{
+			(*a_loop.job)(index, a_threadIndex);
+		}
+	}
+}
+
+void JobPool::Push(const JobTaskValue& a_task, unsigned int a_threadIndex)
+{
+	// Count the job before it can be taken, so the count never drops below zero.
+	m_queuedJobCount.fetch_add(1);
+	if (!m_queues[a_threadIndex]->Push(a_task))
+	{
+		m_queuedJobCount.fetch_sub(1);
+		ExecuteTask(a_task, a_threadIndex);
+		return;
+	}
+
+	// Wake a worker up if any are asleep. Taking the lock makes sure it is either asleep already, or will see the job.
+	if (m_sleepingWorkerCount.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+		}
+		m_workAvailable.notify_one();
+	}
+}
+
+bool JobPool::FindTask(unsigned int a_threadIndex, JobTaskValue& a_task)
+{
+	// Our own most recent job first, then the oldest job of the threads after us.
+	bool isFound = m_queues[a_threadIndex]->Pop(a_task);
+	const unsigned int threadCount = static_cast<unsigned int>(m_queues.size());
+	for (unsigned int offset = 1; !isFound && offset < threadCount; ++offset)
+	{
+		isFound = m_queues[(a_threadIndex + offset) % threadCount]->Steal(a_task);
+	}
+
+	if (isFound)
+		m_queuedJobCount.fetch_sub(1);
+	return isFound;
+}
+
+void JobPool::ExecuteTask(const JobTaskValue& a_task, unsigned int a_threadIndex)
+{
+	PROFILE_SCOPE("JobPool::ExecuteTask");
+
+	a_task.entry(a_task.data, a_threadIndex);
+	if (a_task.counter != nullptr)
+		a_task.counter->m_pendingCount.fetch_sub(1, std::memory_order_release);
+}
+
+unsigned int JobPool::GetCallingThreadIndex() const
+{
+	if (t_poolThread.pool == this)
+		return t_poolThread.threadIndex;
+
+	assert(std::this_thread::get_id() == m_ownerThreadId && "Jobs may only be queued and waited on from the pool's threads.");
+	return 0;
+}
+
+void JobPool::WorkerLoop(unsigned int a_threadIndex, bool a_pinThread)
+{
+	PROFILE_THREAD("Job Worker");
+
+	t_poolThread = { this, a_threadIndex };
+	if (a_pinThread)
+		PinCallingThread(a_threadIndex);
+
+	JobTaskValue task;
+	unsigned int spinCount = 0;
+	while (true)
+	{
+		if (FindTask(a_threadIndex, task))
+		{
+			ExecuteTask(task, a_threadIndex);
+			spinCount = 0;
+			continue;
+		}
+
+		// Jobs tend to come in bursts, so look again a few times before sleeping.
+		if (++spinCount < SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		spinCount = 0;
+
+		// Sleep until a job is queued.
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_sleepingWorkerCount.fetch_add(1);
+		m_workAvailable.wait(lock, [this]() { return m_isShuttingDown || m_queuedJobCount.load() > 0; });
+		m_sleepingWorkerCount.fetch_sub(1);
+		if (m_isShuttingDown)
+			return;
+	}
+}
+
+void JobPool::PinCallingThread(unsigned int a_threadIndex)
+{
+	const unsigned int coreCount = std::max(1u, std::thread::hardware_concurrency());
+#ifdef _WIN32
+	const unsigned int coreIndex = a_threadIndex % std::min(coreCount, 64u);
+	SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << coreIndex);
+#else
+	cpu_set_t coreSet;
+	CPU_ZERO(&coreSet);
+	CPU_SET(a_threadIndex % coreCount, &coreSet);
+	pthread_setaffinity_np(pthread_self(), sizeof(coreSet), &coreSet);
+#endif // _WIN32
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+#include "WorkStealingQueue.h"
+
+// Counts the jobs of a batch that are still to run. Jobs are joined by waiting on their counter.
+class JobCounter final
+{
+public:
+	NO_COPY(JobCounter);
+	NO_MOVE(JobCounter);
+
+	JobCounter() = default;
+	~JobCounter() { assert(IsDone() && "A job counter went away before its jobs ran."); }
+
+	bool IsDone() const { return m_pendingCount.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobPool;
+	std::atomic<size_t> m_pendingCount{ 0 };
+};
+
+// The engine's job system: a fixed pool of worker threads, one per core, sharing out jobs by work stealing. Every thread
+// queues the jobs it spawns on a deque of its own, runs them most recent first, and steals the oldest jobs of the others
+// when it runs out. The thread that initialized the pool takes part as well, whenever it waits on jobs, so a pool with
+// no workers runs everything inline.
+//
+// Jobs may only be queued from the pool's threads. A thread waiting on jobs runs other jobs meanwhile, so jobs may queue
+// and wait on jobs of their own, and a job may run on a thread that is waiting inside another job.
+class JobPool final
+{
+public:
+	NO_COPY(JobPool);
+	NO_MOVE(JobPool);
+
+	// Job run for one index of a parallel loop, on the thread with the given index. The thread that initialized the pool
+	// has index zero, and no two threads run jobs under the same index at the same time.
+	using Job = std::function<void(size_t a_index, unsigned int a_threadIndex)>;
+
+	// Job run once, on the thread with the given index.
+	using TaskJob = std::function<void(unsigned int a_threadIndex)>;
+
+	JobPool() = default;
+	~JobPool();
+
+	// Start the workers. Pinned threads are each kept on a core of their own, the calling thread on the first one, so
+	// their caches stay warm, at the cost of the OS no longer moving them off busy cores.
+	void Initialize(unsigned int a_workerCount, bool a_pinThreads = false);
+	void Shutdown();
+
+	// Queue the job, counting it on the counter until it ran. The job is referenced rather than copied, so it has to
+	// outlive the wait on the counter. Runs inline when the pool has no workers, or the calling thread's queue is full.
+	void Run(const TaskJob& a_job, JobCounter& a_counter);
+
+	// Run jobs until every job counted on the counter ran.
+	void Wait(JobCounter& a_counter);
+
+	// Run the job for every index in [0, count) across the pool, and return once all of them are done. Indices are handed
+	// out a grain at a time, so uneven jobs balance out, and fine grained loops can take larger grains.
+	void ParallelFor(size_t a_count, const Job& a_job) { ParallelFor(a_count, 1, a_job); }
+	void ParallelFor(size_t a_count, size_t a_grainSize, const Job& a_job);
+
+	// Number of threads running jobs, the calling thread included.
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+private:
+	// A parallel loop being run. Lives on the stack of the thread running the loop until every index is done.
+	struct ParallelLoop final
+	{
+		const Job* job = nullptr;			// 8 bytes.
+		size_t count = 0;					// 8 bytes.
+		size_t grainSize = 1;				// 8 bytes.
+		std::atomic<size_t> nextIndex{ 0 };	// 8 bytes.
+	};										// Total = 32 bytes.
+
+	static void RunTaskJob(const void* a_data, unsigned int a_threadIndex);
+	static void RunLoopJob(const void* a_data, unsigned int a_threadIndex);
+	static void RunLoopIndices(ParallelLoop& a_loop, unsigned int a_threadIndex);
+
+	void Push(const JobTaskValue& a_task, unsigned int a_threadIndex);
+	bool FindTask(unsigned int a_threadIndex, JobTaskValue& a_task);
+	void ExecuteTask(const JobTaskValue& a_task, unsigned int a_threadIndex);
+	unsigned int GetCallingThreadIndex() const;
+
+	void WorkerLoop(unsigned int a_threadIndex, bool a_pinThread);
+	static void PinCallingThread(unsigned int a_threadIndex);
+
+private:
+	static constexpr unsigned int SPIN_COUNT = 64;	// Attempts to find a job before a worker goes to sleep.
+
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WorkStealingQueue>> m_queues;	// Indexed by thread.
+	std::thread::id m_ownerThreadId;							// The thread that initialized the pool, index zero.
+
+	std::mutex m_mutex;
+	std::condition_variable m_workAvailable;	// Signaled when a job is queued to sleeping workers, or on shutdown.
+	std::atomic<size_t> m_queuedJobCount{ 0 };	// Jobs queued and not yet taken.
+	std::atomic<unsigned int> m_sleepingWorkerCount{ 0 };
+	bool m_isShuttingDown = false;
+};
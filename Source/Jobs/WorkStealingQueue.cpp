@@ -0,0 +1,70 @@
+#include "PCH.h"
+#include "WorkStealingQueue.h"
+
+bool WorkStealingQueue::Push(const JobTaskValue& a_task)
+{
+	const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	const int64_t top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= static_cast<int64_t>(CAPACITY))
+		return false;
+
+	// Publish the job before the bottom moves past it.
+	Store(m_tasks[bottom & (CAPACITY - 1)], a_task);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	return true;
+}
+
+bool WorkStealingQueue::Pop(JobTaskValue& a_task)
+{
+	// Claim the bottom job before looking at the top, so a thief racing for the same job sees the claim.
+	const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty.
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	a_task = Load(m_tasks[bottom & (CAPACITY - 1)]);
+	if (top < bottom)
+		return true;
+
+	// The last job, which a thief may be claiming as well. Whoever moves the top first gets it.
+	const bool isClaimed = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	return isClaimed;
+}
+
+bool WorkStealingQueue::Steal(JobTaskValue& a_task)
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+		return false;
+
+	// Read the job before claiming it. Once claimed, the owner may reuse the slot.
+	a_task = Load(m_tasks[top & (CAPACITY - 1)]);
+	return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+void WorkStealingQueue::Store(JobTask& a_slot, const JobTaskValue& a_task)
+{
+	a_slot.entry.store(a_task.entry, std::memory_order_relaxed);
+	a_slot.data.store(a_task.data, std::memory_order_relaxed);
+	a_slot.counter.store(a_task.counter, std::memory_order_relaxed);
+}
+
+JobTaskValue WorkStealingQueue::Load(const JobTask& a_slot)
+{
+	JobTaskValue task;
+	task.entry = a_slot.entry.load(std::memory_order_relaxed);
+	task.data = a_slot.data.load(std::memory_order_relaxed);
+	task.counter = a_slot.counter.load(std::memory_order_relaxed);
+	return task;
+}
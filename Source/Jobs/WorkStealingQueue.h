@@ -0,0 +1,57 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+
+class JobCounter;
+
+// Runs a job on the thread with the given index, with the data it was queued with.
+using JobEntry = void(*)(const void* a_data, unsigned int a_threadIndex);
+
+// A queued job. The fields are atomic because a thief may read a slot the owner is overwriting, in which case the thief
+// fails to claim it and drops what it read.
+struct JobTask final
+{
+	std::atomic<JobEntry> entry{ nullptr };			// 8 bytes.
+	std::atomic<const void*> data{ nullptr };		// 8 bytes.
+	std::atomic<JobCounter*> counter{ nullptr };	// 8 bytes. Decremented once the job ran.
+};													// Total = 24 bytes.
+
+// A queued job, as copied out of a queue.
+struct JobTaskValue final
+{
+	JobEntry entry = nullptr;			// 8 bytes.
+	const void* data = nullptr;			// 8 bytes.
+	JobCounter* counter = nullptr;		// 8 bytes.
+};										// Total = 24 bytes.
+
+// Chase-Lev work stealing deque of a fixed capacity. Only the owning thread pushes and pops, at the bottom, most recent
+// job first so its data is still in cache. Any other thread steals from the top, oldest job first, which tends to be the
+// largest piece of work left.
+class WorkStealingQueue final
+{
+public:
+	NO_COPY(WorkStealingQueue);
+	NO_MOVE(WorkStealingQueue);
+
+	static constexpr size_t CAPACITY = 4096; // A power of two.
+
+	WorkStealingQueue() = default;
+	~WorkStealingQueue() = default;
+
+	// Owner only. Returns false if the queue is full.
+	bool Push(const JobTaskValue& a_task);
+	bool Pop(JobTaskValue& a_task);
+
+	// Any thread. Returns false if the queue is empty, or another thread claimed the job first.
+	bool Steal(JobTaskValue& a_task);
+
+private:
+	static void Store(JobTask& a_slot, const JobTaskValue& a_task);
+	static JobTaskValue Load(const JobTask& a_slot);
+
+private:
+	std::atomic<int64_t> m_top{ 0 };				// Next job to steal.
+	char m_padding[64 - sizeof(std::atomic<int64_t>)];	// Keeps the top and bottom on separate cache lines, as thieves only write the top.
+	std::atomic<int64_t> m_bottom{ 0 };				// Where the next job is pushed.
+	JobTask m_tasks[CAPACITY];
+};
@@ -1,13 +1,79 @@
 #include "PCH.h"
 #include "Engine.h"
+#include "Benchmarks\BatchingBenchmark.h"
+#include "Benchmarks\CollisionBenchmark.h"
+#include "Benchmarks\CullingBenchmark.h"
+#include "Benchmarks\ECSBenchmark.h"
+#include "Benchmarks\RenderSortBenchmark.h"
+#include "Memory\AllocationTracker.h"
 
 int main(int argc, char* argv[])
 {
+	// Run a benchmark instead of the engine when requested on the command line.
+	if (argc > 1 && strcmp(argv[1], "--benchmark-collision") == 0)
+	{
+		return RunCollisionBenchmark() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--benchmark-culling") == 0)
+	{
+		RunCullingBenchmark();
+		return EXIT_SUCCESS;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--benchmark-batching") == 0)
+	{
+		RunBatchingBenchmark();
+		return EXIT_SUCCESS;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--benchmark-render-sort") == 0)
+	{
+		RunRenderSortBenchmark();
+		return EXIT_SUCCESS;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--benchmark-ecs") == 0)
+	{
+		RunECSBenchmark(argc - 2, argv + 2);
+		return EXIT_SUCCESS;
+	}
+
 	Engine& engine = Engine::GetInstanceWrite();
+
+	// Options for running without a window, and for timed runs.
+	for (int argumentIndex = 1; argumentIndex < argc; ++argumentIndex)
+	{
+		if (strcmp(argv[argumentIndex], "--headless") == 0)
+			engine.SetRenderBackend(RenderBackend::SoftwareBackend);
+		else if (strcmp(argv[argumentIndex], "--headless-null") == 0)
+			engine.SetRenderBackend(RenderBackend::NullBackend);
+		else if (strcmp(argv[argumentIndex], "--render-thread") == 0)
+			engine.SetRenderThreadEnabled(true);
+		else if (strcmp(argv[argumentIndex], "--pin-threads") == 0)
+			engine.SetThreadPinningEnabled(true);
+		else if (strcmp(argv[argumentIndex], "--sim-rate") == 0 && argumentIndex + 1 < argc)
+			engine.SetSimulationRate(std::max(1.0, atof(argv[++argumentIndex])));
+		else if (strcmp(argv[argumentIndex], "--frames") == 0 && argumentIndex + 1 < argc)
+			engine.SetFrameLimit(strtoull(argv[++argumentIndex], nullptr, 10));
+		else if (strcmp(argv[argumentIndex], "--dump-frames") == 0 && argumentIndex + 1 < argc)
+			engine.SetFrameDumpDirectory(argv[++argumentIndex]);
+#ifdef ENGINE_ALLOCATION_TRACKING
+		else if (strcmp(argv[argumentIndex], "--allocation-budget") == 0 && argumentIndex + 1 < argc)
+			AllocationTracker::GetInstanceWrite().SetFrameBudget(strtoull(argv[++argumentIndex], nullptr, 10));
+#endif // ENGINE_ALLOCATION_TRACKING
+	}
+
 	engine.Initialize();
 	engine.Run();
 	engine.Shutdown();
 
+#ifdef ENGINE_ALLOCATION_TRACKING
+	// Fail runs that went over the allocation budget, so build machines catch new allocations.
+	if (AllocationTracker::GetInstanceRead().GetOverBudgetFrameCount() > 0)
+		return EXIT_FAILURE;
+#endif // ENGINE_ALLOCATION_TRACKING
+
 	return EXIT_SUCCESS;
 }
 
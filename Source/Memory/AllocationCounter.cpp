@@ -0,0 +1,271 @@
+#include "PCH.h"
+#include "AllocationCounter.h"
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> s_allocationCount{ 0 };
+	std::atomic<size_t> s_allocatedBytes{ 0 };
+
+#ifdef ENGINE_ALLOCATION_TRACKING
+	// Tracked allocations are prefixed with their size and tag, so freeing them can take them off the right live bytes.
+	// The header sits right before the memory handed out, and the offset leads back to the start of the block.
+	struct AllocationHeader final
+	{
+		size_t size;		// 8 bytes.
+		size_t offset;		// 8 bytes. From the start of the block to the memory handed out.
+		AllocationTag tag;	// 1 byte.
+	};						// Total = 24 bytes with padding.
+
+	// Room for the header that keeps the alignment malloc gives. Over-aligned allocations pad it to their alignment.
+	constexpr size_t HEADER_SIZE = 32;
+	static_assert(sizeof(AllocationHeader) <= HEADER_SIZE, "The allocation header outgrew its room.");
+
+	struct TagCounters final
+	{
+		std::atomic<size_t> allocationCount;	// 8 bytes.
+		std::atomic<size_t> allocatedBytes;		// 8 bytes.
+		std::atomic<size_t> liveBytes;			// 8 bytes.
+		std::atomic<size_t> peakLiveBytes;		// 8 bytes.
+	};											// Total = 32 bytes.
+
+	// Zero initialized before anything runs, as allocations may come in before any constructor.
+	TagCounters s_tagCounters[static_cast<size_t>(AllocationTag::Count)];
+	thread_local AllocationTag t_allocationTag = AllocationTag::Untagged;
+
+	const char* const TAG_NAMES[] = { "Untagged", "ECS", "Events", "Render", "Assets" };
+	static_assert(sizeof(TAG_NAMES) / sizeof(TAG_NAMES[0]) == static_cast<size_t>(AllocationTag::Count), "Every allocation tag needs a name.");
+#endif // ENGINE_ALLOCATION_TRACKING
+
+#ifdef ENGINE_ALLOCATION_COUNTER
+	// Blocks are taken from malloc, or from the aligned allocator of the platform for alignments above the default. The
+	// two can't free each other's blocks, so an allocation is freed the way it was allocated.
+	void* AllocateBlock(size_t a_size, size_t an_alignment)
+	{
+		if (an_alignment == 0)
+			return malloc(a_size);
+
+#ifdef _WIN32
+		return _aligned_malloc(a_size, an_alignment);
+#else
+		void* memory = nullptr;
+		return posix_memalign(&memory, an_alignment, a_size) == 0 ? memory : nullptr;
+#endif // _WIN32
+	}
+
+	void FreeBlock(void* a_block, size_t an_alignment)
+	{
+#ifdef _WIN32
+		if (an_alignment != 0)
+		{
+			_aligned_free(a_block);
+			return;
+		}
+#endif // _WIN32
+		free(a_block);
+	}
+
+	// Allocate, counting on the way. An alignment of zero is the default one.
+	void* CountedAllocate(size_t a_size, size_t an_alignment)
+	{
+		s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+		s_allocatedBytes.fetch_add(a_size, std::memory_order_relaxed);
+#ifdef ENGINE_ALLOCATION_TRACKING
+		const size_t offset = std::max(HEADER_SIZE, an_alignment);
+		unsigned char* block = static_cast<unsigned char*>(AllocateBlock(offset + a_size, an_alignment));
+		if (block == nullptr)
+			return nullptr;
+
+		AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block + offset - HEADER_SIZE);
+		header->size = a_size;
+		header->offset = offset;
+		header->tag = t_allocationTag;
+
+		// Count the allocation under its tag, and raise the tag's peak if this is the most it ever had live.
+		TagCounters& tagCounters = s_tagCounters[static_cast<size_t>(header->tag)];
+		tagCounters.allocationCount.fetch_add(1, std::memory_order_relaxed);
+		tagCounters.allocatedBytes.fetch_add(a_size, std::memory_order_relaxed);
+		const size_t liveBytes = tagCounters.liveBytes.fetch_add(a_size, std::memory_order_relaxed) + a_size;
+		size_t peakLiveBytes = tagCounters.peakLiveBytes.load(std::memory_order_relaxed);
+		while (liveBytes > peakLiveBytes && !tagCounters.peakLiveBytes.compare_exchange_weak(peakLiveBytes, liveBytes, std::memory_order_relaxed))
+		{
+		}
+
+		return block + offset;
+#else
+		return AllocateBlock(a_size == 0 ? 1 : a_size, an_alignment);
+#endif // ENGINE_ALLOCATION_TRACKING
+	}
+
+	void CountedFree(void* a_memory, size_t an_alignment)
+	{
+#ifdef ENGINE_ALLOCATION_TRACKING
+		if (a_memory == nullptr)
+			return;
+
+		const AllocationHeader* header = reinterpret_cast<const AllocationHeader*>(static_cast<unsigned char*>(a_memory) - HEADER_SIZE);
+		s_tagCounters[static_cast<size_t>(header->tag)].liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+		FreeBlock(static_cast<unsigned char*>(a_memory) - header->offset, an_alignment);
+#else
+		FreeBlock(a_memory, an_alignment);
+#endif // ENGINE_ALLOCATION_TRACKING
+	}
+
+	void* CountedAllocateOrThrow(size_t a_size, size_t an_alignment)
+	{
+		void* memory = CountedAllocate(a_size, an_alignment);
+		if (memory == nullptr)
+			throw std::bad_alloc();
+		return memory;
+	}
+#endif // ENGINE_ALLOCATION_COUNTER
+}
+
+AllocationCounts GetAllocationCounts()
+{
+	return { s_allocationCount.load(std::memory_order_relaxed), s_allocatedBytes.load(std::memory_order_relaxed) };
+}
+
+#ifdef ENGINE_ALLOCATION_TRACKING
+const char* GetAllocationTagName(AllocationTag a_tag)
+{
+	return TAG_NAMES[static_cast<size_t>(a_tag)];
+}
+
+AllocationTagCounts GetAllocationTagCounts(AllocationTag a_tag)
+{
+	const TagCounters& tagCounters = s_tagCounters[static_cast<size_t>(a_tag)];
+
+	AllocationTagCounts tagCounts;
+	tagCounts.allocationCount = tagCounters.allocationCount.load(std::memory_order_relaxed);
+	tagCounts.allocatedBytes = tagCounters.allocatedBytes.load(std::memory_order_relaxed);
+	tagCounts.liveBytes = tagCounters.liveBytes.load(std::memory_order_relaxed);
+	tagCounts.peakLiveBytes = tagCounters.peakLiveBytes.load(std::memory_order_relaxed);
+	return tagCounts;
+}
+
+void ResetAllocationPeaks()
+{
+	for (TagCounters& tagCounters : s_tagCounters)
+	{
+		tagCounters.peakLiveBytes.store(tagCounters.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+AllocationScope::AllocationScope(AllocationTag a_tag)
+	: m_previousTag(t_allocationTag)
+{
+	t_allocationTag = a_tag;
+}
+
+AllocationScope::~AllocationScope()
+{
+	t_allocationTag = m_previousTag;
+}
+#endif // ENGINE_ALLOCATION_TRACKING
+
+#ifdef ENGINE_ALLOCATION_COUNTER
+// Replacements of the global allocation functions, counting on the way to malloc.
+void* operator new(size_t a_size)
+{
+	return CountedAllocateOrThrow(a_size, 0);
+}
+
+void* operator new[](size_t a_size)
+{
+	return CountedAllocateOrThrow(a_size, 0);
+}
+
+void* operator new(size_t a_size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(a_size, 0);
+}
+
+void* operator new[](size_t a_size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(a_size, 0);
+}
+
+void operator delete(void* a_memory) noexcept
+{
+	CountedFree(a_memory, 0);
+}
+
+void operator delete[](void* a_memory) noexcept
+{
+	CountedFree(a_memory, 0);
+}
+
+void operator delete(void* a_memory, size_t) noexcept
+{
+	CountedFree(a_memory, 0);
+}
+
+void operator delete[](void* a_memory, size_t) noexcept
+{
+	CountedFree(a_memory, 0);
+}
+
+void operator delete(void* a_memory, const std::nothrow_t&) noexcept
+{
+	CountedFree(a_memory, 0);
+}
+
+void operator delete[](void* a_memory, const std::nothrow_t&) noexcept
+{
+	CountedFree(a_memory, 0);
+}
+
+#ifdef __cpp_aligned_new
+// The aligned forms, used for types declared with an alignment above the default, like most components.
+void* operator new(size_t a_size, std::align_val_t an_alignment)
+{
+	return CountedAllocateOrThrow(a_size, static_cast<size_t>(an_alignment));
+}
+
+void* operator new[](size_t a_size, std::align_val_t an_alignment)
+{
+	return CountedAllocateOrThrow(a_size, static_cast<size_t>(an_alignment));
+}
+
+void* operator new(size_t a_size, std::align_val_t an_alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(a_size, static_cast<size_t>(an_alignment));
+}
+
+void* operator new[](size_t a_size, std::align_val_t an_alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(a_size, static_cast<size_t>(an_alignment));
+}
+
+void operator delete(void* a_memory, std::align_val_t an_alignment) noexcept
+{
+	CountedFree(a_memory, static_cast<size_t>(an_alignment));
+}
+
+void operator delete[](void* a_memory, std::align_val_t an_alignment) noexcept
+{
+	CountedFree(a_memory, static_cast<size_t>(an_alignment));
+}
+
+void operator delete(void* a_memory, size_t, std::align_val_t an_alignment) noexcept
+{
+	CountedFree(a_memory, static_cast<size_t>(an_alignment));
+}
+
+void operator delete[](void* a_memory, size_t, std::align_val_t an_alignment) noexcept
+{
+	CountedFree(a_memory, static_cast<size_t>(an_alignment));
+}
+
+void operator delete(void* a_memory, std::align_val_t an_alignment, const std::nothrow_t&) noexcept
+{
+	CountedFree(a_memory, static_cast<size_t>(an_alignment));
+}
+
+void operator delete[](void* a_memory, std::align_val_t an_alignment, const std::nothrow_t&) noexcept
+{
+	CountedFree(a_memory, static_cast<size_t>(an_alignment));
+}
+#endif // __cpp_aligned_new
+#endif // ENGINE_ALLOCATION_COUNTER
@@ -0,0 +1,84 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+
+// The global operator new and delete are only replaced when ENGINE_ALLOCATION_COUNTER is defined, as the Benchmark configuration does,
+// or when ENGINE_ALLOCATION_TRACKING is, which needs them. Other builds allocate straight from the runtime.
+#if defined(ENGINE_ALLOCATION_TRACKING) && !defined(ENGINE_ALLOCATION_COUNTER)
+#define ENGINE_ALLOCATION_COUNTER
+#endif // ENGINE_ALLOCATION_TRACKING
+
+// Allocations made through the global operator new since the program started. Every allocation is counted, as a relaxed
+// atomic increment on top of the allocation itself, so the counts can be sampled around any stretch of code. Without
+// ENGINE_ALLOCATION_COUNTER nothing is counted, and the counts stay at zero.
+struct AllocationCounts final
+{
+	size_t allocationCount = 0;		// 8 bytes.
+	size_t allocatedBytes = 0;		// 8 bytes.
+};									// Total = 16 bytes.
+
+AllocationCounts GetAllocationCounts();
+
+// Allocations counted by subsystem, compiled in only when ENGINE_ALLOCATION_TRACKING is defined. Without it the scope
+// macro expands to nothing.
+#ifdef ENGINE_ALLOCATION_TRACKING
+
+#define ALLOCATION_CONCATENATE_INNER(A, B) A##B
+#define ALLOCATION_CONCATENATE(A, B) ALLOCATION_CONCATENATE_INNER(A, B)
+
+// Count the allocations made on the calling thread in the rest of the enclosing scope under the tag.
+#define ALLOCATION_SCOPE(TAG) const AllocationScope ALLOCATION_CONCATENATE(allocationScope, __LINE__)(TAG)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// The subsystem an allocation is counted under, that of the innermost allocation scope it was made in.
+enum class AllocationTag : unsigned char
+{
+	Untagged = 0,
+	ECS,
+	Events,
+	Render,
+	Assets,
+	Count
+};
+
+const char* GetAllocationTagName(AllocationTag a_tag);
+
+// Allocations of a tag since the program started, and the bytes of them not yet freed. Freeing memory takes it off the
+// live bytes of the tag it was allocated under, whichever scope it is freed in.
+struct AllocationTagCounts final
+{
+	size_t allocationCount = 0;		// 8 bytes.
+	size_t allocatedBytes = 0;		// 8 bytes.
+	size_t liveBytes = 0;			// 8 bytes.
+	size_t peakLiveBytes = 0;		// 8 bytes. Highest live bytes since the peaks were last reset.
+};									// Total = 32 bytes.
+
+AllocationTagCounts GetAllocationTagCounts(AllocationTag a_tag);
+
+// Start the peak of every tag over from its current live bytes.
+void ResetAllocationPeaks();
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// Tags the allocations of the calling thread from construction to destruction, then restores the tag it replaced.
+class AllocationScope final
+{
+public:
+	NO_COPY(AllocationScope);
+	NO_MOVE(AllocationScope);
+
+	explicit AllocationScope(AllocationTag a_tag);
+	~AllocationScope();
+
+private:
+	AllocationTag m_previousTag;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+#else
+
+#define ALLOCATION_SCOPE(TAG)
+
+#endif // ENGINE_ALLOCATION_TRACKING
@@ -0,0 +1,98 @@
+#include "PCH.h"
+#include "AllocationTracker.h"
+
+#ifdef ENGINE_ALLOCATION_TRACKING
+
+constexpr size_t AllocationTracker::FRAME_CAPACITY;
+
+size_t AllocationFrame::GetAllocationCount() const
+{
+	size_t allocationCount = 0;
+	for (const AllocationFrameCounts& frameCounts : tagCounts)
+	{
+		allocationCount += frameCounts.allocationCount;
+	}
+	return allocationCount;
+}
+
+AllocationTracker::AllocationTracker()
+{
+	// Allocate the whole ring up front, so ending a frame never allocates.
+	m_frames.resize(FRAME_CAPACITY);
+
+	for (size_t tagIndex = 0; tagIndex < static_cast<size_t>(AllocationTag::Count); ++tagIndex)
+	{
+		m_frameStartCounts[tagIndex] = GetAllocationTagCounts(static_cast<AllocationTag>(tagIndex));
+	}
+	ResetAllocationPeaks();
+}
+
+void AllocationTracker::EndFrame()
+{
+	AllocationFrame& frame = m_frames[m_frameCount & (FRAME_CAPACITY - 1)];
+	frame.frameIndex = m_frameCount;
+
+	// What each tag allocated since the frame began, and its peak during the frame.
+	for (size_t tagIndex = 0; tagIndex < static_cast<size_t>(AllocationTag::Count); ++tagIndex)
+	{
+		const AllocationTagCounts tagCounts = GetAllocationTagCounts(static_cast<AllocationTag>(tagIndex));
+		AllocationFrameCounts& frameCounts = frame.tagCounts[tagIndex];
+		frameCounts.allocationCount = tagCounts.allocationCount - m_frameStartCounts[tagIndex].allocationCount;
+		frameCounts.allocatedBytes = tagCounts.allocatedBytes - m_frameStartCounts[tagIndex].allocatedBytes;
+		frameCounts.peakLiveBytes = tagCounts.peakLiveBytes;
+		m_frameStartCounts[tagIndex] = tagCounts;
+	}
+	ResetAllocationPeaks();
+	++m_frameCount;
+
+	// Report the frame, by tag, if it went over the budget.
+	const size_t allocationCount = frame.GetAllocationCount();
+	if (m_frameCount <= WARM_UP_FRAME_COUNT || allocationCount <= m_frameBudget)
+		return;
+
+	++m_overBudgetFrameCount;
+	fprintf(stderr, "Frame %zu made %zu allocations, over the budget of %zu:", frame.frameIndex, allocationCount, m_frameBudget);
+	for (size_t tagIndex = 0; tagIndex < static_cast<size_t>(AllocationTag::Count); ++tagIndex)
+	{
+		if (frame.tagCounts[tagIndex].allocationCount > 0)
+			fprintf(stderr, " %s %zu (%zu bytes)", GetAllocationTagName(static_cast<AllocationTag>(tagIndex)), frame.tagCounts[tagIndex].allocationCount, frame.tagCounts[tagIndex].allocatedBytes);
+	}
+	fprintf(stderr, "\n");
+}
+
+const AllocationFrame& AllocationTracker::GetLastFrameRead() const
+{
+	assert(m_frameCount > 0 && "No frame ended yet.");
+	return m_frames[(m_frameCount - 1) & (FRAME_CAPACITY - 1)];
+}
+
+bool AllocationTracker::WriteFramesCsv(const char* a_filePath) const
+{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+	FILE* file = fopen(a_filePath, "w");
+#pragma warning(default : 4996)
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s for writing.\n", a_filePath);
+		return false;
+	}
+
+	// The frames still kept, oldest first.
+	fprintf(file, "frame,tag,allocations,bytes,peak_live_bytes\n");
+	const size_t firstFrame = m_frameCount > FRAME_CAPACITY ? m_frameCount - FRAME_CAPACITY : 0;
+	for (size_t frameIndex = firstFrame; frameIndex < m_frameCount; ++frameIndex)
+	{
+		const AllocationFrame& frame = m_frames[frameIndex & (FRAME_CAPACITY - 1)];
+		for (size_t tagIndex = 0; tagIndex < static_cast<size_t>(AllocationTag::Count); ++tagIndex)
+		{
+			const AllocationFrameCounts& frameCounts = frame.tagCounts[tagIndex];
+			fprintf(file, "%zu,%s,%zu,%zu,%zu\n", frame.frameIndex, GetAllocationTagName(static_cast<AllocationTag>(tagIndex)),
+				frameCounts.allocationCount, frameCounts.allocatedBytes, frameCounts.peakLiveBytes);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+#endif // ENGINE_ALLOCATION_TRACKING
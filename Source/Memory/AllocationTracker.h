@@ -0,0 +1,67 @@
+#pragma once
+#include "PCH.h"
+#include "AllocationCounter.h"
+#include "Macros.h"
+
+// Per frame allocation history, compiled in only when ENGINE_ALLOCATION_TRACKING is defined.
+#ifdef ENGINE_ALLOCATION_TRACKING
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// What one tag allocated in one frame.
+struct AllocationFrameCounts final
+{
+	size_t allocationCount = 0;		// 8 bytes.
+	size_t allocatedBytes = 0;		// 8 bytes.
+	size_t peakLiveBytes = 0;		// 8 bytes. Most bytes of the tag live at once during the frame.
+};									// Total = 24 bytes.
+
+struct AllocationFrame final
+{
+	size_t frameIndex = 0;
+	AllocationFrameCounts tagCounts[static_cast<size_t>(AllocationTag::Count)];
+
+	size_t GetAllocationCount() const;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// Splits the tagged allocation counts into frames, and checks every frame against an allocation budget. The engine is
+// meant to stop allocating once its scene is up, so a budget of zero catches whatever still allocates every frame. Only
+// the main thread may use it, the counts themselves come from every thread.
+class AllocationTracker final
+{
+public:
+	SINGLETON(AllocationTracker);
+
+	AllocationTracker();
+	~AllocationTracker() = default;
+
+	// Close the frame, keeping what every tag allocated in it, and report it if it went over the budget.
+	void EndFrame();
+
+	// Most allocations a frame may make once the warm up frames are over. Unlimited until set.
+	void SetFrameBudget(size_t an_allocationCount) { m_frameBudget = an_allocationCount; }
+
+	const AllocationFrame& GetLastFrameRead() const;
+	size_t GetFrameCount() const { return m_frameCount; }
+	size_t GetOverBudgetFrameCount() const { return m_overBudgetFrameCount; }
+
+	// Write the allocations, bytes and peak live bytes of every tag in every kept frame.
+	bool WriteFramesCsv(const char* a_filePath) const;
+
+private:
+	static constexpr size_t FRAME_CAPACITY = 1 << 12;		// Frames kept, a power of two.
+	static constexpr size_t WARM_UP_FRAME_COUNT = 120;		// Frames left out of the budget, while caches and pools fill.
+
+	std::vector<AllocationFrame> m_frames;	// Ring of the latest frames.
+	size_t m_frameCount = 0;
+	AllocationTagCounts m_frameStartCounts[static_cast<size_t>(AllocationTag::Count)];	// Counts as the current frame began.
+
+	size_t m_frameBudget = SIZE_MAX;
+	size_t m_overBudgetFrameCount = 0;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+#endif // ENGINE_ALLOCATION_TRACKING
@@ -0,0 +1,56 @@
+#include "PCH.h"
+#include "FrameArena.h"
+
+constexpr size_t FrameArena::INITIAL_CAPACITY;
+constexpr size_t FrameArena::MAX_RETAINED_CAPACITY;
+
+FrameArena::FrameArena()
+{
+	for (FrameBuffer& frameBuffer : m_frameBuffers)
+	{
+		frameBuffer.blocks.push_back(CreateBlock(INITIAL_CAPACITY));
+	}
+}
+
+void FrameArena::EndFrame()
+{
+	// The buffer of the last frame becomes the buffer of the next one.
+	m_frameIndex ^= 1;
+	FrameBuffer& frameBuffer = m_frameBuffers[m_frameIndex];
+
+	// A frame that outgrew its block gets a single block large enough for all of it next time, within reason, so a
+	// steady load settles into bumping a pointer through a single block.
+	if (frameBuffer.blocks.size() > 1)
+	{
+		size_t totalCapacity = 0;
+		for (const Block& block : frameBuffer.blocks)
+		{
+			totalCapacity += block.capacity;
+		}
+
+		frameBuffer.blocks.clear();
+		frameBuffer.blocks.push_back(CreateBlock(std::min(totalCapacity, MAX_RETAINED_CAPACITY)));
+	}
+
+	frameBuffer.blocks.back().usedSize = 0;
+}
+
+void* FrameArena::AllocateSlow(size_t a_size, size_t an_alignment)
+{
+	// Out of room, add a block at least twice as large as the last one.
+	FrameBuffer& frameBuffer = m_frameBuffers[m_frameIndex];
+	const size_t capacity = std::max(frameBuffer.blocks.back().capacity * 2, a_size + an_alignment);
+	frameBuffer.blocks.push_back(CreateBlock(capacity));
+
+	void* memory = AllocateFromBlock(frameBuffer.blocks.back(), a_size, an_alignment);
+	assert(memory != nullptr);
+	return memory;
+}
+
+FrameArena::Block FrameArena::CreateBlock(size_t a_capacity)
+{
+	Block block;
+	block.memory.reset(new unsigned char[a_capacity]);
+	block.capacity = a_capacity;
+	return block;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+
+// Linear allocator for data that only lives for a frame or two, such as deferred requests and scratch buffers.
+// Allocating bumps a pointer, and nothing is freed on its own: the memory of a whole frame is released at once, at the
+// end of the frame after it, so data may be handed over to the next frame. Destructors are not run, so types needing
+// them have to be destroyed by hand before then. Only the main thread may use it.
+class FrameArena final
+{
+public:
+	SINGLETON(FrameArena);
+
+	FrameArena();
+	~FrameArena() = default;
+
+	// Memory for the current frame, valid until the end of the next one.
+	void* Allocate(size_t a_size, size_t an_alignment);
+
+	template<typename T, typename... TArguments> T* New(TArguments&&... an_arguments);
+
+	// Start a new frame, releasing the memory of the frame before the one ending. Called once at the end of every frame.
+	void EndFrame();
+
+private:
+	static constexpr size_t INITIAL_CAPACITY = 1 << 20;		// Bytes per frame to start with.
+	static constexpr size_t MAX_RETAINED_CAPACITY = 1 << 26;	// Largest frame kept around after a spike, such as loading.
+
+	struct Block final
+	{
+		std::unique_ptr<unsigned char[]> memory;	// 8 bytes.
+		size_t capacity = 0;						// 8 bytes.
+		size_t usedSize = 0;						// 8 bytes.
+	};												// Total = 24 bytes.
+
+	// The memory of a frame. Allocations go into the last block, and a frame outgrowing its blocks gets another one.
+	struct FrameBuffer final
+	{
+		std::vector<Block> blocks;
+	};
+
+	void* AllocateSlow(size_t a_size, size_t an_alignment);
+	static void* AllocateFromBlock(Block& a_block, size_t a_size, size_t an_alignment);
+	static Block CreateBlock(size_t a_capacity);
+
+private:
+	FrameBuffer m_frameBuffers[2];
+	unsigned int m_frameIndex = 0;	// Buffer of the current frame, the other one holds the last frame.
+};
+
+inline void* FrameArena::Allocate(size_t a_size, size_t an_alignment)
+{
+	void* memory = AllocateFromBlock(m_frameBuffers[m_frameIndex].blocks.back(), a_size, an_alignment);
+	return memory != nullptr ? memory : AllocateSlow(a_size, an_alignment);
+}
+
+template<typename T, typename... TArguments>
+inline T* FrameArena::New(TArguments&&... an_arguments)
+{
+	return new (Allocate(sizeof(T), alignof(T))) T(std::forward<TArguments>(an_arguments)...);
+}
+
+inline void* FrameArena::AllocateFromBlock(Block& a_block, size_t a_size, size_t an_alignment)
+{
+	// Align the address itself, blocks are only aligned for the fundamental types.
+	const uintptr_t blockAddress = reinterpret_cast<uintptr_t>(a_block.memory.get());
+	const uintptr_t address = (blockAddress + a_block.usedSize + an_alignment - 1) & ~static_cast<uintptr_t>(an_alignment - 1);
+	const size_t endOffset = static_cast<size_t>(address - blockAddress) + a_size;
+	if (endOffset > a_block.capacity)
+		return nullptr;
+
+	a_block.usedSize = endOffset;
+	return reinterpret_cast<void*>(address);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// Standard allocator handing out frame arena memory, for containers that only live for a frame or two. Deallocating does
+// nothing, so reserve up front rather than letting such containers grow.
+template<typename T>
+class FrameAllocator
+{
+public:
+	using value_type = T;
+
+	FrameAllocator() = default;
+	template<typename TOther> FrameAllocator(const FrameAllocator<TOther>&) {}
+
+	T* allocate(size_t a_count) { return static_cast<T*>(FrameArena::GetInstanceWrite().Allocate(a_count * sizeof(T), alignof(T))); }
+	void deallocate(T*, size_t) {}
+};
+
+template<typename T1, typename T2>
+bool operator==(const FrameAllocator<T1>&, const FrameAllocator<T2>&) { return true; }
+
+template<typename T1, typename T2>
+bool operator!=(const FrameAllocator<T1>&, const FrameAllocator<T2>&) { return false; }
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
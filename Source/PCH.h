@@ -8,15 +8,26 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 
 // C++ standard library includes
+#include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <unordered_map>
 #include <vector>
 #include <set>
+#include <string>
+#include <thread>
+#include <typeinfo>
 #include <xutility>
 
@@ -0,0 +1,210 @@
+#include "PCH.h"
+#include "Profiler.h"
+#include <map>
+
+#ifdef ENGINE_PROFILER
+
+namespace
+{
+	// Write a string as a JSON string literal, escaping the characters JSON requires.
+	void WriteJsonString(FILE* a_file, const char* a_string)
+	{
+		fputc('"', a_file);
+		for (const char* character = a_string; *character != '\0'; ++character)
+		{
+			if (*character == '"' || *character == '\\')
+				fputc('\\', a_file);
+			fputc(*character, a_file);
+		}
+		fputc('"', a_file);
+	}
+
+	// Write a string as a CSV field, quoting it and doubling any quotes inside.
+	void WriteCsvString(FILE* a_file, const char* a_string)
+	{
+		fputc('"', a_file);
+		for (const char* character = a_string; *character != '\0'; ++character)
+		{
+			if (*character == '"')
+				fputc('"', a_file);
+			fputc(*character, a_file);
+		}
+		fputc('"', a_file);
+	}
+
+	const char* const FRAME_NAME = "Frame";
+}
+
+void Profiler::RecordFrame(Uint64 a_startTicks, Uint64 an_endTicks)
+{
+	if (m_frames.empty())
+		m_frames.resize(FRAME_CAPACITY);
+
+	m_frames[m_frameCount & (FRAME_CAPACITY - 1)] = { FRAME_NAME, a_startTicks, an_endTicks };
+	++m_frameCount;
+	RecordScope(FRAME_NAME, a_startTicks, an_endTicks);
+}
+
+void Profiler::SetThreadName(const char* a_threadName)
+{
+	ThreadBuffer& threadBuffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	threadBuffer.threadName = a_threadName;
+}
+
+const char* Profiler::InternName(const std::string& a_name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_internedNames.push_back(a_name);
+	return m_internedNames.back().c_str();
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+	// Register the thread the first time it records. Buffers live as long as the profiler, even past their thread.
+	thread_local ThreadBuffer* threadBuffer = nullptr;
+	if (threadBuffer)
+		return *threadBuffer;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+	threadBuffer = m_threadBuffers.back().get();
+	threadBuffer->events.resize(THREAD_CAPACITY);
+	threadBuffer->threadIndex = static_cast<unsigned int>(m_threadBuffers.size() - 1);
+	threadBuffer->threadName = "Thread " + std::to_string(threadBuffer->threadIndex);
+	return *threadBuffer;
+}
+
+void Profiler::GetRetainedEvents(const ThreadBuffer& a_threadBuffer, std::vector<ProfileEvent>& an_events)
+{
+	const size_t eventCount = a_threadBuffer.eventCount.load(std::memory_order_acquire);
+	const size_t firstEvent = eventCount > THREAD_CAPACITY ? eventCount - THREAD_CAPACITY : 0;
+	an_events.clear();
+	for (size_t eventIndex = firstEvent; eventIndex < eventCount; ++eventIndex)
+	{
+		an_events.push_back(a_threadBuffer.events[eventIndex & (THREAD_CAPACITY - 1)]);
+	}
+}
+
+bool Profiler::WriteChromeTrace(const char* a_filePath) const
+{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+	FILE* file = fopen(a_filePath, "w");
+#pragma warning(default : 4996)
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s for writing.\n", a_filePath);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const double microsecondsPerTick = 1000000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	// Gather every thread's scopes, and start the trace at the earliest of them.
+	std::vector<std::vector<ProfileEvent>> threadEvents(m_threadBuffers.size());
+	Uint64 baseTicks = std::numeric_limits<Uint64>::max();
+	for (size_t threadIndex = 0; threadIndex < m_threadBuffers.size(); ++threadIndex)
+	{
+		GetRetainedEvents(*m_threadBuffers[threadIndex], threadEvents[threadIndex]);
+		for (const ProfileEvent& event : threadEvents[threadIndex])
+		{
+			baseTicks = std::min(baseTicks, event.startTicks);
+		}
+	}
+
+	// Name the threads, then write every scope as a complete event.
+	fprintf(file, "{\"traceEvents\":[");
+	bool isFirstEvent = true;
+	for (size_t threadIndex = 0; threadIndex < m_threadBuffers.size(); ++threadIndex)
+	{
+		fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,\"args\":{\"name\":", isFirstEvent ? "" : ",", threadIndex);
+		WriteJsonString(file, m_threadBuffers[threadIndex]->threadName.c_str());
+		fprintf(file, "}}");
+		isFirstEvent = false;
+
+		for (const ProfileEvent& event : threadEvents[threadIndex])
+		{
+			fprintf(file, ",\n{\"name\":");
+			WriteJsonString(file, event.name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+				threadIndex,
+				static_cast<double>(event.startTicks - baseTicks) * microsecondsPerTick,
+				static_cast<double>(event.endTicks - event.startTicks) * microsecondsPerTick);
+		}
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(file);
+	return true;
+}
+
+bool Profiler::WriteFrameSummaryCsv(const char* a_filePath) const
+{
+#pragma warning(disable : 4996) // fopen unsafe warning.
+	FILE* file = fopen(a_filePath, "w");
+#pragma warning(default : 4996)
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s for writing.\n", a_filePath);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const double millisecondsPerTick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	// The frames still kept, oldest first.
+	std::vector<ProfileEvent> frames;
+	const size_t firstFrame = m_frameCount > FRAME_CAPACITY ? m_frameCount - FRAME_CAPACITY : 0;
+	for (size_t frameIndex = firstFrame; frameIndex < m_frameCount; ++frameIndex)
+	{
+		frames.push_back(m_frames[frameIndex & (FRAME_CAPACITY - 1)]);
+	}
+
+	// Calls and time of every name, per frame.
+	struct ScopeTotal final
+	{
+		size_t callCount = 0;		// 8 bytes.
+		Uint64 totalTicks = 0;		// 8 bytes.
+	};								// Total = 16 bytes.
+
+	std::vector<std::map<std::string, ScopeTotal>> frameTotals(frames.size());
+	std::vector<ProfileEvent> events;
+	for (const std::unique_ptr<ThreadBuffer>& threadBuffer : m_threadBuffers)
+	{
+		GetRetainedEvents(*threadBuffer, events);
+		for (const ProfileEvent& event : events)
+		{
+			if (event.name == FRAME_NAME)
+				continue;
+
+			// Find the frame the scope started in, if it was kept.
+			const auto frameIterator = std::upper_bound(frames.begin(), frames.end(), event.startTicks, [](Uint64 a_startTicks, const ProfileEvent& a_frame)
+			{
+				return a_startTicks < a_frame.startTicks;
+			});
+			if (frameIterator == frames.begin() || event.startTicks >= std::prev(frameIterator)->endTicks)
+				continue;
+
+			ScopeTotal& scopeTotal = frameTotals[std::prev(frameIterator) - frames.begin()][event.name];
+			++scopeTotal.callCount;
+			scopeTotal.totalTicks += event.endTicks - event.startTicks;
+		}
+	}
+
+	fprintf(file, "frame,scope,calls,total_ms\n");
+	for (size_t frameIndex = 0; frameIndex < frames.size(); ++frameIndex)
+	{
+		fprintf(file, "%zu,\"%s\",1,%.6f\n", firstFrame + frameIndex, FRAME_NAME, (frames[frameIndex].endTicks - frames[frameIndex].startTicks) * millisecondsPerTick);
+		for (const auto& scopeTotal : frameTotals[frameIndex])
+		{
+			fprintf(file, "%zu,", firstFrame + frameIndex);
+			WriteCsvString(file, scopeTotal.first.c_str());
+			fprintf(file, ",%zu,%.6f\n", scopeTotal.second.callCount, scopeTotal.second.totalTicks * millisecondsPerTick);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+#endif // ENGINE_PROFILER
@@ -0,0 +1,142 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+
+// Frame profiler, compiled in only when ENGINE_PROFILER is defined. Without it the profiling macros expand to nothing.
+#ifdef ENGINE_PROFILER
+
+#define PROFILE_CONCATENATE_INNER(A, B) A##B
+#define PROFILE_CONCATENATE(A, B) PROFILE_CONCATENATE_INNER(A, B)
+
+// Time the rest of the enclosing scope under the name, which must outlive the profiler, like a string literal.
+#define PROFILE_SCOPE(NAME) const ProfileScope PROFILE_CONCATENATE(profileScope, __LINE__)(NAME)
+
+// Time the rest of the enclosing scope as a frame. Scopes on every thread are summarized by the frame they start in.
+#define PROFILE_FRAME() const ProfileFrameScope PROFILE_CONCATENATE(profileFrameScope, __LINE__)
+
+// Name the calling thread in captures.
+#define PROFILE_THREAD(NAME) Profiler::GetInstanceWrite().SetThreadName(NAME)
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// A timed scope, in performance counter ticks.
+struct ProfileEvent final
+{
+	const char* name = nullptr;		// 8 bytes.
+	Uint64 startTicks = 0;			// 8 bytes.
+	Uint64 endTicks = 0;			// 8 bytes.
+};									// Total = 24 bytes.
+
+// Collects timed scopes from every thread. Each thread writes into a ring buffer of its own, so recording takes no lock
+// and never allocates, and once a buffer is full the oldest scopes are overwritten. Captures are read once the threads
+// are done recording, at shutdown.
+class Profiler final
+{
+public:
+	SINGLETON(Profiler);
+
+	Profiler() = default;
+	~Profiler() = default;
+
+	// Record a scope on the calling thread.
+	void RecordScope(const char* a_name, Uint64 a_startTicks, Uint64 an_endTicks)
+	{
+		RecordScope(GetThreadBuffer(), a_name, a_startTicks, an_endTicks);
+	}
+
+	void RecordFrame(Uint64 a_startTicks, Uint64 an_endTicks);
+
+	void SetThreadName(const char* a_threadName);
+
+	// Keep a copy of a name built at runtime, returning a pointer valid for as long as the profiler.
+	const char* InternName(const std::string& a_name);
+
+	// Write the capture as Chrome trace events, viewable in chrome://tracing or Perfetto.
+	bool WriteChromeTrace(const char* a_filePath) const;
+
+	// Write the calls and time of every scope name in every captured frame.
+	bool WriteFrameSummaryCsv(const char* a_filePath) const;
+
+private:
+	friend class ProfileScope;
+
+	static constexpr size_t THREAD_CAPACITY = 1 << 17;	// Scopes kept per thread, a power of two.
+	static constexpr size_t FRAME_CAPACITY = 1 << 12;	// Frames kept, a power of two.
+
+	// The scopes recorded by one thread. Only that thread writes them.
+	struct ThreadBuffer final
+	{
+		std::vector<ProfileEvent> events;		// Ring of the latest scopes.
+		std::atomic<size_t> eventCount{ 0 };	// Scopes ever recorded, the next one goes at this index modulo capacity.
+		std::string threadName;
+		unsigned int threadIndex = 0;
+	};
+
+	ThreadBuffer& GetThreadBuffer();
+
+	// Only the owning thread writes its buffer. Publish the count after the scope, so a reader never sees it half written.
+	static void RecordScope(ThreadBuffer& a_threadBuffer, const char* a_name, Uint64 a_startTicks, Uint64 an_endTicks)
+	{
+		const size_t eventCount = a_threadBuffer.eventCount.load(std::memory_order_relaxed);
+		a_threadBuffer.events[eventCount & (THREAD_CAPACITY - 1)] = { a_name, a_startTicks, an_endTicks };
+		a_threadBuffer.eventCount.store(eventCount + 1, std::memory_order_release);
+	}
+
+	// Copy out the scopes still in a buffer, oldest first.
+	static void GetRetainedEvents(const ThreadBuffer& a_threadBuffer, std::vector<ProfileEvent>& an_events);
+
+private:
+	mutable std::mutex m_mutex;								// Guards registering threads and interning names.
+	std::vector<std::unique_ptr<ThreadBuffer>> m_threadBuffers;
+	std::deque<std::string> m_internedNames;				// Deque so the names never move.
+	std::vector<ProfileEvent> m_frames;						// Ring of the latest frames, recorded by the main thread.
+	size_t m_frameCount = 0;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+// Records the time from construction to destruction. The thread's buffer is looked up before the clock starts, so only
+// writing the scope is left for the destructor.
+class ProfileScope final
+{
+public:
+	NO_COPY(ProfileScope);
+	NO_MOVE(ProfileScope);
+
+	explicit ProfileScope(const char* a_name)
+		: m_threadBuffer(Profiler::GetInstanceWrite().GetThreadBuffer())
+		, m_name(a_name)
+		, m_startTicks(SDL_GetPerformanceCounter())
+	{
+	}
+
+	~ProfileScope() { Profiler::RecordScope(m_threadBuffer, m_name, m_startTicks, SDL_GetPerformanceCounter()); }
+
+private:
+	Profiler::ThreadBuffer& m_threadBuffer;
+	const char* m_name;
+	Uint64 m_startTicks;
+};
+
+class ProfileFrameScope final
+{
+public:
+	NO_COPY(ProfileFrameScope);
+	NO_MOVE(ProfileFrameScope);
+
+	ProfileFrameScope() : m_startTicks(SDL_GetPerformanceCounter()) {}
+	~ProfileFrameScope() { Profiler::GetInstanceWrite().RecordFrame(m_startTicks, SDL_GetPerformanceCounter()); }
+
+private:
+	Uint64 m_startTicks;
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------
+
+#else
+
+#define PROFILE_SCOPE(NAME)
+#define PROFILE_FRAME()
+#define PROFILE_THREAD(NAME)
+
+#endif // ENGINE_PROFILER
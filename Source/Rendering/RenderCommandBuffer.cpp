@@ -0,0 +1,81 @@
+#include "PCH.h"
+#include "RenderCommandBuffer.h"
+
+void RenderCommandBuffer::Clear()
+{
+	m_commands.clear();
+	m_vertices.clear();
+	m_indices.clear();
+}
+
+void RenderCommandBuffer::RecordClear(SDL_Color a_color)
+{
+	RenderCommand command;
+	command.type = CommandType::ClearCommand;
+	command.color = a_color;
+	m_commands.push_back(command);
+}
+
+void RenderCommandBuffer::RecordSetTarget(SDL_Texture* a_texture)
+{
+	RenderCommand command;
+	command.type = CommandType::SetTargetCommand;
+	command.texture = a_texture;
+	m_commands.push_back(command);
+}
+
+void RenderCommandBuffer::RecordGeometry(SDL_Texture* a_texture, const std::vector<SDL_Vertex>& a_vertices, const std::vector<int>& an_indices)
+{
+	if (an_indices.empty())
+		return;
+
+	// Copy the geometry to the end of the shared arrays.
+	RenderCommand command;
+	command.type = CommandType::GeometryCommand;
+	command.texture = a_texture;
+	command.firstVertex = static_cast<unsigned int>(m_vertices.size());
+	command.vertexCount = static_cast<unsigned int>(a_vertices.size());
+	command.firstIndex = static_cast<unsigned int>(m_indices.size());
+	command.indexCount = static_cast<unsigned int>(an_indices.size());
+	m_commands.push_back(command);
+
+	m_vertices.insert(m_vertices.end(), a_vertices.begin(), a_vertices.end());
+	m_indices.insert(m_indices.end(), an_indices.begin(), an_indices.end());
+}
+
+void RenderCommandBuffer::RecordDrawRect(const SDL_Rect& a_rect, SDL_Color a_color)
+{
+	RenderCommand command;
+	command.type = CommandType::DrawRectCommand;
+	command.rect = a_rect;
+	command.color = a_color;
+	m_commands.push_back(command);
+}
+
+void RenderCommandBuffer::Execute(SDL_Renderer* a_renderer) const
+{
+	for (const RenderCommand& command : m_commands)
+	{
+		switch (command.type)
+		{
+		case CommandType::ClearCommand:
+			SDL_SetRenderDrawColor(a_renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+			SDL_RenderClear(a_renderer);
+			break;
+		case CommandType::SetTargetCommand:
+			SDL_SetRenderTarget(a_renderer, command.texture);
+			break;
+		case CommandType::GeometryCommand:
+			SDL_RenderGeometry(a_renderer, command.texture,
+				m_vertices.data() + command.firstVertex, static_cast<int>(command.vertexCount),
+				m_indices.data() + command.firstIndex, static_cast<int>(command.indexCount));
+			break;
+		case CommandType::DrawRectCommand:
+			SDL_SetRenderDrawColor(a_renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+			SDL_RenderDrawRect(a_renderer, &command.rect);
+			break;
+		default:
+			break;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+
+// The draw calls of a frame, recorded into flat arrays instead of made on the renderer, so the frame can be recorded on
+// one thread and played back on another. Commands are played back in the order they were recorded. Geometry is copied
+// into a single vertex and index array shared by every command, and the arrays keep their memory between frames.
+class RenderCommandBuffer final
+{
+public:
+	NO_COPY(RenderCommandBuffer);
+	NO_MOVE(RenderCommandBuffer);
+
+	RenderCommandBuffer() = default;
+	~RenderCommandBuffer() = default;
+
+	// Drop every command, keeping the memory.
+	void Clear();
+
+	// Fill the current target with a color.
+	void RecordClear(SDL_Color a_color);
+
+	// Draw into the texture from now on, or onto the screen if null.
+	void RecordSetTarget(SDL_Texture* a_texture);
+
+	// Draw triangles from the texture, or plain colored if null. Indices are relative to the first of the vertices.
+	void RecordGeometry(SDL_Texture* a_texture, const std::vector<SDL_Vertex>& a_vertices, const std::vector<int>& an_indices);
+
+	// Draw the outline of a rectangle.
+	void RecordDrawRect(const SDL_Rect& a_rect, SDL_Color a_color);
+
+	// Make the recorded calls on the renderer. Must run on the only thread using the renderer at the time.
+	void Execute(SDL_Renderer* a_renderer) const;
+
+	size_t GetCommandCount() const { return m_commands.size(); }
+	size_t GetVertexCount() const { return m_vertices.size(); }
+
+private:
+	enum class CommandType : unsigned char
+	{
+		ClearCommand = 0,
+		SetTargetCommand,
+		GeometryCommand,
+		DrawRectCommand
+	};
+
+	// A recorded draw call. Which fields are used depends on the type.
+	struct RenderCommand final
+	{
+		SDL_Texture* texture = nullptr;		// 8 bytes. Set target and geometry.
+		SDL_Rect rect = { 0, 0, 0, 0 };		// 16 bytes. Draw rect.
+		unsigned int firstVertex = 0;		// 4 bytes. Geometry.
+		unsigned int vertexCount = 0;		// 4 bytes. Geometry.
+		unsigned int firstIndex = 0;		// 4 bytes. Geometry.
+		unsigned int indexCount = 0;		// 4 bytes. Geometry.
+		SDL_Color color = { 0, 0, 0, 0 };	// 4 bytes. Clear and draw rect.
+		CommandType type = CommandType::ClearCommand;	// 1 byte.
+	};										// Total = 48 bytes with padding.
+
+private:
+	std::vector<RenderCommand> m_commands;
+	std::vector<SDL_Vertex> m_vertices;		// Vertices of every geometry command, back to back.
+	std::vector<int> m_indices;				// Indices of every geometry command, back to back.
+};
@@ -0,0 +1,150 @@
+#include "PCH.h"
+#include "RenderQueue.h"
+
+uint64_t RenderQueue::MakeSortKey(RenderOrder a_renderOrder, unsigned int a_texturePage, float a_depth, Entity an_entity)
+{
+	const uint64_t textureBits = static_cast<uint64_t>(a_texturePage) & ((1ull << TEXTURE_BITS) - 1);
+
+	// Offset the depth so negative positions sort before positive ones.
+	constexpr float depthBias = static_cast<float>(1 << (DEPTH_BITS - 1));
+	constexpr float maxDepth = static_cast<float>((1 << DEPTH_BITS) - 1);
+	const uint64_t depthBits = static_cast<uint64_t>(std::min(std::max(floorf(a_depth) + depthBias, 0.0f), maxDepth));
+
+	return static_cast<uint64_t>(a_renderOrder) << RENDER_ORDER_SHIFT
+		| textureBits << TEXTURE_SHIFT
+		| depthBits << DEPTH_SHIFT
+		| (static_cast<uint64_t>(an_entity) & ((1ull << ENTITY_BITS) - 1));
+}
+
+void RenderQueue::Sort()
+{
+	m_wasLastSortIncremental = false;
+	if (m_items.size() <= INSERTION_SORT_MAX_COUNT)
+	{
+		InsertionSort(m_items, ~size_t(0));
+	}
+	else
+	{
+		// Start from last frame's order, and see if it only needs a few touches.
+		ArrangeInPreviousOrder();
+		if (InsertionSort(m_scratchItems, m_scratchItems.size() * MAX_SHIFTS_PER_ITEM))
+		{
+			m_items.swap(m_scratchItems);
+			m_wasLastSortIncremental = true;
+		}
+		else
+		{
+			RadixSort();
+		}
+	}
+
+	RememberOrder();
+}
+
+void RenderQueue::ArrangeInPreviousOrder()
+{
+	// Drop every item in the slot of its entity's last position, and collect the rest after them.
+	m_rankItemIndices.assign(m_previousEntities.size(), NO_ITEM);
+	m_scratchItems.clear();
+	for (size_t itemIndex = 0; itemIndex < m_items.size(); ++itemIndex)
+	{
+		const Entity entity = m_items[itemIndex].entity;
+		const unsigned int rank = entity < m_previousRanks.size() ? m_previousRanks[entity] : NO_ITEM;
+		const bool wasQueued = rank < m_previousEntities.size() && m_previousEntities[rank] == entity;
+		if (wasQueued && m_rankItemIndices[rank] == NO_ITEM)
+			m_rankItemIndices[rank] = static_cast<unsigned int>(itemIndex);
+		else
+			m_scratchItems.push_back(m_items[itemIndex]);
+	}
+
+	// Lay the slotted items out ahead of the new ones.
+	const size_t newItemCount = m_scratchItems.size();
+	m_scratchItems.resize(m_items.size());
+	std::move_backward(m_scratchItems.begin(), m_scratchItems.begin() + newItemCount, m_scratchItems.end());
+
+	size_t arrangedCount = 0;
+	for (const unsigned int itemIndex : m_rankItemIndices)
+	{
+		if (itemIndex != NO_ITEM)
+			m_scratchItems[arrangedCount++] = m_items[itemIndex];
+	}
+}
+
+bool RenderQueue::InsertionSort(std::vector<RenderItem>& a_items, size_t a_maxShiftCount)
+{
+	size_t shiftCount = 0;
+	for (size_t itemIndex = 1; itemIndex < a_items.size(); ++itemIndex)
+	{
+		// Shift the larger items up, strictly larger so equal keys keep their order.
+		const RenderItem item = a_items[itemIndex];
+		size_t insertIndex = itemIndex;
+		while (insertIndex > 0 && a_items[insertIndex - 1].sortKey > item.sortKey)
+		{
+			a_items[insertIndex] = a_items[insertIndex - 1];
+			--insertIndex;
+		}
+		a_items[insertIndex] = item;
+
+		shiftCount += itemIndex - insertIndex;
+		if (shiftCount > a_maxShiftCount)
+			return false;
+	}
+
+	return true;
+}
+
+void RenderQueue::RadixSort()
+{
+	constexpr int DIGIT_BITS = 8;
+	constexpr int DIGIT_COUNT = 64 / DIGIT_BITS;
+	constexpr size_t BUCKET_COUNT = 1 << DIGIT_BITS;
+
+	// Count every digit of every key in a single pass.
+	size_t bucketCounts[DIGIT_COUNT][BUCKET_COUNT] = {};
+	for (const RenderItem& item : m_items)
+	{
+		for (int digit = 0; digit < DIGIT_COUNT; ++digit)
+		{
+			++bucketCounts[digit][(item.sortKey >> (digit * DIGIT_BITS)) & (BUCKET_COUNT - 1)];
+		}
+	}
+
+	// Scatter by each digit, least significant first. Each pass is stable, so the order of the earlier digits holds.
+	m_scratchItems.resize(m_items.size());
+	for (int digit = 0; digit < DIGIT_COUNT; ++digit)
+	{
+		// Skip digits all keys share, such as the top bits of the render order.
+		const int shift = digit * DIGIT_BITS;
+		size_t* const counts = bucketCounts[digit];
+		if (counts[(m_items[0].sortKey >> shift) & (BUCKET_COUNT - 1)] == m_items.size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+		{
+			const size_t count = counts[bucket];
+			counts[bucket] = offset;
+			offset += count;
+		}
+
+		for (const RenderItem& item : m_items)
+		{
+			m_scratchItems[counts[(item.sortKey >> shift) & (BUCKET_COUNT - 1)]++] = item;
+		}
+		m_items.swap(m_scratchItems);
+	}
+}
+
+void RenderQueue::RememberOrder()
+{
+	m_previousEntities.resize(m_items.size());
+	for (size_t itemIndex = 0; itemIndex < m_items.size(); ++itemIndex)
+	{
+		const Entity entity = m_items[itemIndex].entity;
+		if (entity >= m_previousRanks.size())
+			m_previousRanks.resize(entity * 2 + 1, NO_ITEM);
+
+		m_previousEntities[itemIndex] = entity;
+		m_previousRanks[entity] = static_cast<unsigned int>(itemIndex);
+	}
+}
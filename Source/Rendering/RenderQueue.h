@@ -0,0 +1,71 @@
+#pragma once
+#include "PCH.h"
+#include "ECS\Types.h"
+#include "Enums\Enums.h"
+
+// The things to draw this frame, each behind a 64-bit key packing everything the draw order depends on, so sorting
+// compares plain integers and never looks anything up. The queue is sorted with a stable LSD radix sort. When the items
+// come back in nearly last frame's order, as they do while the camera and entities drift, the queue is laid out in last
+// frame's order and finished with an insertion sort instead.
+class RenderQueue final
+{
+public:
+	// An item to draw, behind its sort key.
+	struct RenderItem final
+	{
+		uint64_t sortKey = 0;		// 8 bytes.
+		Entity entity = 0;			// 8 bytes.
+	};								// Total = 16 bytes.
+
+	// Pack the draw order of an entity, from most to least significant: its render order, the texture page it draws
+	// from so entities sharing one batch together, its depth so lower entities overlap higher ones, and the entity itself
+	// to break ties. Depth is in whole pixels and clamped to about half a million pixels either way, and only the low
+	// bits of the page and entity are kept, which only costs batching or tie order when they alias.
+	static uint64_t MakeSortKey(RenderOrder a_renderOrder, unsigned int a_texturePage, float a_depth, Entity an_entity);
+	static RenderOrder GetRenderOrder(uint64_t a_sortKey) { return static_cast<RenderOrder>(a_sortKey >> RENDER_ORDER_SHIFT); }
+
+	RenderQueue() = default;
+	~RenderQueue() = default;
+
+	void Clear() { m_items.clear(); }
+	void Push(uint64_t a_sortKey, Entity an_entity) { m_items.push_back({ a_sortKey, an_entity }); }
+
+	// Sort the items by key. The sort is stable: items with equal keys keep the order they were pushed in, or the order
+	// they had last frame when that order is reused.
+	void Sort();
+
+	const std::vector<RenderItem>& GetItemsRead() const { return m_items; }
+
+	// Whether the last sort reused the previous frame's order rather than sorting from scratch.
+	bool WasLastSortIncremental() const { return m_wasLastSortIncremental; }
+
+private:
+	static constexpr int RENDER_ORDER_BITS = 4;
+	static constexpr int TEXTURE_BITS = 16;
+	static constexpr int DEPTH_BITS = 20;
+	static constexpr int ENTITY_BITS = 24;
+	static constexpr int DEPTH_SHIFT = ENTITY_BITS;
+	static constexpr int TEXTURE_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+	static constexpr int RENDER_ORDER_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+	static_assert(RENDER_ORDER_SHIFT + RENDER_ORDER_BITS == 64, "The sort key fields must fill 64 bits.");
+
+	static constexpr size_t INSERTION_SORT_MAX_COUNT = 64;	// Below this, an insertion sort beats the radix passes.
+	static constexpr size_t MAX_SHIFTS_PER_ITEM = 4;		// Shifts per item an insertion sort may make before giving up.
+	static constexpr unsigned int NO_ITEM = ~0u;
+
+	// Lay the items out in the order their entities were sorted into last frame, new entities last.
+	void ArrangeInPreviousOrder();
+
+	// Insertion sort, giving up once it made more shifts than allowed. Returns false if it gave up.
+	static bool InsertionSort(std::vector<RenderItem>& a_items, size_t a_maxShiftCount);
+	void RadixSort();
+	void RememberOrder();
+
+private:
+	std::vector<RenderItem> m_items;
+	std::vector<RenderItem> m_scratchItems;				// Other buffer of the radix passes and the previous order layout.
+	std::vector<Entity> m_previousEntities;				// Entities in last frame's sorted order.
+	std::vector<unsigned int> m_previousRanks;			// Position of each entity in last frame's order, indexed by entity.
+	std::vector<unsigned int> m_rankItemIndices;		// Item at each position of last frame's order, scratch.
+	bool m_wasLastSortIncremental = false;
+};
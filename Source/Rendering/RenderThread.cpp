@@ -0,0 +1,113 @@
+#include "PCH.h"
+#include "RenderThread.h"
+#include "Memory\AllocationCounter.h"
+#include "Profiler\Profiler.h"
+#include "Timing.h"
+
+RenderThread::~RenderThread()
+{
+	Shutdown();
+}
+
+void RenderThread::Initialize(SDL_Renderer* a_renderer, bool an_isThreaded)
+{
+	assert(!m_thread.joinable() && "The render thread is already running.");
+
+	m_renderer = a_renderer;
+	m_isShuttingDown = false;
+	if (an_isThreaded)
+		m_thread = std::thread(&RenderThread::ThreadLoop, this);
+}
+
+void RenderThread::Shutdown()
+{
+	if (!m_thread.joinable())
+		return;
+
+	// Let the last frame finish, then wake the thread up to exit.
+	WaitForIdle();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShuttingDown = true;
+	}
+	m_frameSubmitted.notify_one();
+
+	m_thread.join();
+}
+
+void RenderThread::SubmitFrame()
+{
+	// The other buffer may still be playing back, and is recorded into next.
+	WaitForIdle();
+
+	const unsigned int submittedIndex = m_recordingIndex;
+	m_recordingIndex ^= 1;
+	m_commandBuffers[m_recordingIndex].Clear();
+
+	if (!m_thread.joinable())
+	{
+		ExecuteFrame(m_commandBuffers[submittedIndex]);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isFramePending = true;
+	}
+	m_frameSubmitted.notify_one();
+}
+
+void RenderThread::WaitForIdle()
+{
+	if (!m_thread.joinable())
+		return;
+
+	PROFILE_SCOPE("RenderThread::WaitForIdle");
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_frameExecuted.wait(lock, [this]() { return !m_isFramePending; });
+	m_waitMilliseconds += MillisecondsSince(startTicks);
+}
+
+void RenderThread::ThreadLoop()
+{
+	PROFILE_THREAD("Render");
+
+	while (true)
+	{
+		// Sleep until a frame is submitted.
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_frameSubmitted.wait(lock, [this]() { return m_isShuttingDown || m_isFramePending; });
+			if (m_isShuttingDown)
+				return;
+		}
+
+		// The submitted frame is the buffer not being recorded, which stays put until the frame is marked done.
+		ExecuteFrame(m_commandBuffers[m_recordingIndex ^ 1]);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isFramePending = false;
+		}
+		m_frameExecuted.notify_all();
+	}
+}
+
+void RenderThread::ExecuteFrame(const RenderCommandBuffer& a_commandBuffer)
+{
+	ALLOCATION_SCOPE(AllocationTag::Render);
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
+
+	// Make the recorded calls, and swap the front and back buffers.
+	{
+		PROFILE_SCOPE("RenderCommandBuffer::Execute");
+		a_commandBuffer.Execute(m_renderer);
+	}
+	{
+		PROFILE_SCOPE("SDL_RenderPresent");
+		SDL_RenderPresent(m_renderer);
+	}
+
+	m_executeMilliseconds += MillisecondsSince(startTicks);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+#include "RenderCommandBuffer.h"
+
+// Plays back the recorded frames on the renderer from a thread of its own, so the next frame is simulated and recorded
+// while the last one is drawn and presented. Frames are recorded into one of two command buffers while the other is
+// played back, and submitting a frame waits for the previous one to be done, so the two threads are never more than a
+// frame apart. The renderer is not thread safe, so anything else using it has to wait for the thread to go idle first.
+// SDL requires every rendering call to come from the main thread, with or without a window, so playing frames back on a
+// thread of their own is unsupported by SDL and only meant for experimenting with the headless backends.
+class RenderThread final
+{
+public:
+	NO_COPY(RenderThread);
+	NO_MOVE(RenderThread);
+
+	RenderThread() = default;
+	~RenderThread();
+
+	// Start playing frames back on the renderer. Without a thread of its own, frames are played back on the calling
+	// thread as they are submitted.
+	void Initialize(SDL_Renderer* a_renderer, bool an_isThreaded);
+	void Shutdown();
+
+	// Buffer to record the next frame into.
+	RenderCommandBuffer& GetRecordingBufferWrite() { return m_commandBuffers[m_recordingIndex]; }
+
+	// Hand the recorded frame over to be played back and presented, and start recording the next one.
+	void SubmitFrame();
+
+	// Wait until every submitted frame is presented. Call before using the renderer on another thread.
+	void WaitForIdle();
+
+	bool IsThreaded() const { return m_thread.joinable(); }
+
+	// Time spent playing back and presenting frames, and the time the submitting thread spent waiting on it. Only read
+	// once the thread is idle.
+	double GetExecuteMilliseconds() const { return m_executeMilliseconds; }
+	double GetWaitMilliseconds() const { return m_waitMilliseconds; }
+
+private:
+	void ThreadLoop();
+	void ExecuteFrame(const RenderCommandBuffer& a_commandBuffer);
+
+private:
+	SDL_Renderer* m_renderer = nullptr;
+	RenderCommandBuffer m_commandBuffers[2];
+	unsigned int m_recordingIndex = 0;			// Buffer being recorded, the other one is the last frame submitted.
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_frameSubmitted;	// Signaled when a frame is submitted, or on shutdown.
+	std::condition_variable m_frameExecuted;	// Signaled when the thread is done with a frame.
+	bool m_isFramePending = false;				// A frame is submitted and not yet presented.
+	bool m_isShuttingDown = false;
+
+	double m_executeMilliseconds = 0.0;
+	double m_waitMilliseconds = 0.0;
+};
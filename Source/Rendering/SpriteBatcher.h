@@ -0,0 +1,68 @@
+#pragma once
+#include "PCH.h"
+#include "Macros.h"
+#include "RenderCommandBuffer.h"
+
+// Collects textured and plain colored quads into vertex and index buffers, and records every run of quads sharing a
+// texture as a single geometry command, played back as one SDL_RenderGeometry call instead of one copy or fill call per
+// quad. Rotation is applied on the CPU while writing the vertices. Quads are drawn in the order they are added, so
+// callers sorting by texture within a layer get the fewest submissions.
+class SpriteBatcher final
+{
+public:
+	NO_COPY(SpriteBatcher);
+	NO_MOVE(SpriteBatcher);
+
+	// Counters since they were last reset, once a frame, over every batch of the frame.
+	struct BatchStatistics final
+	{
+		size_t quadCount = 0;				// 8 bytes.
+		size_t drawCallCount = 0;			// 8 bytes. Geometry commands, each one SDL_RenderGeometry call.
+		double buildMilliseconds = 0.0;		// 8 bytes. Time between flushes, writing vertices and whatever else the caller did.
+		double submitMilliseconds = 0.0;	// 8 bytes. Time spent recording the runs into the command buffer.
+	};										// Total = 32 bytes.
+
+	SpriteBatcher() = default;
+	~SpriteBatcher() = default;
+
+	// Start a batch recorded into the command buffer. A frame may run several, like the ones baking tile chunks.
+	void Begin(RenderCommandBuffer& a_commandBuffer);
+
+	// Queue a region of a texture drawn to a destination rectangle, rotated clockwise by degrees around its center, like
+	// SDL_RenderCopyEx with no center given. The texture size comes from the caller, which knows it without asking SDL.
+	void DrawSprite(SDL_Texture* a_texture, const SDL_Point& a_textureSize, const SDL_Rect& a_sourceRect, const SDL_FRect& a_destinationRect, float a_rotation);
+
+	// Queue a rectangle filled with a plain color.
+	void DrawFilledRect(const SDL_FRect& a_rect, SDL_Color a_color);
+
+	// Record the quads queued so far. Call before recording anything else into the command buffer.
+	void Flush();
+
+	// Record what is left, and finish the frame.
+	void End();
+
+	// Without submission the batcher records nothing and only counts what it would have drawn, to measure everything up to
+	// the renderer.
+	void SetSubmitEnabled(bool an_isSubmitEnabled) { m_isSubmitEnabled = an_isSubmitEnabled; }
+
+	const BatchStatistics& GetStatisticsRead() const { return m_statistics; }
+	void ResetStatistics() { m_statistics = BatchStatistics(); }
+
+private:
+	// Start a new run if the texture differs from the current one.
+	void SetTexture(SDL_Texture* a_texture, const SDL_Point& a_textureSize);
+	void AddQuadIndices();
+
+private:
+	RenderCommandBuffer* m_commandBuffer = nullptr;
+	SDL_Texture* m_texture = nullptr;			// Texture of the current run, null for plain colored quads.
+	float m_inverseTextureWidth = 0.0f;			// Maps texels to normalized texture coordinates.
+	float m_inverseTextureHeight = 0.0f;
+	bool m_isRunStarted = false;
+	bool m_isSubmitEnabled = true;
+
+	std::vector<SDL_Vertex> m_vertices;			// Four per quad.
+	std::vector<int> m_indices;					// Two triangles per quad.
+	BatchStatistics m_statistics;
+	Uint64 m_buildStartTicks = 0;				// When vertices started being written for the current run.
+};
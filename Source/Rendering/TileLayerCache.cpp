@@ -0,0 +1,181 @@
+#include "PCH.h"
+#include "TileLayerCache.h"
+
+TileLayerCache::TileLayerCache(int a_worldWidth, int a_worldHeight, int a_chunkSize, size_t a_maxTextureCount)
+	: m_worldWidth(std::max(1, a_worldWidth))
+	, m_worldHeight(std::max(1, a_worldHeight))
+	, m_chunkSize(a_chunkSize)
+	, m_maxTextureCount(a_maxTextureCount)
+{
+	assert(a_chunkSize > 0 && "Chunks must have a size.");
+
+	// Cover the world, the last column and row of chunks may stick out past it.
+	m_columnCount = (m_worldWidth + m_chunkSize - 1) / m_chunkSize;
+	m_rowCount = (m_worldHeight + m_chunkSize - 1) / m_chunkSize;
+	m_chunks.resize(static_cast<size_t>(m_columnCount) * m_rowCount);
+}
+
+TileLayerCache::~TileLayerCache()
+{
+	for (Chunk& chunk : m_chunks)
+	{
+		ReleaseTexture(chunk);
+	}
+}
+
+void TileLayerCache::AddEntity(Entity an_entity, const AABB& a_bounds)
+{
+	if (an_entity >= m_entityChunkRanges.size())
+		m_entityChunkRanges.resize(an_entity * 2 + 1);
+
+	assert(!HaveEntity(an_entity) && "The entity is already baked.");
+	const ChunkRange chunkRange = GetChunkRange(a_bounds);
+	m_entityChunkRanges[an_entity] = chunkRange;
+
+	// An entity straddling chunks is drawn into each of them, and clipped by their edges.
+	for (int row = chunkRange.firstRow; row <= chunkRange.lastRow; ++row)
+	{
+		for (int column = chunkRange.firstColumn; column <= chunkRange.lastColumn; ++column)
+		{
+			Chunk& chunk = m_chunks[static_cast<size_t>(row) * m_columnCount + column];
+			chunk.entities.push_back(an_entity);
+			chunk.isBaked = false;
+		}
+	}
+}
+
+void TileLayerCache::RemoveEntity(Entity an_entity)
+{
+	if (!HaveEntity(an_entity))
+		return;
+
+	const ChunkRange chunkRange = m_entityChunkRanges[an_entity];
+	for (int row = chunkRange.firstRow; row <= chunkRange.lastRow; ++row)
+	{
+		for (int column = chunkRange.firstColumn; column <= chunkRange.lastColumn; ++column)
+		{
+			// Swap and pop, the entities are sorted when the chunk is baked.
+			Chunk& chunk = m_chunks[static_cast<size_t>(row) * m_columnCount + column];
+			const auto entityIterator = std::find(chunk.entities.begin(), chunk.entities.end(), an_entity);
+			*entityIterator = chunk.entities.back();
+			chunk.entities.pop_back();
+			chunk.isBaked = false;
+		}
+	}
+
+	m_entityChunkRanges[an_entity] = ChunkRange();
+}
+
+void TileLayerCache::InvalidateAll()
+{
+	for (Chunk& chunk : m_chunks)
+	{
+		ReleaseTexture(chunk);
+	}
+}
+
+void TileLayerCache::QueryVisibleChunks(const AABB& a_viewport, std::vector<unsigned int>& a_chunkIndices)
+{
+	++m_frameStamp;
+
+	// Skip viewports entirely off the world, clamping would find the border chunks.
+	if (a_viewport.maxX <= 0.0f || a_viewport.maxY <= 0.0f || a_viewport.minX >= m_worldWidth || a_viewport.minY >= m_worldHeight)
+		return;
+
+	const ChunkRange chunkRange = GetChunkRange(a_viewport);
+	for (int row = chunkRange.firstRow; row <= chunkRange.lastRow; ++row)
+	{
+		for (int column = chunkRange.firstColumn; column <= chunkRange.lastColumn; ++column)
+		{
+			const unsigned int chunkIndex = static_cast<unsigned int>(row * m_columnCount + column);
+			m_chunks[chunkIndex].lastVisibleFrame = m_frameStamp;
+			a_chunkIndices.push_back(chunkIndex);
+		}
+	}
+}
+
+bool TileLayerCache::BeginBake(SDL_Renderer* a_renderer, RenderCommandBuffer& a_commandBuffer, unsigned int a_chunkIndex)
+{
+	Chunk& chunk = m_chunks[a_chunkIndex];
+	if (!chunk.texture)
+	{
+		if (m_textureCount >= m_maxTextureCount)
+			ReleaseOldestTexture();
+
+		// Transparent where nothing is baked, so the clear color shows through past the edge of the map.
+		const SDL_Rect chunkRect = GetChunkRect(a_chunkIndex);
+		chunk.texture = SDL_CreateTexture(a_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, chunkRect.w, chunkRect.h);
+		if (!chunk.texture)
+			return false;
+
+		// Baking blends the tiles onto transparent, which leaves the chunk's colors already multiplied by its alpha. Drawing
+		// it must add them rather than blend them in again, or semi-transparent edges get their alpha applied twice.
+		// Renderers without custom blend modes, like the software one, fall back to plain blending.
+		static const SDL_BlendMode premultipliedBlendMode = SDL_ComposeCustomBlendMode(
+			SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+			SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+		if (SDL_SetTextureBlendMode(chunk.texture, premultipliedBlendMode) != 0)
+			SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+		++m_textureCount;
+	}
+
+	// Draw into the chunk, starting from clear.
+	a_commandBuffer.RecordSetTarget(chunk.texture);
+	a_commandBuffer.RecordClear({ 0, 0, 0, 0 });
+	return true;
+}
+
+void TileLayerCache::EndBake(RenderCommandBuffer& a_commandBuffer, unsigned int a_chunkIndex)
+{
+	// Bakes are recorded ahead of everything drawn on the screen, so the screen is always the target to go back to.
+	a_commandBuffer.RecordSetTarget(nullptr);
+	m_chunks[a_chunkIndex].isBaked = true;
+}
+
+SDL_Rect TileLayerCache::GetChunkRect(unsigned int a_chunkIndex) const
+{
+	const int x = static_cast<int>(a_chunkIndex % m_columnCount) * m_chunkSize;
+	const int y = static_cast<int>(a_chunkIndex / m_columnCount) * m_chunkSize;
+	return { x, y, std::min(m_chunkSize, m_worldWidth - x), std::min(m_chunkSize, m_worldHeight - y) };
+}
+
+TileLayerCache::ChunkRange TileLayerCache::GetChunkRange(const AABB& a_bounds) const
+{
+	// Bounds past the world are clamped onto the border chunks. A maximum on a chunk edge doesn't reach into the next.
+	const auto toCell = [chunkSize = static_cast<float>(m_chunkSize)](float a_coordinate, int a_cellCount)
+	{
+		return std::min(std::max(static_cast<int>(floorf(a_coordinate / chunkSize)), 0), a_cellCount - 1);
+	};
+
+	ChunkRange chunkRange;
+	chunkRange.firstColumn = toCell(a_bounds.minX, m_columnCount);
+	chunkRange.firstRow = toCell(a_bounds.minY, m_rowCount);
+	chunkRange.lastColumn = std::max(chunkRange.firstColumn, toCell(std::nextafter(a_bounds.maxX, a_bounds.minX), m_columnCount));
+	chunkRange.lastRow = std::max(chunkRange.firstRow, toCell(std::nextafter(a_bounds.maxY, a_bounds.minY), m_rowCount));
+	return chunkRange;
+}
+
+void TileLayerCache::ReleaseTexture(Chunk& a_chunk)
+{
+	a_chunk.isBaked = false;
+	if (!a_chunk.texture)
+		return;
+
+	SDL_DestroyTexture(a_chunk.texture);
+	a_chunk.texture = nullptr;
+	--m_textureCount;
+}
+
+void TileLayerCache::ReleaseOldestTexture()
+{
+	// Chunks in view this frame keep their textures, even if that means going over the budget.
+	Chunk* oldestChunk = nullptr;
+	for (Chunk& chunk : m_chunks)
+	{
+		if (chunk.texture && chunk.lastVisibleFrame != m_frameStamp && (!oldestChunk || chunk.lastVisibleFrame < oldestChunk->lastVisibleFrame))
+			oldestChunk = &chunk;
+	}
+
+	if (oldestChunk)
+		ReleaseTexture(*oldestChunk);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "PCH.h"
+#include "Collision\AABB.h"
+#include "ECS\Types.h"
+#include "Macros.h"
+#include "RenderCommandBuffer.h"
+
+// The static bottom layers of the map, tiles and scenery, baked into textures one square chunk of the map at a time.
+// A chunk is drawn into its texture the first time it shows up and again only after something in it changes, so the
+// camera costs one copy per visible chunk instead of one per tile. Chunk textures are created as chunks come into view,
+// and past a budget the ones out of view the longest give theirs up, so large maps don't hold a texture per chunk.
+class TileLayerCache final
+{
+public:
+	NO_COPY(TileLayerCache);
+	NO_MOVE(TileLayerCache);
+
+	TileLayerCache(int a_worldWidth, int a_worldHeight, int a_chunkSize = 512, size_t a_maxTextureCount = 32);
+	~TileLayerCache();
+
+	// Bake the entity into the chunks its bounds overlap, and mark them for a redraw.
+	void AddEntity(Entity an_entity, const AABB& a_bounds);
+	void RemoveEntity(Entity an_entity);
+
+	// Mark every chunk for a redraw and release their textures, as needed once the renderer lost its render targets.
+	// Releasing textures uses the renderer, so nothing else may be using it.
+	void InvalidateAll();
+
+	// Write out the chunks overlapping the viewport, and mark them as seen this frame. Call once per frame.
+	void QueryVisibleChunks(const AABB& a_viewport, std::vector<unsigned int>& a_chunkIndices);
+
+	// Record pointing the renderer at the texture of the chunk and clearing it, creating the texture if needed. Anything
+	// recorded until the bake ends goes into the chunk, with the top left corner of the chunk at the origin, and the
+	// screen is the target again after. Creating and releasing textures uses the renderer, so nothing else may be using
+	// it. Returns false if there is no texture to draw into.
+	bool BeginBake(SDL_Renderer* a_renderer, RenderCommandBuffer& a_commandBuffer, unsigned int a_chunkIndex);
+	void EndBake(RenderCommandBuffer& a_commandBuffer, unsigned int a_chunkIndex);
+
+	bool IsChunkBaked(unsigned int a_chunkIndex) const { return m_chunks[a_chunkIndex].isBaked; }
+	const std::vector<Entity>& GetChunkEntitiesRead(unsigned int a_chunkIndex) const { return m_chunks[a_chunkIndex].entities; }
+	SDL_Texture* GetChunkTexture(unsigned int a_chunkIndex) const { return m_chunks[a_chunkIndex].texture; }
+
+	// Where the chunk lies in the world, in pixels.
+	SDL_Rect GetChunkRect(unsigned int a_chunkIndex) const;
+
+	bool HaveEntity(Entity an_entity) const { return an_entity < m_entityChunkRanges.size() && m_entityChunkRanges[an_entity].firstColumn >= 0; }
+
+private:
+	// A square of the map and what is baked into it.
+	struct Chunk final
+	{
+		std::vector<Entity> entities;		// 24 bytes. Unordered, sorted when baked.
+		SDL_Texture* texture = nullptr;		// 8 bytes.
+		unsigned int lastVisibleFrame = 0;	// 4 bytes. Frame the chunk was last in view, to pick textures to release.
+		bool isBaked = false;				// 1 byte. The texture holds the current entities.
+	};										// Total = 40 bytes with padding.
+
+	// The chunks an entity was added to, inclusive. Columns are negative for entities not in the cache.
+	struct ChunkRange final
+	{
+		int firstColumn = -1;	// 4 bytes.
+		int firstRow = -1;		// 4 bytes.
+		int lastColumn = -1;	// 4 bytes.
+		int lastRow = -1;		// 4 bytes.
+	};							// Total = 16 bytes.
+
+	ChunkRange GetChunkRange(const AABB& a_bounds) const;
+	void ReleaseTexture(Chunk& a_chunk);
+
+	// Give up the texture of the chunk out of view the longest, to stay within the budget.
+	void ReleaseOldestTexture();
+
+private:
+	int m_worldWidth = 0;
+	int m_worldHeight = 0;
+	int m_chunkSize = 0;
+	int m_columnCount = 0;
+	int m_rowCount = 0;
+	size_t m_maxTextureCount = 0;
+	size_t m_textureCount = 0;
+	unsigned int m_frameStamp = 0;
+
+	std::vector<Chunk> m_chunks;					// Row by row.
+	std::vector<ChunkRange> m_entityChunkRanges;	// Indexed by entity.
+};
@@ -0,0 +1,68 @@
+#include "PCH.h"
+#include "ViewportCuller.h"
+
+ViewportCuller::ViewportCuller(float a_worldWidth, float a_worldHeight, float a_staticCellSize, float a_dynamicFatMargin)
+	: m_staticGrid(a_worldWidth, a_worldHeight, a_staticCellSize)
+	, m_dynamicTree(a_dynamicFatMargin)
+{
+}
+
+void ViewportCuller::AddStaticEntity(Entity an_entity, const AABB& a_bounds)
+{
+	if (an_entity >= m_staticProxyIndices.size())
+		m_staticProxyIndices.resize(an_entity * 2 + 1, NO_PROXY);
+
+	assert(m_staticProxyIndices[an_entity] == NO_PROXY && "The entity is already static.");
+	m_staticProxyIndices[an_entity] = static_cast<unsigned int>(m_staticProxies.size());
+	m_staticProxies.push_back({ a_bounds, an_entity });
+	m_isStaticGridDirty = true;
+}
+
+void ViewportCuller::RemoveStaticEntity(Entity an_entity)
+{
+	if (an_entity >= m_staticProxyIndices.size() || m_staticProxyIndices[an_entity] == NO_PROXY)
+		return;
+
+	// Swap and pop, the order of the static proxies doesn't matter.
+	const unsigned int proxyIndex = m_staticProxyIndices[an_entity];
+	m_staticProxies[proxyIndex] = m_staticProxies.back();
+	m_staticProxyIndices[m_staticProxies[proxyIndex].entity] = proxyIndex;
+	m_staticProxies.pop_back();
+	m_staticProxyIndices[an_entity] = NO_PROXY;
+	m_isStaticGridDirty = true;
+}
+
+void ViewportCuller::UpdateDynamicEntities(const std::vector<BroadphaseProxy>& a_proxies)
+{
+	m_dynamicTree.Update(a_proxies);
+
+	m_dynamicEntities.resize(a_proxies.size());
+	for (size_t proxyIndex = 0; proxyIndex < a_proxies.size(); ++proxyIndex)
+	{
+		m_dynamicEntities[proxyIndex] = a_proxies[proxyIndex].entity;
+	}
+}
+
+void ViewportCuller::QueryVisibleEntities(const AABB& a_viewport, std::vector<Entity>& an_entities)
+{
+	// Static entities rarely change, so rebuilding the grid from scratch when they do is cheap enough.
+	if (m_isStaticGridDirty)
+	{
+		m_staticGrid.Update(m_staticProxies);
+		m_isStaticGridDirty = false;
+	}
+
+	m_proxyIndices.clear();
+	m_staticGrid.QueryRegion(a_viewport, m_proxyIndices);
+	for (const unsigned int proxyIndex : m_proxyIndices)
+	{
+		an_entities.push_back(m_staticProxies[proxyIndex].entity);
+	}
+
+	m_proxyIndices.clear();
+	m_dynamicTree.QueryRegion(a_viewport, m_proxyIndices);
+	for (const unsigned int proxyIndex : m_proxyIndices)
+	{
+		an_entities.push_back(m_dynamicEntities[proxyIndex]);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "PCH.h"
+#include "Collision\AABB.h"
+#include "Collision\DynamicAABBTree.h"
+#include "Collision\UniformGridBroadphase.h"
+#include "Macros.h"
+
+// Finds the entities whose render bounds overlap the viewport, at a cost that follows what is on screen rather than the
+// size of the world. Static entities, such as tiles and scenery, sit in a grid that is only rebuilt when they change.
+// Dynamic entities are handed over every frame, and kept in a tree that only restructures around the ones that moved
+// out of their fat bounds.
+class ViewportCuller final
+{
+public:
+	NO_COPY(ViewportCuller);
+	NO_MOVE(ViewportCuller);
+
+	ViewportCuller(float a_worldWidth, float a_worldHeight, float a_staticCellSize = 256.0f, float a_dynamicFatMargin = 32.0f);
+	~ViewportCuller() = default;
+
+	// Static entities keep their bounds until removed. The grid is rebuilt on the next query after any change.
+	void AddStaticEntity(Entity an_entity, const AABB& a_bounds);
+	void RemoveStaticEntity(Entity an_entity);
+
+	// Replace the dynamic entities with the given ones, at their bounds this frame.
+	void UpdateDynamicEntities(const std::vector<BroadphaseProxy>& a_proxies);
+
+	// Append the static and dynamic entities overlapping the viewport.
+	void QueryVisibleEntities(const AABB& a_viewport, std::vector<Entity>& an_entities);
+
+	size_t GetStaticEntityCount() const { return m_staticProxies.size(); }
+	size_t GetDynamicEntityCount() const { return m_dynamicEntities.size(); }
+
+private:
+	static constexpr unsigned int NO_PROXY = ~0u;
+
+	UniformGridBroadphase m_staticGrid;				// Static entities, bucketed by cell.
+	std::vector<BroadphaseProxy> m_staticProxies;	// Bounds of every static entity.
+	std::vector<unsigned int> m_staticProxyIndices;	// Proxy of every static entity, indexed by entity.
+	bool m_isStaticGridDirty = false;				// Static entities changed since the grid was last built.
+
+	DynamicAABBTree m_dynamicTree;					// Dynamic entities at their bounds this frame.
+	std::vector<Entity> m_dynamicEntities;			// Entity of each dynamic proxy, indexed like the proxy list.
+
+	std::vector<unsigned int> m_proxyIndices;		// Proxies found by the last query, kept to reuse their memory.
+};
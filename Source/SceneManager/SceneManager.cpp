@@ -46,6 +46,9 @@ void SceneManager::Render()
 
 void SceneManager::Shutdown()
 {
+	// Destroy the systems and everything they hold.
+	m_textureRenderSystem = nullptr;
+	m_registry.Shutdown();
 }
 
 void SceneManager::InitializeRequiredManagers()
@@ -60,9 +63,18 @@ void SceneManager::CreateRequiredSystems()
 	m_registry.AddSystem<EntityMovementSystem>();
 	m_registry.AddSystem<BoundsCheckingSystem>();
 	m_registry.AddSystem<CameraFollowSystem>();
-	m_registry.AddSystem<CollisionSystem>();
+	CollisionSystem& collisionSystem = m_registry.AddSystem<CollisionSystem>();
+	collisionSystem.SetBroadphaseType(BroadphaseType::UniformGridType);
 	m_registry.AddSystem<SpriteUpdateSystem>();
-	m_registry.AddSystem<TextureRenderSystem>();
+	m_textureRenderSystem = &m_registry.AddSystem<TextureRenderSystem>();
+
+	// Only let the layers we handle collisions for interact, so the other pairs are dropped before any test.
+	CollisionLayerMatrix& collisionLayerMatrix = collisionSystem.GetLayerMatrixWrite();
+	collisionLayerMatrix.ClearLayer(CollisionLayer::PlayerLayer);
+	collisionLayerMatrix.ClearLayer(CollisionLayer::NPCLayer);
+	collisionLayerMatrix.ClearLayer(CollisionLayer::ProjectileLayer);
+	collisionLayerMatrix.SetLayersInteract(CollisionLayer::PlayerLayer, CollisionLayer::NPCLayer, true);
+	collisionLayerMatrix.SetLayersInteract(CollisionLayer::ProjectileLayer, CollisionLayer::NPCLayer, true);
 }
 
 void SceneManager::LoadRequiredAssets()
@@ -94,7 +106,7 @@ void SceneManager::CreateRequiredEntities()
 		m_registry.AddComponent<PlayerControllerComponent>(player, { 100.0f });
 		m_registry.AddComponent<TextureComponent>(player, { chopperSpritesheet, RenderOrder::PlayerOrder });
 		m_registry.AddComponent<WeaponComponent>(player, { 1000, 0, 5, ProjectileOwner::PlayerOwner, false });
-		m_registry.AddComponent<CollisionComponent>(player, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(player, { 32.0f, 32.0f, CollisionLayer::PlayerLayer });
 		m_registry.AddComponent<HealthComponent>(player, { 5, 5 });
 		m_registry.AddTag<PlayerTag>(player);
 	}
@@ -120,7 +132,7 @@ void SceneManager::CreateRequiredEntities()
 	{
 		m_registry.AddComponent<TransformComponent>(truck, { 660.0f, 420.0f, 0.0f, 1.0f, 1.0f });
 		m_registry.AddComponent<TextureComponent>(truck, { truckTexture, RenderOrder::NPCOrder });
-		m_registry.AddComponent<CollisionComponent>(truck, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(truck, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(truck, { 5, 5 });
 		m_registry.AddTag<NPCTag>(truck);
 	}
@@ -132,7 +144,7 @@ void SceneManager::CreateRequiredEntities()
 		m_registry.AddComponent<VelocityComponent>(airplane1, { 100.0f, 0.0f });
 		m_registry.AddComponent<TextureComponent>(airplane1, { airplaneSpritesheet , RenderOrder::NPCOrder });
 		m_registry.AddComponent<AnimationComponent>(airplane1, { 125, 0, 32, 32, 1, 3, 0, 0 });
-		m_registry.AddComponent<CollisionComponent>(airplane1, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(airplane1, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(airplane1, { 5, 5 });
 		m_registry.AddTag<NPCTag>(airplane1);
 	}
@@ -143,7 +155,7 @@ void SceneManager::CreateRequiredEntities()
 		m_registry.AddComponent<TransformComponent>(airplane2, { 440.0f, 380.0f, 0.0f, 1.0f, 1.0f });
 		m_registry.AddComponent<TextureComponent>(airplane2, { airplaneSpritesheet , RenderOrder::NPCOrder });
 		m_registry.AddComponent<AnimationComponent>(airplane2, { 125, 0, 32, 32, 1, 3, 0, 0 });
-		m_registry.AddComponent<CollisionComponent>(airplane2, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(airplane2, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(airplane2, { 5, 5 });
 		m_registry.AddTag<NPCTag>(airplane2);
 	}
@@ -154,7 +166,7 @@ void SceneManager::CreateRequiredEntities()
 		m_registry.AddComponent<TransformComponent>(airplane3, { 440.0f, 420.0f, 0.0f, 1.0f, 1.0f });
 		m_registry.AddComponent<TextureComponent>(airplane3, { airplaneSpritesheet , RenderOrder::NPCOrder });
 		m_registry.AddComponent<AnimationComponent>(airplane3, { 125, 0, 32, 32, 1, 3, 0, 0 });
-		m_registry.AddComponent<CollisionComponent>(airplane3, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(airplane3, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(airplane3, { 5, 5 });
 		m_registry.AddTag<NPCTag>(airplane3);
 	}
@@ -165,7 +177,7 @@ void SceneManager::CreateRequiredEntities()
 		m_registry.AddComponent<TransformComponent>(airplane4, { 490.0f, 420.0f, 0.0f, 1.0f, 1.0f });
 		m_registry.AddComponent<TextureComponent>(airplane4, { airplaneSpritesheet , RenderOrder::NPCOrder });
 		m_registry.AddComponent<AnimationComponent>(airplane4, { 125, 0, 32, 32, 1, 3, 0, 0 });
-		m_registry.AddComponent<CollisionComponent>(airplane4, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(airplane4, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(airplane4, { 5, 5 });
 		m_registry.AddTag<NPCTag>(airplane4);
 	}
@@ -176,7 +188,7 @@ void SceneManager::CreateRequiredEntities()
 		m_registry.AddComponent<TransformComponent>(airplane5, { 490.0f, 380.0f, 0.0f, 1.0f, 1.0f });
 		m_registry.AddComponent<TextureComponent>(airplane5, { airplaneSpritesheet , RenderOrder::NPCOrder });
 		m_registry.AddComponent<AnimationComponent>(airplane5, { 125, 0, 32, 32, 1, 3, 0, 0 });
-		m_registry.AddComponent<CollisionComponent>(airplane5, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(airplane5, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(airplane5, { 5, 5 });
 		m_registry.AddTag<NPCTag>(airplane5);
 	}
@@ -186,7 +198,7 @@ void SceneManager::CreateRequiredEntities()
 	{
 		m_registry.AddComponent<TransformComponent>(tank, { 500.0f, 530.0f, 0.0f, 1.0f, 1.0f });
 		m_registry.AddComponent<TextureComponent>(tank, { tankTexture, RenderOrder::NPCOrder });
-		m_registry.AddComponent<CollisionComponent>(tank, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(tank, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(tank, { 5, 5 });
 		m_registry.AddTag<NPCTag>(tank);
 	}
@@ -222,7 +234,7 @@ void SceneManager::CreateRequiredEntities()
 		m_registry.AddComponent<VelocityComponent>(jet, { 100 * (float)cos(259.0 * (float)M_PI / 180), 100 * (float)sin(259.0 * (float)M_PI / 180) });
 		m_registry.AddComponent<TextureComponent>(jet, { jetSpritesheet, RenderOrder::NPCOrder });
 		m_registry.AddComponent<AnimationComponent>(jet, { 125, 0, 32, 32, 1, 2, 0, 0 });
-		m_registry.AddComponent<CollisionComponent>(jet, { 32.0f, 32.0f });
+		m_registry.AddComponent<CollisionComponent>(jet, { 32.0f, 32.0f, CollisionLayer::NPCLayer });
 		m_registry.AddComponent<HealthComponent>(jet, { 5, 5 });
 		m_registry.AddTag<NPCTag>(jet);
 	}
@@ -2,6 +2,8 @@
 #include "ECS\Registry.h"
 #include "Macros.h"
 
+class TextureRenderSystem;
+
 class SceneManager final
 {
 public:
@@ -13,6 +15,9 @@ public:
 	void Render();
 	void Shutdown();
 
+	// The system drawing the scene, null before the scene is initialized and after it shuts down.
+	const TextureRenderSystem* GetTextureRenderSystemRead() const { return m_textureRenderSystem; }
+
 private:
 	void InitializeRequiredManagers();
 	void CreateRequiredSystems();
@@ -21,5 +26,6 @@ private:
 
 private:
 	Registry& m_registry;
+	TextureRenderSystem* m_textureRenderSystem = nullptr;
 };
 
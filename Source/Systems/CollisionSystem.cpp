@@ -1,6 +1,10 @@
 #include "PCH.h"
 #include "CollisionSystem.h"
+#include "Collision\DynamicAABBTree.h"
+#include "Collision\SweepAndPruneBroadphase.h"
+#include "Collision\UniformGridBroadphase.h"
 #include "Components\Components.h"
+#include "Engine.h"
 #include "Tags\Tags.h"
 #include "EventManager\EventManager.h"
 #include "Events\Events.h"
@@ -14,88 +18,216 @@ CollisionSystem::CollisionSystem(Registry& a_registry)
 
 void CollisionSystem::Initialize()
 {
+	// Create the broadphase the scene asked for. The grid is sized to cover the map, the others need no bounds.
+	std::unique_ptr<IBroadphase> broadphase;
+	switch (m_broadphaseType)
+	{
+	case BroadphaseType::UniformGridType:
+	{
+		const TileManager& tileManager = Engine::GetInstanceRead().GetTileManagerRead();
+		broadphase = std::make_unique<UniformGridBroadphase>(
+			static_cast<float>(tileManager.GetMapWidth()),
+			static_cast<float>(tileManager.GetMapHeight()),
+			m_broadphaseCellSize);
+		break;
+	}
+	case BroadphaseType::DynamicTreeType:
+		broadphase = std::make_unique<DynamicAABBTree>(m_broadphaseFatMargin);
+		break;
+	case BroadphaseType::SweepAndPruneType:
+		broadphase = std::make_unique<SweepAndPruneBroadphase>();
+		break;
+	default:
+		assert(false && "Unknown broadphase type.");
+		break;
+	}
+
+	m_collisionDetector = std::make_unique<CollisionDetector>(std::move(broadphase));
+
+	// Subscribe to collisions between the pairs of entity categories we care about. The dispatcher hands us the entities
+	// ordered by category, so entity1 always carries the first tag.
 	EventManager& eventManager = EventManager::GetInstanceWrite();
-	eventManager.SubscribeToEvent<CollisionEvent, CollisionSystem>(this, &CollisionSystem::OnCollision);
+	eventManager.SubscribeToPairEvent<CollisionEnterEvent, PlayerTag, NPCTag, CollisionSystem>(this, &CollisionSystem::OnPlayerNPCCollision);
+	eventManager.SubscribeToPairEvent<CollisionEnterEvent, ProjectileTag, NPCTag, CollisionSystem>(this, &CollisionSystem::OnProjectileNPCCollision);
 }
 
 void CollisionSystem::Update(float a_deltaTime)
 {
-	// Cache the event manager 
-	static EventManager& eventManager = EventManager::GetInstanceWrite();
+	// Find the pairs of colliders touching this frame, spread across the engine's threads. Pairs with a fast mover are
+	// swept over the frame, the others are checked for overlap at the end of the frame.
+	UpdateProxies(a_deltaTime);
+	m_collisionDetector->DetectCollisions(m_proxies, m_proxyIsSwept, &Engine::GetInstanceWrite().GetJobPoolWrite());
+	TestSweptPairs();
 
-	// Check all currently active entities for collisions against each other.
-	for (auto entityIndex1 = m_entities.cbegin(); entityIndex1 != m_entities.cend(); ++entityIndex1)
-	{
-		for (auto entityIndex2 = std::next(entityIndex1); entityIndex2 != m_entities.cend(); ++entityIndex2)
-		{
-			// If a collision occurred, emit a collision event.
-			if (CollideAABB(*entityIndex1, *entityIndex2))
-			{
-				eventManager.EmitEvent<CollisionEvent>({ *entityIndex1, *entityIndex2 }, EventPriority::Deferred);
-			}
-		}
-	}
+	// Report the contacts that started or ended.
+	EmitContactEvents();
+
+	// Move the colliders in the engine's spatial index to where they ended up this frame.
+	Engine::GetInstanceWrite().GetSpatialIndexWrite().Update(m_spatialProxies);
 }
 
 void CollisionSystem::Render()
 {
 }
 
-void CollisionSystem::OnCollision(const CollisionEvent& a_collisionEvent)
+void CollisionSystem::OnPlayerNPCCollision(const CollisionEnterEvent& a_collisionEvent)
+{
+	// Destroy both the player and the NPC.
+	m_registry.RemoveEntity(a_collisionEvent.entity1);
+	m_registry.RemoveEntity(a_collisionEvent.entity2);
+}
+
+void CollisionSystem::OnProjectileNPCCollision(const CollisionEnterEvent& a_collisionEvent)
+{
+	const Entity projectileEntity = a_collisionEvent.entity1;
+	const Entity npcEntity = a_collisionEvent.entity2;
+
+	// Get the health and projectile components, and reduce the health by the hit amount.
+	const ProjectileComponent& projectileComponent = m_registry.GetComponentRead<ProjectileComponent>(projectileEntity);
+	HealthComponent& healthComponent = m_registry.GetComponentWrite<HealthComponent>(npcEntity);
+	healthComponent.currentHealthPoints -= projectileComponent.damage;
+
+	// Destroy the projectile.
+	m_registry.RemoveEntity(projectileEntity);
+
+	// If the health of the hit entity is less than or equal zero, destroy the entity as well.
+	if (healthComponent.currentHealthPoints <= 0)
+		m_registry.RemoveEntity(npcEntity);
+}
+
+void CollisionSystem::OnEntityRemoved(Entity an_entity)
+{
+	// Its contacts are dropped on the next update, before its id can come back with a new collider.
+	m_removedEntities.push_back(an_entity);
+}
+
+void CollisionSystem::UpdateProxies(float a_deltaTime)
 {
-	const Entity entity1 = a_collisionEvent.entity1;
-	const Entity entity2 = a_collisionEvent.entity2;
+	m_proxies.clear();
+	m_spatialProxies.clear();
+	m_proxyMotions.clear();
+	m_proxyIsSwept.clear();
 
-	// Handle Player and NPC collisions.
-	if (HaveTags<PlayerTag, NPCTag>(entity1, entity2))
+	// Compute the world space bounds and collision filter of every collider.
+	for (const Entity entity : m_entities)
 	{
-		m_registry.RemoveEntity(entity1);
-		m_registry.RemoveEntity(entity2);
+		const TransformComponent& transformComponent = m_registry.GetComponentRead<TransformComponent>(entity);
+		const CollisionComponent& collisionComponent = m_registry.GetComponentRead<CollisionComponent>(entity);
+
+		const AABB bounds = {
+			transformComponent.x,
+			transformComponent.y,
+			transformComponent.x + collisionComponent.colliderWidth * transformComponent.xScale,
+			transformComponent.y + collisionComponent.colliderHeight * transformComponent.yScale
+		};
+
+		// Narrow the layers the collider asks for down to the ones its layer interacts with.
+		const CollisionFilter filter = {
+			GetCollisionLayerBit(collisionComponent.layer),
+			static_cast<CollisionLayerMask>(collisionComponent.layerMask & m_layerMatrix.GetLayerMask(collisionComponent.layer))
+		};
+
+		// Fast movers cover the whole path they moved along this frame, so the broadphase pairs them with everything they
+		// may have passed through.
+		ProxyMotion motion = { bounds };
+		bool isSwept = false;
+		if (collisionComponent.continuousCollision && m_registry.HaveComponent<VelocityComponent>(entity))
+		{
+			const VelocityComponent& velocityComponent = m_registry.GetComponentRead<VelocityComponent>(entity);
+			motion.displacementX = velocityComponent.x * a_deltaTime;
+			motion.displacementY = velocityComponent.y * a_deltaTime;
+			motion.startBounds = { bounds.minX - motion.displacementX, bounds.minY - motion.displacementY, bounds.maxX - motion.displacementX, bounds.maxY - motion.displacementY };
+			isSwept = true;
+		}
+
+		m_proxies.push_back({ AABBUnion(motion.startBounds, bounds), entity, filter });
+		m_spatialProxies.push_back({ bounds, entity, filter });
+		m_proxyMotions.push_back(motion);
+		m_proxyIsSwept.push_back(isSwept ? 1 : 0);
 	}
+}
 
-	// Handle Player and NPC collisions.
-	else if (HaveTags<ProjectileTag, NPCTag>(entity1, entity2))
+void CollisionSystem::TestSweptPairs()
+{
+	m_sweptContacts.clear();
+	for (const BroadphasePair& sweptPair : m_collisionDetector->GetSweptPairsRead())
 	{
-		// Figure out which entity is which.
-		const Entity projectileEntity = m_registry.HaveTag<ProjectileTag>(entity1) ? entity1 : entity2;
-		const Entity npcEntity = m_registry.HaveTag<NPCTag>(entity1) ? entity1 : entity2;
-
-		// Get the health and projectile components, and reduce the health by the hit amount.
-		const ProjectileComponent& projectileComponent = m_registry.GetComponentRead<ProjectileComponent>(projectileEntity);
-		HealthComponent& healthComponent = m_registry.GetComponentWrite<HealthComponent>(npcEntity);
-		healthComponent.currentHealthPoints -= projectileComponent.damage;
+		const ProxyMotion& motion1 = m_proxyMotions[sweptPair.proxyIndex1];
+		const ProxyMotion& motion2 = m_proxyMotions[sweptPair.proxyIndex2];
 
-		// Destroy the projectile.
-		m_registry.RemoveEntity(projectileEntity);
+		// Sweep the first collider from where it started the frame, relative to the second one.
+		float timeOfImpact = 0.0f;
+		const bool interact = CollisionFiltersInteract(m_proxies[sweptPair.proxyIndex1].filter, m_proxies[sweptPair.proxyIndex2].filter);
+		if (interact && SweepAABB(motion1.startBounds, motion1.displacementX - motion2.displacementX, motion1.displacementY - motion2.displacementY, motion2.startBounds, timeOfImpact))
+		{
+			m_sweptContacts.push_back({ sweptPair, timeOfImpact });
+		}
+	}
 
-		// If the health of the hit entity is less than or equal zero, destroy the entity as well.
-		if (healthComponent.currentHealthPoints <= 0)
-			m_registry.RemoveEntity(npcEntity);
+	// Order the contacts by time of impact, ties broken by the pair so the order is deterministic.
+	std::sort(m_sweptContacts.begin(), m_sweptContacts.end(), [](const SweptContact& a_contact1, const SweptContact& a_contact2)
+	{
+		if (a_contact1.timeOfImpact != a_contact2.timeOfImpact)
+			return a_contact1.timeOfImpact < a_contact2.timeOfImpact;
+		if (a_contact1.pair.proxyIndex1 != a_contact2.pair.proxyIndex1)
+			return a_contact1.pair.proxyIndex1 < a_contact2.pair.proxyIndex1;
+		return a_contact1.pair.proxyIndex2 < a_contact2.pair.proxyIndex2;
+	});
+
+	// A fast mover only reports its earliest contact, anything further along its path was never reached. A contact is
+	// kept only if neither of its fast movers has been given an earlier one.
+	m_proxyHasContact.assign(m_proxies.size(), 0);
+	size_t contactCount = 0;
+	for (const SweptContact& sweptContact : m_sweptContacts)
+	{
+		const unsigned int proxyIndex1 = sweptContact.pair.proxyIndex1;
+		const unsigned int proxyIndex2 = sweptContact.pair.proxyIndex2;
+		if (m_proxyHasContact[proxyIndex1] || m_proxyHasContact[proxyIndex2])
+			continue;
+
+		m_proxyHasContact[proxyIndex1] = m_proxyIsSwept[proxyIndex1];
+		m_proxyHasContact[proxyIndex2] = m_proxyIsSwept[proxyIndex2];
+		m_sweptContacts[contactCount++] = sweptContact;
 	}
+
+	m_sweptContacts.resize(contactCount);
 }
 
-bool CollisionSystem::CollideAABB(const Entity entity1, const Entity entity2) const
+void CollisionSystem::EmitContactEvents()
 {
-	const TransformComponent& transformComponent1 = m_registry.GetComponentRead<TransformComponent>(entity1);
-	const CollisionComponent& collisionComponent1 = m_registry.GetComponentRead<CollisionComponent>(entity1);
-
-	const TransformComponent& transformComponent2 = m_registry.GetComponentRead<TransformComponent>(entity2);
-	const CollisionComponent& collisionComponent2 = m_registry.GetComponentRead<CollisionComponent>(entity2);
-
-	const SDL_Rect entity1Box = {
-		static_cast<int>(round(transformComponent1.x)),
-		static_cast<int>(round(transformComponent1.y)),
-		static_cast<int>(round(collisionComponent1.colliderWidth * transformComponent1.xScale)),
-		static_cast<int>(round(collisionComponent1.colliderWidth * transformComponent1.yScale))
-	};
-
-	const SDL_Rect entity2Box = {
-		static_cast<int>(round(transformComponent2.x)),
-		static_cast<int>(round(transformComponent2.y)),
-		static_cast<int>(round(collisionComponent2.colliderWidth * transformComponent2.xScale)),
-		static_cast<int>(round(collisionComponent2.colliderWidth * transformComponent2.yScale))
-	};
-
-	return SDL_HasIntersection(&entity1Box, &entity2Box) == SDL_TRUE;
-}
+	// Cache the event manager 
+	static EventManager& eventManager = EventManager::GetInstanceWrite();
+
+	// End the contacts of the removed colliders first, as their entities may already be in use again.
+	m_endedContacts.clear();
+	m_contactCache.RemoveEntityContacts(m_removedEntities, m_endedContacts);
+	m_removedEntities.clear();
+
+	// Only contacts that just started are reported as collisions, ongoing ones only if asked for.
+	for (const BroadphasePair& collidingPair : m_collisionDetector->GetCollidingPairsRead())
+	{
+		const Entity entity1 = m_proxies[collidingPair.proxyIndex1].entity;
+		const Entity entity2 = m_proxies[collidingPair.proxyIndex2].entity;
+		if (m_contactCache.TouchContact(entity1, entity2))
+			eventManager.EmitEvent<CollisionEnterEvent>({ entity1, entity2, 1.0f }, EventPriority::Deferred);
+		else if (m_emitStayEvents)
+			eventManager.EmitEvent<CollisionStayEvent>({ entity1, entity2 }, EventPriority::Deferred);
+	}
 
+	for (const SweptContact& sweptContact : m_sweptContacts)
+	{
+		const Entity entity1 = m_proxies[sweptContact.pair.proxyIndex1].entity;
+		const Entity entity2 = m_proxies[sweptContact.pair.proxyIndex2].entity;
+		if (m_contactCache.TouchContact(entity1, entity2))
+			eventManager.EmitEvent<CollisionEnterEvent>({ entity1, entity2, sweptContact.timeOfImpact }, EventPriority::Deferred);
+		else if (m_emitStayEvents)
+			eventManager.EmitEvent<CollisionStayEvent>({ entity1, entity2 }, EventPriority::Deferred);
+	}
+
+	// Contacts that weren't touched this frame have ended.
+	m_contactCache.EndFrame(m_endedContacts);
+	for (const ContactCache::ContactPair& endedContact : m_endedContacts)
+	{
+		eventManager.EmitEvent<CollisionExitEvent>({ endedContact.entity1, endedContact.entity2 }, EventPriority::Deferred);
+	}
+}
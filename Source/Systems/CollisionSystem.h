@@ -1,6 +1,11 @@
 #pragma once
+#include "Collision\AABB.h"
+#include "Collision\CollisionDetector.h"
+#include "Collision\CollisionLayers.h"
+#include "Collision\ContactCache.h"
 #include "ECS\System.h"
 #include "ECS\Registry.h"
+#include "Enums\Enums.h"
 #include "Events\Events.h"
 
 class CollisionSystem final : public ISystem
@@ -14,18 +19,58 @@ public:
 	void Update(float a_deltaTime) override;
 	void Render() override;
 
-	void OnCollision(const CollisionEvent& a_collisionEvent);
+	void OnPlayerNPCCollision(const CollisionEnterEvent& a_collisionEvent);
+	void OnProjectileNPCCollision(const CollisionEnterEvent& a_collisionEvent);
+
+	// Broadphase settings only take effect when set before the system is initialized.
+	void SetBroadphaseType(BroadphaseType a_broadphaseType) { m_broadphaseType = a_broadphaseType; }
+	void SetBroadphaseCellSize(float a_cellSize) { m_broadphaseCellSize = a_cellSize; }
+	void SetBroadphaseFatMargin(float a_fatMargin) { m_broadphaseFatMargin = a_fatMargin; }
+
+	// Ongoing contacts are only reported through stay events when asked for, enter and exit events are always emitted.
+	void SetEmitStayEvents(bool an_emitStayEvents) { m_emitStayEvents = an_emitStayEvents; }
+
+	const CollisionLayerMatrix& GetLayerMatrixRead() const { return m_layerMatrix; }
+	CollisionLayerMatrix& GetLayerMatrixWrite() { return m_layerMatrix; }
+
+protected:
+	void OnEntityRemoved(Entity an_entity) override;
 
 private:
-	bool CollideAABB(const Entity entity1, const Entity entity2) const;
-	template<typename TTag1, typename TTag2> bool HaveTags(const Entity entity1, const Entity entity2);
-};
+	// Where a collider started the frame, and how far it moved since.
+	struct ProxyMotion final
+	{
+		AABB startBounds;				// 16 bytes.
+		float displacementX = 0.0f;		// 4 bytes.
+		float displacementY = 0.0f;		// 4 bytes.
+	};									// Total = 24 bytes.
 
-template<typename TTag1, typename TTag2>
-inline bool CollisionSystem::HaveTags(const Entity entity1, const Entity entity2)
-{
-	// Check if the pair of entities - among themselves - contain the specified pair of tags.
-	return (m_registry.HaveTag<TTag1>(entity1) && m_registry.HaveTag<TTag2>(entity2))
-		|| (m_registry.HaveTag<TTag1>(entity2) && m_registry.HaveTag<TTag2>(entity1));
-}
+	// A pair of colliders found touching by the swept test.
+	struct SweptContact final
+	{
+		BroadphasePair pair;			// 8 bytes.
+		float timeOfImpact = 0.0f;		// 4 bytes.
+	};									// Total = 12 bytes.
+
+	void UpdateProxies(float a_deltaTime);
+	void TestSweptPairs();
+	void EmitContactEvents();
+
+private:
+	CollisionLayerMatrix m_layerMatrix;					// Which collision layers interact.
+	std::unique_ptr<CollisionDetector> m_collisionDetector;	// Broadphase and narrowphase, run across the engine's job pool.
+	std::vector<BroadphaseProxy> m_proxies;				// Bounds of every collider this frame, sorted by entity.
+	std::vector<BroadphaseProxy> m_spatialProxies;		// Like the proxies, but fast movers only cover where they ended up.
+	std::vector<ProxyMotion> m_proxyMotions;			// Motion of every collider this frame, indexed like the proxies.
+	std::vector<unsigned char> m_proxyIsSwept;			// Fast movers needing the swept test, indexed like the proxies.
+	std::vector<SweptContact> m_sweptContacts;			// Swept pairs touching this frame, earliest first.
+	std::vector<unsigned char> m_proxyHasContact;		// Fast movers already given their earliest contact, indexed like the proxies.
+	ContactCache m_contactCache;						// Pairs of entities touching, kept across frames.
+	std::vector<ContactCache::ContactPair> m_endedContacts;	// Contacts that ended this frame.
+	std::vector<Entity> m_removedEntities;				// Colliders removed since the last update.
+	bool m_emitStayEvents = false;
+	BroadphaseType m_broadphaseType = BroadphaseType::UniformGridType;
+	float m_broadphaseCellSize = 64.0f;					// Edge length of a broadphase grid cell.
+	float m_broadphaseFatMargin = 8.0f;					// Margin the dynamic tree fattens collider bounds by.
+};
 
@@ -18,7 +18,7 @@ void PlayerControllerSystem::Initialize()
 {
 	// Get the projectile texture Id.
 	const TextureManager& textureManager = TextureManager::GetInstanceRead();
-	const size_t textureId = textureManager.GetTextureId("./Assets/Images/Projectile.png");
+	const TextureId textureId = textureManager.GetTextureId("./Assets/Images/Projectile.png");
 
 	// Retrieve player and animation components to calculate projectile offsets.
 	assert(m_registry.GetEntitiesWithTag<PlayerTag>().size() == 1);
@@ -80,13 +80,15 @@ void PlayerControllerSystem::Update(float a_deltaTime)
 	}
 
 	// Emit a projectile if requested by the player, enough time has past since the previous emission, and the player has started moving.
-	const unsigned int currenTime = SDL_GetTicks();
+	// The time is counted in simulated steps, and stops at the cadence so time spent not firing doesn't bank shots.
+	const float emissionCadence = static_cast<float>(weaponComponent.emissionCadence);
+	weaponComponent.elapsedTime = std::min(weaponComponent.elapsedTime + a_deltaTime * 1000.0f, emissionCadence);
 	if (m_keyboardState[SDL_SCANCODE_SPACE] 
-		&& (currenTime >= weaponComponent.lastEmissionTime + weaponComponent.emissionCadence)
+		&& (weaponComponent.elapsedTime >= emissionCadence)
 		&& (velocityComponent.x != 0 || velocityComponent.y != 0))
 	{
 		EmitProjectile(transformComponent, spriteComponent, velocityComponent);
-		weaponComponent.lastEmissionTime = currenTime;
+		weaponComponent.elapsedTime = 0.0f;
 	}
 
 	// Calculate the sprite row index.
@@ -132,7 +134,7 @@ void PlayerControllerSystem::EmitProjectile(const TransformComponent& a_playerTr
 		m_registry.AddComponent<VelocityComponent>(projectile, { xVelocity * PROJECTILE_SPEED, yVelocity * PROJECTILE_SPEED });
 		m_registry.AddComponent<TextureComponent>(projectile, { m_projectileTextureId, RenderOrder::ProjectileOrder });
 		m_registry.AddComponent<ProjectileComponent>(projectile, { 1, ProjectileOwner::PlayerOwner });
-		m_registry.AddComponent<CollisionComponent>(projectile, { 4, 4 });
+		m_registry.AddComponent<CollisionComponent>(projectile, { 4, 4, CollisionLayer::ProjectileLayer, true });
  		m_registry.AddTag<ProjectileTag>(projectile);
 	}
 }
@@ -18,7 +18,7 @@ private:
 
 private:
 	const Uint8* m_keyboardState = SDL_GetKeyboardState(nullptr);
-	size_t m_projectileTextureId = 0;
+	TextureId m_projectileTextureId = INVALID_TEXTURE_ID;
 
 	float m_halfProjectileWidth = 0.0f;
 	float m_halfProjectileHeight = 0.0f;
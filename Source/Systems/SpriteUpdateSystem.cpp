@@ -26,15 +26,15 @@ void SpriteUpdateSystem::Update(float a_deltaTime)
 		// Retrieve any required components to update the current entity belonging to this system.
 		AnimationComponent& spriteComponent = m_registry.GetComponentWrite<AnimationComponent>(entity);
 
-		// Calculate the sprite column index.
-		const size_t currentTimeInMs = spriteComponent.lastUpdateTime + spriteComponent.updateTime;
-		if (SDL_GetTicks() > currentTimeInMs)
+		// Calculate the sprite column index from the simulated time, so animations play the same at any frame rate.
+		spriteComponent.elapsedTime += a_deltaTime * 1000.0f;
+		if (spriteComponent.elapsedTime > static_cast<float>(spriteComponent.updateTime))
 		{
 			// Toggle to the next column on the sprite sheet in a circular manner.
 			spriteComponent.currentColumn = (spriteComponent.currentColumn + 1) % spriteComponent.columnCount;
 
-			// Update the time required to pass before the next toggle.
-			spriteComponent.lastUpdateTime = SDL_GetTicks();
+			// Start timing the next toggle, keeping the time past this one.
+			spriteComponent.elapsedTime -= static_cast<float>(spriteComponent.updateTime);
 		}
 	}
 }
@@ -17,234 +17,475 @@ void TextureRenderSystem::Initialize()
 	assert(m_registry.GetEntitiesWithTag<CameraTag>().size() == 1);
 	m_cameraEntity = m_registry.GetEntitiesWithTag<CameraTag>()[0];
 
+	// Cover the map with the culler's static grid.
+	const TileManager& tileManager = Engine::GetInstanceRead().GetTileManagerRead();
+	m_viewportCuller = std::make_unique<ViewportCuller>(static_cast<float>(tileManager.GetMapWidth()), static_cast<float>(tileManager.GetMapHeight()));
+
+	// Only count the draws when rendering to the null backend.
+	m_spriteBatcher.SetSubmitEnabled(Engine::GetInstanceRead().GetRenderBackend() != RenderBackend::NullBackend);
+
+	// Bake the tile layers into chunks if the renderer can draw into textures, else they are culled like scenery.
+	if (SDL_RenderTargetSupported(Engine::GetInstanceRead().GetEngineRenderer()))
+		m_tileLayerCache = std::make_unique<TileLayerCache>(tileManager.GetMapWidth(), tileManager.GetMapHeight());
+
 	// Subscribe to key up events to toggle render debug mode.
 	EventManager& eventManager = EventManager::GetInstanceWrite();
 	eventManager.SubscribeToEvent<KeyUpEvent, TextureRenderSystem>(this, &TextureRenderSystem::OnKeyUp);
+
+	// Subscribe to the events making baked chunks stale.
+	eventManager.SubscribeToEvent<RenderTargetsResetEvent, TextureRenderSystem>(this, &TextureRenderSystem::OnRenderTargetsReset);
+	eventManager.SubscribeToEvent<StaticEntityChangedEvent, TextureRenderSystem>(this, &TextureRenderSystem::OnStaticEntityChanged);
 }
 
 void TextureRenderSystem::Update(float a_deltaTime)
 {
+	// Updating runs last in every simulation step, once everything has moved. Record where the camera and the entities
+	// that may move ended up, so the frames rendered until the next step can be drawn between the last two steps.
+	++m_stepStamp;
+	RecordPosition(m_cameraEntity);
+	for (const Entity entity : m_dynamicEntities)
+	{
+		RecordPosition(entity);
+	}
+	for (const Entity entity : m_alwaysVisibleEntities)
+	{
+		RecordPosition(entity);
+	}
 }
 
 void TextureRenderSystem::Render()
 {
 	static SDL_Renderer* renderer = Engine::GetInstanceRead().GetEngineRenderer();
+	static RenderThread& renderThread = Engine::GetInstanceWrite().GetRenderThreadWrite();
 	static const TextureManager& textureManager = TextureManager::GetInstanceRead();
 
-	// Retrieve relevant camera components to perform the culling.
-	const TransformComponent& cameraTransform = m_registry.GetComponentRead<TransformComponent>(m_cameraEntity);
+	// Everything is recorded for the render thread, which may still be drawing the last frame.
+	RenderCommandBuffer& commandBuffer = renderThread.GetRecordingBufferWrite();
+
+	// Retrieve relevant camera components to perform the culling, with the camera where it is drawn from this frame.
 	const CameraComponent& cameraComponent = m_registry.GetComponentRead<CameraComponent>(m_cameraEntity);
+	m_cameraOrigin = GetRenderPosition(m_cameraEntity);
+
+	// Bring the culler up to date with the entities added since the last frame, and where the dynamic ones are now.
+	ClassifyPendingEntities();
+	UpdateDynamicEntities();
+
+	// Gather the entities overlapping the viewport, and sort them according to their texture render order before
+	// rendering. Moving entities are culled where they are, at most a step away from where they are drawn.
+	const AABB viewport = {
+		m_cameraOrigin.x,
+		m_cameraOrigin.y,
+		m_cameraOrigin.x + cameraComponent.cameraWidth,
+		m_cameraOrigin.y + cameraComponent.cameraHeight
+	};
 
-	// Lambda to cull all textures and sprites that are outside of the visible window area. 
-	const auto filter =
-	[
-		&a_registry = static_cast<const Registry&>(m_registry),
-		&a_cameraTransform = static_cast<const TransformComponent&>(cameraTransform),
-		&a_cameraComponent = static_cast<const CameraComponent&>(cameraComponent)
-	]
-	(const Entity entity) -> bool
-	{
-		// The current camera viewport bounds.		
-		const int cameraEndX = static_cast<int>(round(a_cameraTransform.x + a_cameraComponent.cameraWidth));
-		const int cameraEndY = static_cast<int>(round(a_cameraTransform.y + a_cameraComponent.cameraHeight));
+	m_visibleEntities.clear();
+	m_viewportCuller->QueryVisibleEntities(viewport, m_visibleEntities);
+	m_visibleEntities.insert(m_visibleEntities.end(), m_alwaysVisibleEntities.begin(), m_alwaysVisibleEntities.end());
 
-		bool shouldKeepEntity = false;
+	m_renderQueue.Clear();
+	for (const Entity entity : m_visibleEntities)
+	{
+		m_renderQueue.Push(GetSortKey(entity), entity);
+	}
+	m_renderQueue.Sort();
 
-		// Retrieve the transform of the entity being considered for rendering.
-		const TransformComponent& transformComponent = a_registry.GetComponentRead<TransformComponent>(entity);
+	// Count everything drawn this frame, the chunks baked below included.
+	m_spriteBatcher.ResetStatistics();
 
-		// Handle tile entity culling.
-		if (a_registry.HaveComponent<TileComponent>(entity))
+	// Redraw the chunks of the tile layers that changed or lost their texture since they were last in view. This
+	// switches render targets, so it must happen before anything is queued for the screen. Baking may create and release
+	// chunk textures, which the last frame may still be drawing from, so let the render thread finish it first.
+	const SDL_FPoint cameraOrigin = m_cameraOrigin;
+	m_visibleChunks.clear();
+	if (m_tileLayerCache)
+	{
+		m_tileLayerCache->QueryVisibleChunks(viewport, m_visibleChunks);
+		bool isRendererIdle = false;
+		for (const unsigned int chunkIndex : m_visibleChunks)
 		{
-			// Retrieve the tile component to perform bounds checking calculations.
-			const TileComponent& tileComponent = a_registry.GetComponentRead<TileComponent>(entity);
-			
-			// Check if the tile texture overlaps with the viewport x bounds.
-			const bool xBounds = (transformComponent.x + tileComponent.tileWidth * transformComponent.xScale >= a_cameraTransform.x) &&
-				(transformComponent.x < cameraEndX);
-
-			// Check if the tile texture overlaps with the viewport y bounds.
-			const bool yBounds = (transformComponent.y + tileComponent.tileHeight * transformComponent.yScale >= a_cameraTransform.y) &&
-				(transformComponent.y < cameraEndY);
-
-			// Keep the tile texture for rendering if it overlaps with the viewport in the x and y axis.
-			shouldKeepEntity = xBounds && yBounds;
+			if (m_tileLayerCache->IsChunkBaked(chunkIndex))
+				continue;
+
+			if (!isRendererIdle)
+			{
+				renderThread.WaitForIdle();
+				isRendererIdle = true;
+			}
+			BakeChunk(chunkIndex, renderer, commandBuffer, textureManager);
 		}
+	}
 
-		// Handle non-tile-like textures.
-		else if (a_registry.HaveTag<ProjectileTag>(entity)
-			|| a_registry.HaveTag<NPCTag>(entity)
-			|| a_registry.HaveTag<SceneryTag>(entity))
+	// The baked chunks hold the bottom render orders, so they go first.
+	m_spriteBatcher.Begin(commandBuffer);
+	for (const unsigned int chunkIndex : m_visibleChunks)
+	{
+		SDL_Texture* chunkTexture = m_tileLayerCache->GetChunkTexture(chunkIndex);
+		if (!chunkTexture)
+			continue;
+
+		const SDL_Rect chunkRect = m_tileLayerCache->GetChunkRect(chunkIndex);
+		const SDL_FRect destinationRect = {
+			roundf(chunkRect.x - cameraOrigin.x),
+			roundf(chunkRect.y - cameraOrigin.y),
+			static_cast<float>(chunkRect.w),
+			static_cast<float>(chunkRect.h)
+		};
+		m_spriteBatcher.DrawSprite(chunkTexture, { chunkRect.w, chunkRect.h }, { 0, 0, chunkRect.w, chunkRect.h }, destinationRect, 0.0f);
+	}
+
+	// Queue each texture and sprite into the batcher, which submits every run sharing a texture at once.
+	const std::vector<RenderQueue::RenderItem>& renderItems = m_renderQueue.GetItemsRead();
+	size_t layerStartIndex = 0;
+	for (size_t itemIndex = 0; itemIndex < renderItems.size(); ++itemIndex)
+	{
+		const Entity entity = renderItems[itemIndex].entity;
+		if (m_registry.HaveComponent<AnimationComponent>(entity))
+			RenderSprite(entity, m_registry, textureManager, cameraOrigin);
+		else if (m_registry.HaveComponent<TileComponent>(entity))
+			RenderTile(entity, m_registry, textureManager, cameraOrigin);
+		else
+			RenderTexture(entity, m_registry, textureManager, cameraOrigin);
+
+		// Once a render order is done, draw the health bars of its entities over it, as a single batch of plain quads.
+		const bool isLastOfLayer = itemIndex + 1 == renderItems.size()
+			|| RenderQueue::GetRenderOrder(renderItems[itemIndex + 1].sortKey) != RenderQueue::GetRenderOrder(renderItems[itemIndex].sortKey);
+		if (!isLastOfLayer)
+			continue;
+
+		for (size_t layerIndex = layerStartIndex; layerIndex <= itemIndex; ++layerIndex)
 		{
-			// Retrieve the texture component to query for texture parameters.
-			const TextureComponent& textureComponent = a_registry.GetComponentRead<TextureComponent>(entity);
-			
-			// Get the texture width and height to for bounds checking calculations.
-			static const TextureManager& textureManager = TextureManager::GetInstanceRead();
-			const int textureWidth = textureManager.GetTextureWidth(textureComponent.textureId);
-			const int textureHeight = textureManager.GetTextureHeight(textureComponent.textureId);
-
-			// Check if the tile texture overlaps with the viewport x bounds.
-			const bool xBounds = (transformComponent.x + textureWidth * transformComponent.xScale >= a_cameraTransform.x) &&
-				(transformComponent.x < cameraEndX);
-
-			// Check if the tile texture overlaps with the viewport y bounds.
-			const bool yBounds = (transformComponent.y + textureHeight * transformComponent.yScale >= a_cameraTransform.y) &&
-				(transformComponent.y < cameraEndY);
-
-			// Keep the tile texture for rendering if it overlaps with the viewport in the x and y axis.
-			shouldKeepEntity = xBounds && yBounds;
+			if (m_registry.HaveComponent<HealthComponent>(renderItems[layerIndex].entity))
+				RenderHealthBar(renderItems[layerIndex].entity, m_registry, textureManager);
 		}
+		layerStartIndex = itemIndex + 1;
+	}
+	m_spriteBatcher.End();
 
-		// Handle player case.
-		else if (a_registry.HaveTag<PlayerTag>(entity))
+	// If debug mode is toggled, render the AABB boxes of the relevant entities over everything.
+	if (m_debugModeEnabled)
+	{
+		for (const RenderQueue::RenderItem& renderItem : renderItems)
 		{
-			// The player should always be on the screen.
-			shouldKeepEntity = true;
+			if (m_registry.HaveComponent<CollisionComponent>(renderItem.entity))
+				RenderColliders(renderItem.entity, m_registry, commandBuffer);
 		}
+	}
+}
 
-		return shouldKeepEntity;
-	};
+void TextureRenderSystem::OnEntityAdded(Entity an_entity)
+{
+	// Tags are processed after entities, so wait for the next render to classify the entity.
+	m_pendingEntities.push_back(an_entity);
+}
+
+void TextureRenderSystem::OnEntityRemoved(Entity an_entity)
+{
+	// Forget where the entity was, so an entity recycling its id isn't drawn moving in from there.
+	if (an_entity < m_positionHistories.size())
+		m_positionHistories[an_entity].stepStamp = 0;
 
-	// Lambda to compare the render order of both entities to render the lesser render order texture first.
-	const auto sort = [&a_registry = static_cast<const Registry&>(m_registry)](const Entity entity1, const Entity entity2) -> bool
+	if (an_entity >= m_entityCullKinds.size())
+		return;
+
+	// Take the entity out of wherever it was culled from.
+	switch (m_entityCullKinds[an_entity])
+	{
+	case CullKind::StaticKind:
+		m_viewportCuller->RemoveStaticEntity(an_entity);
+		break;
+	case CullKind::BakedKind:
+		m_tileLayerCache->RemoveEntity(an_entity);
+		break;
+	case CullKind::DynamicKind:
 	{
-		const TextureComponent& textureComponent1 = a_registry.GetComponentRead<TextureComponent>(entity1);
-		const TextureComponent& textureComponent2 = a_registry.GetComponentRead<TextureComponent>(entity2);
-		return textureComponent1.renderOrder < textureComponent2.renderOrder;
+		// Swap and pop, the order of the dynamic entities doesn't matter.
+		const unsigned int entityIndex = m_dynamicEntityIndices[an_entity];
+		m_dynamicEntities[entityIndex] = m_dynamicEntities.back();
+		m_dynamicEntityIndices[m_dynamicEntities[entityIndex]] = entityIndex;
+		m_dynamicEntities.pop_back();
+		break;
+	}
+	case CullKind::AlwaysVisibleKind:
+		m_alwaysVisibleEntities.erase(std::find(m_alwaysVisibleEntities.begin(), m_alwaysVisibleEntities.end(), an_entity));
+		break;
+	default:
+		break;
+	}
+
+	m_entityCullKinds[an_entity] = CullKind::UnculledKind;
+}
+
+void TextureRenderSystem::RecordPosition(Entity an_entity)
+{
+	if (an_entity >= m_positionHistories.size())
+		m_positionHistories.resize(an_entity * 2 + 1);
+
+	// The latest position becomes the previous one, unless the entity wasn't recorded last step, in which case it is
+	// drawn standing still until the next step.
+	const TransformComponent& transformComponent = m_registry.GetComponentRead<TransformComponent>(an_entity);
+	PositionHistory& positionHistory = m_positionHistories[an_entity];
+	const bool isRecordedLastStep = positionHistory.stepStamp == m_stepStamp - 1;
+	positionHistory.previousX = isRecordedLastStep ? positionHistory.latestX : transformComponent.x;
+	positionHistory.previousY = isRecordedLastStep ? positionHistory.latestY : transformComponent.y;
+	positionHistory.latestX = transformComponent.x;
+	positionHistory.latestY = transformComponent.y;
+	positionHistory.stepStamp = m_stepStamp;
+}
+
+SDL_FPoint TextureRenderSystem::GetRenderPosition(Entity an_entity) const
+{
+	static const Engine& engine = Engine::GetInstanceRead();
+	const TransformComponent& transformComponent = m_registry.GetComponentRead<TransformComponent>(an_entity);
+	if (an_entity >= m_positionHistories.size() || m_positionHistories[an_entity].stepStamp != m_stepStamp)
+		return { transformComponent.x, transformComponent.y };
+
+	// Blend from the previous step towards where the entity is now.
+	const PositionHistory& positionHistory = m_positionHistories[an_entity];
+	const float interpolationAlpha = engine.GetInterpolationAlpha();
+	return {
+		positionHistory.previousX + (transformComponent.x - positionHistory.previousX) * interpolationAlpha,
+		positionHistory.previousY + (transformComponent.y - positionHistory.previousY) * interpolationAlpha
 	};
+}
+
+void TextureRenderSystem::ClassifyPendingEntities()
+{
+	for (const Entity entity : m_pendingEntities)
+	{
+		// Skip entities that left the system before they were ever rendered.
+		if (m_entities.find(entity) == m_entities.end())
+			continue;
+
+		if (entity >= m_entityCullKinds.size())
+		{
+			m_entityCullKinds.resize(entity * 2 + 1, CullKind::UnculledKind);
+			m_dynamicEntityIndices.resize(entity * 2 + 1, 0);
+		}
+
+		// A recycled entity may be pending twice.
+		if (m_entityCullKinds[entity] != CullKind::UnculledKind)
+			continue;
 
-	// Cull entities not visible in the viewport, and sort entities according to their texture render order before rendering.
-	std::vector<Entity> entitiesToRender;
-	std::copy_if(m_entities.begin(), m_entities.end(), std::back_inserter(entitiesToRender), filter);
-	std::sort(entitiesToRender.begin(), entitiesToRender.end(), sort);
+		// Tiles and scenery never move, projectiles and NPCs may, and the player should always be on the screen. Anything
+		// else isn't rendered.
+		CullKind cullKind = CullKind::UnculledKind;
+		if (m_registry.HaveComponent<TileComponent>(entity) || m_registry.HaveTag<SceneryTag>(entity))
+		{
+			// Static entities in the tile layers are baked, unless they change every frame or carry a health bar.
+			const bool isInTileLayers = m_registry.GetComponentRead<TextureComponent>(entity).renderOrder <= RenderOrder::TopTileOrder;
+			const bool isBakeable = m_tileLayerCache && isInTileLayers
+				&& !m_registry.HaveComponent<AnimationComponent>(entity)
+				&& !m_registry.HaveComponent<HealthComponent>(entity);
+			cullKind = isBakeable ? CullKind::BakedKind : CullKind::StaticKind;
+		}
+		else if (m_registry.HaveTag<ProjectileTag>(entity) || m_registry.HaveTag<NPCTag>(entity))
+			cullKind = CullKind::DynamicKind;
+		else if (m_registry.HaveTag<PlayerTag>(entity))
+			cullKind = CullKind::AlwaysVisibleKind;
+
+		switch (cullKind)
+		{
+		case CullKind::StaticKind:
+			m_viewportCuller->AddStaticEntity(entity, GetRenderBounds(entity));
+			break;
+		case CullKind::BakedKind:
+			m_tileLayerCache->AddEntity(entity, GetRenderBounds(entity));
+			break;
+		case CullKind::DynamicKind:
+			m_dynamicEntityIndices[entity] = static_cast<unsigned int>(m_dynamicEntities.size());
+			m_dynamicEntities.push_back(entity);
+			break;
+		case CullKind::AlwaysVisibleKind:
+			m_alwaysVisibleEntities.push_back(entity);
+			break;
+		default:
+			break;
+		}
 
-	// Render each texture and sprite.
-	for (const Entity& entity : entitiesToRender)
+		m_entityCullKinds[entity] = cullKind;
+	}
+
+	m_pendingEntities.clear();
+}
+
+void TextureRenderSystem::UpdateDynamicEntities()
+{
+	m_dynamicProxies.clear();
+	for (const Entity entity : m_dynamicEntities)
 	{
-		if (m_registry.HaveComponent<AnimationComponent>(entity))
-			RenderSprite(entity, m_registry, renderer, textureManager);
-		else if (m_registry.HaveComponent<TileComponent>(entity))
-			RenderTile(entity, m_registry, renderer, textureManager);
-		else
-			RenderTexture(entity, m_registry, renderer, textureManager);
+		m_dynamicProxies.push_back({ GetRenderBounds(entity), entity });
+	}
 
-		// Render health bar for entities with a health component.
-		if (m_registry.HaveComponent<HealthComponent>(entity))
-			RenderHealthBar(entity, m_registry, renderer, textureManager);
+	m_viewportCuller->UpdateDynamicEntities(m_dynamicProxies);
+}
 
-		// If debug mode is toggled, render the AABB boxes of the relevant entities.
-		if (m_debugModeEnabled && m_registry.HaveComponent<CollisionComponent>(entity))
-			RenderColliders(entity, m_registry, renderer);
+AABB TextureRenderSystem::GetRenderBounds(Entity an_entity) const
+{
+	static const TextureManager& textureManager = TextureManager::GetInstanceRead();
+	const TransformComponent& transformComponent = m_registry.GetComponentRead<TransformComponent>(an_entity);
+
+	// The size of what gets drawn: a tile, a single sprite of a sprite sheet, or the whole texture.
+	float width = 0.0f;
+	float height = 0.0f;
+	if (m_registry.HaveComponent<TileComponent>(an_entity))
+	{
+		const TileComponent& tileComponent = m_registry.GetComponentRead<TileComponent>(an_entity);
+		width = static_cast<float>(tileComponent.tileWidth);
+		height = static_cast<float>(tileComponent.tileHeight);
 	}
+	else if (m_registry.HaveComponent<AnimationComponent>(an_entity))
+	{
+		const AnimationComponent& animationComponent = m_registry.GetComponentRead<AnimationComponent>(an_entity);
+		width = static_cast<float>(animationComponent.spriteWidth);
+		height = static_cast<float>(animationComponent.spriteHeight);
+	}
+	else
+	{
+		const TextureComponent& textureComponent = m_registry.GetComponentRead<TextureComponent>(an_entity);
+		width = static_cast<float>(textureManager.GetTextureWidth(textureComponent.textureId));
+		height = static_cast<float>(textureManager.GetTextureHeight(textureComponent.textureId));
+	}
+
+	return {
+		transformComponent.x,
+		transformComponent.y,
+		transformComponent.x + width * transformComponent.xScale,
+		transformComponent.y + height * transformComponent.yScale
+	};
 }
 
-void TextureRenderSystem::RenderTile(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager)
+uint64_t TextureRenderSystem::GetSortKey(Entity an_entity) const
 {
-	// Retrieve the camera transform for render position related offsets and calculations.
-	const TransformComponent& cameraTransform = a_registry.GetComponentRead<TransformComponent>(m_cameraEntity);
+	static const TextureManager& textureManager = TextureManager::GetInstanceRead();
+
+	// Render the lesser render order texture first. Within an order, entities sharing a texture page are kept together
+	// so they go out in a single batch, and the ones further down the screen are drawn over the ones above them.
+	const TextureComponent& textureComponent = m_registry.GetComponentRead<TextureComponent>(an_entity);
+	const TransformComponent& transformComponent = m_registry.GetComponentRead<TransformComponent>(an_entity);
+	const unsigned int texturePage = textureManager.GetTextureRegion(textureComponent.textureId).pageIndex;
+	return RenderQueue::MakeSortKey(textureComponent.renderOrder, texturePage, transformComponent.y, an_entity);
+}
+
+void TextureRenderSystem::BakeChunk(unsigned int a_chunkIndex, SDL_Renderer* a_renderer, RenderCommandBuffer& a_commandBuffer, const TextureManager& a_textureManager)
+{
+	if (!m_tileLayerCache->BeginBake(a_renderer, a_commandBuffer, a_chunkIndex))
+		return;
+
+	// Sort the chunk's entities the same way as the screen's, so overlapping scenery stacks the same way.
+	m_bakeQueue.Clear();
+	for (const Entity entity : m_tileLayerCache->GetChunkEntitiesRead(a_chunkIndex))
+	{
+		m_bakeQueue.Push(GetSortKey(entity), entity);
+	}
+	m_bakeQueue.Sort();
+
+	// Draw them relative to the top left corner of the chunk.
+	const SDL_Rect chunkRect = m_tileLayerCache->GetChunkRect(a_chunkIndex);
+	const SDL_FPoint chunkOrigin = { static_cast<float>(chunkRect.x), static_cast<float>(chunkRect.y) };
+	m_spriteBatcher.Begin(a_commandBuffer);
+	for (const RenderQueue::RenderItem& renderItem : m_bakeQueue.GetItemsRead())
+	{
+		if (m_registry.HaveComponent<TileComponent>(renderItem.entity))
+			RenderTile(renderItem.entity, m_registry, a_textureManager, chunkOrigin);
+		else
+			RenderTexture(renderItem.entity, m_registry, a_textureManager, chunkOrigin);
+	}
+	m_spriteBatcher.End();
+
+	m_tileLayerCache->EndBake(a_commandBuffer, a_chunkIndex);
+}
 
+void TextureRenderSystem::RenderTile(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager, const SDL_FPoint& an_origin)
+{
 	// Retrieve the necessary entity components to render the tile.
 	const TransformComponent& transformComponent = a_registry.GetComponentRead<TransformComponent>(entity);
 	const TextureComponent& textureComponent = a_registry.GetComponentRead<TextureComponent>(entity);
 	const TileComponent& tileComponent = a_registry.GetComponentRead<TileComponent>(entity);
 
-	// Retrieve the texture containing the tile map that we will read from.
+	// Retrieve the texture containing the tile map that we will read from, and where on its page it lies.
 	SDL_Texture* tilemapTexture = a_textureManager.GetTexture(textureComponent.textureId);
+	const TextureRegion& tilemapRegion = a_textureManager.GetTextureRegion(textureComponent.textureId);
 
 	// Where on the texture to read the tile from.
 	const SDL_Rect sourceRectangle = {
-		tileComponent.tileX,
-		tileComponent.tileY,
+		tilemapRegion.rect.x + tileComponent.tileX,
+		tilemapRegion.rect.y + tileComponent.tileY,
 		tileComponent.tileWidth,
 		tileComponent.tileHeight
 	};
 
-	// Where on the renderer to write the texture.
-	const SDL_Rect destinationRectangle = {
-		static_cast<int>(round(transformComponent.x - cameraTransform.x)),
-		static_cast<int>(round(transformComponent.y - cameraTransform.y)),
-		static_cast<int>(round(tileComponent.tileWidth * transformComponent.xScale)),
-		static_cast<int>(round(tileComponent.tileHeight * transformComponent.yScale))
+	// Where on the renderer to write the texture, snapped to whole pixels.
+	const SDL_FRect destinationRectangle = {
+		roundf(transformComponent.x - an_origin.x),
+		roundf(transformComponent.y - an_origin.y),
+		roundf(tileComponent.tileWidth * transformComponent.xScale),
+		roundf(tileComponent.tileHeight * transformComponent.yScale)
 	};
 
-	// Render the texture onto the back buffer.
-	SDL_RenderCopy(a_renderer, tilemapTexture, &sourceRectangle, &destinationRectangle);
+	// Queue the tile into the batch.
+	m_spriteBatcher.DrawSprite(tilemapTexture, a_textureManager.GetTexturePageSize(textureComponent.textureId), sourceRectangle, destinationRectangle, 0.0f);
 }
 
-void TextureRenderSystem::RenderSprite(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager)
+void TextureRenderSystem::RenderSprite(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager, const SDL_FPoint& an_origin)
 {
-	// Retrieve the camera transform for render position related offsets and calculations.
-	const TransformComponent& cameraTransform = a_registry.GetComponentRead<TransformComponent>(m_cameraEntity);
-
 	// Get the relevant components required to render the player texture.
 	const TransformComponent& transformComponent = a_registry.GetComponentRead<TransformComponent>(entity);
 	const AnimationComponent& spriteComponent = a_registry.GetComponentRead<AnimationComponent>(entity);
 	const TextureComponent& textureComponent = a_registry.GetComponentRead<TextureComponent>(entity);
 
-	// Get the player texture itself.
+	// Get the player texture itself, and where on its page it lies.
 	SDL_Texture* currentPlayerTexture = a_textureManager.GetTexture(textureComponent.textureId);
+	const TextureRegion& spriteSheetRegion = a_textureManager.GetTextureRegion(textureComponent.textureId);
 
 	// The position and dimensions of the texture that will be copied.
 	const SDL_Rect sourceRect = {
-		spriteComponent.currentColumn * spriteComponent.spriteWidth,
-		spriteComponent.currentRow * spriteComponent.spriteHeight,
+		spriteSheetRegion.rect.x + spriteComponent.currentColumn * spriteComponent.spriteWidth,
+		spriteSheetRegion.rect.y + spriteComponent.currentRow * spriteComponent.spriteHeight,
 		spriteComponent.spriteWidth,
 		spriteComponent.spriteHeight
 	};
 
-	// The positions and destination of where the texture will be copied too.
-	const SDL_Rect destinationRect = {
-		static_cast<int>(round(transformComponent.x - cameraTransform.x)),
-		static_cast<int>(round(transformComponent.y - cameraTransform.y)),
-		static_cast<int>(round(spriteComponent.spriteWidth * transformComponent.xScale)),
-		static_cast<int>(round(spriteComponent.spriteHeight * transformComponent.yScale))
+	// The positions and destination of where the texture will be copied too, snapped to whole pixels.
+	const SDL_FPoint renderPosition = GetRenderPosition(entity);
+	const SDL_FRect destinationRect = {
+		roundf(renderPosition.x - an_origin.x),
+		roundf(renderPosition.y - an_origin.y),
+		roundf(spriteComponent.spriteWidth * transformComponent.xScale),
+		roundf(spriteComponent.spriteHeight * transformComponent.yScale)
 	};
 
-	// Render the sprite onto the back buffer.
-	SDL_RenderCopyEx(a_renderer, currentPlayerTexture, &sourceRect, &destinationRect, transformComponent.rotation, nullptr, SDL_FLIP_NONE);
+	// Queue the sprite into the batch, rotated around its center.
+	m_spriteBatcher.DrawSprite(currentPlayerTexture, a_textureManager.GetTexturePageSize(textureComponent.textureId), sourceRect, destinationRect, static_cast<float>(transformComponent.rotation));
 }
 
-void TextureRenderSystem::RenderTexture(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager)
+void TextureRenderSystem::RenderTexture(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager, const SDL_FPoint& an_origin)
 {
-	// Retrieve the camera transform for render position related offsets and calculations.
-	const TransformComponent& cameraTransform = a_registry.GetComponentRead<TransformComponent>(m_cameraEntity);
-
 	// Retrieve the necessary entity components to render the tile.
 	const TransformComponent& transformComponent = a_registry.GetComponentRead<TransformComponent>(entity);
 	const TextureComponent& textureComponent = a_registry.GetComponentRead<TextureComponent>(entity);
 
-	const int textureWidth = a_textureManager.GetTextureWidth(textureComponent.textureId);
-	const int textureHeight = a_textureManager.GetTextureHeight(textureComponent.textureId);
-
-	// Retrieve the texture containing the tile map that we will read from.
+	// Retrieve the page holding the texture, and where on it the texture lies.
 	SDL_Texture* texture = a_textureManager.GetTexture(textureComponent.textureId);
-
-	// Where on the texture to read the tile from.
-	const SDL_Rect sourceRectangle = {
-		0,
-		0,
-		textureWidth,
-		textureHeight
+	const SDL_Rect& sourceRectangle = a_textureManager.GetTextureRegion(textureComponent.textureId).rect;
+	const int textureWidth = sourceRectangle.w;
+	const int textureHeight = sourceRectangle.h;
+
+	// Where on the renderer to write the texture, snapped to whole pixels.
+	const SDL_FPoint renderPosition = GetRenderPosition(entity);
+	const SDL_FRect destinationRectangle = {
+		roundf(renderPosition.x - an_origin.x),
+		roundf(renderPosition.y - an_origin.y),
+		roundf(textureWidth * transformComponent.xScale),
+		roundf(textureHeight * transformComponent.yScale)
 	};
 
-	// Where on the renderer to write the texture.
-	const SDL_Rect destinationRectangle = {
-		static_cast<int>(round(transformComponent.x - cameraTransform.x)),
-		static_cast<int>(round(transformComponent.y - cameraTransform.y)),
-		static_cast<int>(round(textureWidth * transformComponent.xScale)),
-		static_cast<int>(round(textureHeight * transformComponent.yScale))
-	};
-
-	// Render the texture onto the back buffer.
-	SDL_RenderCopyEx(a_renderer, texture, &sourceRectangle, &destinationRectangle, transformComponent.rotation, nullptr, SDL_FLIP_NONE);
+	// Queue the texture into the batch, rotated around its center.
+	m_spriteBatcher.DrawSprite(texture, a_textureManager.GetTexturePageSize(textureComponent.textureId), sourceRectangle, destinationRectangle, static_cast<float>(transformComponent.rotation));
 }
 
-void TextureRenderSystem::RenderHealthBar(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager)
+void TextureRenderSystem::RenderHealthBar(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager)
 {
-	// Retrieve the camera transform for render position related offsets and calculations.
-	const TransformComponent& cameraTransform = a_registry.GetComponentRead<TransformComponent>(m_cameraEntity);
-
 	// Retrieve the relevant entity components required to render the health bar.
 	const TransformComponent& transformComponent = a_registry.GetComponentRead<TransformComponent>(entity);
 	const TextureComponent& textureComponent = a_registry.GetComponentRead<TextureComponent>(entity);
@@ -276,38 +517,35 @@ void TextureRenderSystem::RenderHealthBar(const Entity entity, Registry& a_regis
 	const int rectangleWidth = static_cast<int>(round(healthPercentage * textureWidth * transformComponent.xScale));
 	const int rectangleHeight = static_cast<int>(round(0.1f * textureHeight * transformComponent.yScale));
 
-	SDL_Rect healthBar = {
-		static_cast<int>(round(transformComponent.x - cameraTransform.x)),
-		static_cast<int>(round(transformComponent.y - cameraTransform.y)),
-		static_cast<int>(round(rectangleWidth)),
-		static_cast<int>(round(rectangleHeight))
+	const SDL_FPoint renderPosition = GetRenderPosition(entity);
+	const SDL_FRect healthBar = {
+		roundf(renderPosition.x - m_cameraOrigin.x),
+		roundf(renderPosition.y - m_cameraOrigin.y),
+		static_cast<float>(rectangleWidth),
+		static_cast<float>(rectangleHeight)
 	};
 
-	// Render the health bar in green.
-	SDL_SetRenderDrawColor(a_renderer, 0, 255, 0, 255);
-	SDL_RenderFillRect(a_renderer, &healthBar);
+	// Queue the health bar in green.
+	m_spriteBatcher.DrawFilledRect(healthBar, { 0, 255, 0, 255 });
 }
 
-void TextureRenderSystem::RenderColliders(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer)
+void TextureRenderSystem::RenderColliders(const Entity entity, Registry& a_registry, RenderCommandBuffer& a_commandBuffer)
 {
 	// Get the relevant components required to render the AABB box.
 	const TransformComponent& transformComponent = m_registry.GetComponentRead<TransformComponent>(entity);
 	const CollisionComponent& collisionComponent = m_registry.GetComponentRead<CollisionComponent>(entity);
 
-	// Get the camera transform to offset the rendering of the AABB box.
-	const TransformComponent& cameraTransform = m_registry.GetComponentRead<TransformComponent>(m_cameraEntity);
-
-	// Construct a rectangle representing the position dimensions of the box.
+	// Construct a rectangle representing the position dimensions of the box, offset by the camera.
+	const SDL_FPoint renderPosition = GetRenderPosition(entity);
 	SDL_Rect collisionBox = {
-		static_cast<int>(round(transformComponent.x - cameraTransform.x)),
-		static_cast<int>(round(transformComponent.y - cameraTransform.y)),
+		static_cast<int>(round(renderPosition.x - m_cameraOrigin.x)),
+		static_cast<int>(round(renderPosition.y - m_cameraOrigin.y)),
 		static_cast<int>(round(collisionComponent.colliderWidth * transformComponent.xScale)),
 		static_cast<int>(round(collisionComponent.colliderHeight * transformComponent.yScale))
 	};
 
 	// Draw the boxes in red.
-	SDL_SetRenderDrawColor(a_renderer, 255, 0, 0, 255);
-	SDL_RenderDrawRect(a_renderer, &collisionBox);
+	a_commandBuffer.RecordDrawRect(collisionBox, { 255, 0, 0, 255 });
 }
 
 void TextureRenderSystem::OnKeyUp(const KeyUpEvent& a_keyUpEvent)
@@ -317,3 +555,35 @@ void TextureRenderSystem::OnKeyUp(const KeyUpEvent& a_keyUpEvent)
 		m_debugModeEnabled = !m_debugModeEnabled;
 }
 
+void TextureRenderSystem::OnRenderTargetsReset(const RenderTargetsResetEvent& a_renderTargetsResetEvent)
+{
+	// Bake every chunk again as it comes back into view. Their textures are released, so the render thread has to be
+	// done with them first.
+	if (m_tileLayerCache)
+	{
+		Engine::GetInstanceWrite().GetRenderThreadWrite().WaitForIdle();
+		m_tileLayerCache->InvalidateAll();
+	}
+}
+
+void TextureRenderSystem::OnStaticEntityChanged(const StaticEntityChangedEvent& a_staticEntityChangedEvent)
+{
+	const Entity entity = a_staticEntityChangedEvent.entity;
+	if (entity >= m_entityCullKinds.size())
+		return;
+
+	// Put the entity back in at its new bounds, which also redraws the chunks it was and is now in.
+	switch (m_entityCullKinds[entity])
+	{
+	case CullKind::StaticKind:
+		m_viewportCuller->RemoveStaticEntity(entity);
+		m_viewportCuller->AddStaticEntity(entity, GetRenderBounds(entity));
+		break;
+	case CullKind::BakedKind:
+		m_tileLayerCache->RemoveEntity(entity);
+		m_tileLayerCache->AddEntity(entity, GetRenderBounds(entity));
+		break;
+	default:
+		break;
+	}
+}
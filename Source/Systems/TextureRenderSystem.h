@@ -2,6 +2,10 @@
 #include "ECS\System.h"
 #include "ECS\Registry.h"
 #include "Engine.h"
+#include "Rendering\RenderQueue.h"
+#include "Rendering\SpriteBatcher.h"
+#include "Rendering\TileLayerCache.h"
+#include "Rendering\ViewportCuller.h"
 #include "TextureManager\TextureManager.h"
 #include "Constants\Constants.h"
 
@@ -16,17 +20,78 @@ public:
 	void Update(float a_deltaTime) override;
 	void Render() override;
 
+	// Submission counters of the last rendered frame.
+	const SpriteBatcher::BatchStatistics& GetBatchStatisticsRead() const { return m_spriteBatcher.GetStatisticsRead(); }
+
+protected:
+	void OnEntityAdded(Entity an_entity) override;
+	void OnEntityRemoved(Entity an_entity) override;
+
 private:
-	void RenderTile(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager);
-	void RenderSprite(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager);
-	void RenderTexture(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager);
+	// How an entity is culled against the viewport.
+	enum class CullKind : unsigned char
+	{
+		UnculledKind = 0,	// Never rendered.
+		StaticKind,			// Placed once in the culler's static grid.
+		BakedKind,			// Drawn ahead of time into the tile layer cache.
+		DynamicKind,		// Handed to the culler every frame.
+		AlwaysVisibleKind	// Rendered without culling.
+	};
+
+	// Where a moving entity was at the end of the last two simulation steps, to draw it in between.
+	struct PositionHistory final
+	{
+		float previousX = 0.0f;			// 4 bytes.
+		float previousY = 0.0f;			// 4 bytes.
+		float latestX = 0.0f;			// 4 bytes.
+		float latestY = 0.0f;			// 4 bytes.
+		unsigned int stepStamp = 0;		// 4 bytes. Step the latest position was recorded in, zero if never.
+	};									// Total = 20 bytes.
+
+	void RecordPosition(Entity an_entity);
+
+	// Where to draw the entity this frame, between its positions at the last two simulation steps. Entities not moving
+	// are drawn where they are.
+	SDL_FPoint GetRenderPosition(Entity an_entity) const;
 
-	void RenderHealthBar(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer, const TextureManager& a_textureManager);
-	void RenderColliders(const Entity entity, Registry& a_registry, SDL_Renderer* a_renderer);
+	void ClassifyPendingEntities();
+	void UpdateDynamicEntities();
+	AABB GetRenderBounds(Entity an_entity) const;
+	uint64_t GetSortKey(Entity an_entity) const;
+
+	// Record drawing the baked entities of a chunk of the tile layer cache into its texture.
+	void BakeChunk(unsigned int a_chunkIndex, SDL_Renderer* a_renderer, RenderCommandBuffer& a_commandBuffer, const TextureManager& a_textureManager);
+
+	// Entities are drawn relative to the origin, the top left corner of the camera or of the chunk being baked.
+	void RenderTile(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager, const SDL_FPoint& an_origin);
+	void RenderSprite(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager, const SDL_FPoint& an_origin);
+	void RenderTexture(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager, const SDL_FPoint& an_origin);
+
+	void RenderHealthBar(const Entity entity, Registry& a_registry, const TextureManager& a_textureManager);
+	void RenderColliders(const Entity entity, Registry& a_registry, RenderCommandBuffer& a_commandBuffer);
 
 	void OnKeyUp(const KeyUpEvent& a_keyUpEvent);
+	void OnRenderTargetsReset(const RenderTargetsResetEvent& a_renderTargetsResetEvent);
+	void OnStaticEntityChanged(const StaticEntityChangedEvent& a_staticEntityChangedEvent);
 
 private:
+	std::unique_ptr<ViewportCuller> m_viewportCuller;	// Finds the entities overlapping the camera.
+	std::unique_ptr<TileLayerCache> m_tileLayerCache;	// Tiles and scenery drawn ahead of time, null if the renderer can't.
+	std::vector<Entity> m_pendingEntities;				// Entities added since the last render, classified once their tags are in.
+	std::vector<CullKind> m_entityCullKinds;			// How every entity is culled, indexed by entity.
+	std::vector<Entity> m_dynamicEntities;				// Entities handed to the culler every frame.
+	std::vector<unsigned int> m_dynamicEntityIndices;	// Index of every dynamic entity in the list above, indexed by entity.
+	std::vector<Entity> m_alwaysVisibleEntities;		// Entities rendered without culling.
+	std::vector<BroadphaseProxy> m_dynamicProxies;		// Render bounds of the dynamic entities this frame.
+	std::vector<Entity> m_visibleEntities;				// Entities overlapping the camera this frame.
+	RenderQueue m_renderQueue;							// The visible entities, sorted into render order.
+	RenderQueue m_bakeQueue;							// Entities of the chunk being baked, sorted into render order.
+	std::vector<unsigned int> m_visibleChunks;			// Chunks of the tile layer cache visible this frame.
+	SpriteBatcher m_spriteBatcher;						// Gathers the quads of the frame into as few submissions as possible.
+	std::vector<PositionHistory> m_positionHistories;	// Positions of the moving entities over the last steps, indexed by entity.
+	unsigned int m_stepStamp = 1;						// Simulation steps recorded so far, plus one.
+	SDL_FPoint m_cameraOrigin = { 0.0f, 0.0f };			// Top left corner of the camera in this frame.
+
 	Entity m_cameraEntity = INVALID_ENTITY;
 	bool m_debugModeEnabled = false;
 };
@@ -0,0 +1,102 @@
+#include "PCH.h"
+#include "AtlasPacker.h"
+
+AtlasPacker::AtlasPacker(int a_width, int a_height)
+	: m_width(a_width)
+	, m_height(a_height)
+{
+	// Start with an empty page, its floor a single segment.
+	m_skyline.push_back({ 0, 0, a_width });
+}
+
+bool AtlasPacker::Pack(int a_width, int a_height, SDL_Point& a_position)
+{
+	if (a_width <= 0 || a_height <= 0)
+		return false;
+
+	// Try resting the rectangle on every segment, and keep the spot where its top is lowest.
+	size_t bestSegmentIndex = m_skyline.size();
+	int bestTop = std::numeric_limits<int>::max();
+	int bestWidth = std::numeric_limits<int>::max();
+	int bestY = 0;
+	for (size_t segmentIndex = 0; segmentIndex < m_skyline.size(); ++segmentIndex)
+	{
+		int y = 0;
+		if (!FindRestingHeight(segmentIndex, a_width, a_height, y))
+			continue;
+
+		const int top = y + a_height;
+		if (top < bestTop || (top == bestTop && m_skyline[segmentIndex].width < bestWidth))
+		{
+			bestSegmentIndex = segmentIndex;
+			bestTop = top;
+			bestWidth = m_skyline[segmentIndex].width;
+			bestY = y;
+		}
+	}
+
+	if (bestSegmentIndex == m_skyline.size())
+		return false;
+
+	a_position = { m_skyline[bestSegmentIndex].x, bestY };
+	AddSegment(bestSegmentIndex, { a_position.x, a_position.y, a_width, a_height });
+	m_packedArea += static_cast<size_t>(a_width) * a_height;
+	return true;
+}
+
+bool AtlasPacker::FindRestingHeight(size_t a_segmentIndex, int a_width, int a_height, int& a_y) const
+{
+	const int x = m_skyline[a_segmentIndex].x;
+	if (x + a_width > m_width)
+		return false;
+
+	// The rectangle rests on the highest segment under it.
+	int y = 0;
+	int widthLeft = a_width;
+	for (size_t segmentIndex = a_segmentIndex; widthLeft > 0; ++segmentIndex)
+	{
+		y = std::max(y, m_skyline[segmentIndex].y);
+		if (y + a_height > m_height)
+			return false;
+		widthLeft -= m_skyline[segmentIndex].width;
+	}
+
+	a_y = y;
+	return true;
+}
+
+void AtlasPacker::AddSegment(size_t a_segmentIndex, const SDL_Rect& a_rect)
+{
+	m_skyline.insert(m_skyline.begin() + a_segmentIndex, { a_rect.x, a_rect.y + a_rect.h, a_rect.w });
+
+	// Trim the segments now under the rectangle, dropping the ones it covers whole.
+	const int rectRight = a_rect.x + a_rect.w;
+	size_t segmentIndex = a_segmentIndex + 1;
+	while (segmentIndex < m_skyline.size() && m_skyline[segmentIndex].x < rectRight)
+	{
+		SkylineSegment& segment = m_skyline[segmentIndex];
+		const int overlap = rectRight - segment.x;
+		if (overlap < segment.width)
+		{
+			segment.x += overlap;
+			segment.width -= overlap;
+			break;
+		}
+
+		m_skyline.erase(m_skyline.begin() + segmentIndex);
+	}
+
+	// Merge neighboring segments at the same height.
+	for (segmentIndex = 1; segmentIndex < m_skyline.size();)
+	{
+		if (m_skyline[segmentIndex - 1].y == m_skyline[segmentIndex].y)
+		{
+			m_skyline[segmentIndex - 1].width += m_skyline[segmentIndex].width;
+			m_skyline.erase(m_skyline.begin() + segmentIndex);
+		}
+		else
+		{
+			++segmentIndex;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "PCH.h"
+
+// Places rectangles on an atlas page with the skyline bottom left heuristic. The packer tracks the top edge of what was
+// placed so far as a list of horizontal segments, and puts every rectangle where its top ends up lowest, ties going to
+// the narrowest segment. It never moves what it placed, so rectangles can be packed as they come.
+class AtlasPacker final
+{
+public:
+	AtlasPacker(int a_width, int a_height);
+	~AtlasPacker() = default;
+
+	// Find room for a rectangle and claim it. Returns false if it doesn't fit anywhere.
+	bool Pack(int a_width, int a_height, SDL_Point& a_position);
+
+	// Fraction of the page covered by packed rectangles.
+	float GetOccupancy() const { return static_cast<float>(m_packedArea) / (static_cast<float>(m_width) * m_height); }
+
+private:
+	// A horizontal segment of the skyline.
+	struct SkylineSegment final
+	{
+		int x = 0;				// 4 bytes.
+		int y = 0;				// 4 bytes. Top of what is packed below the segment.
+		int width = 0;			// 4 bytes.
+	};							// Total = 12 bytes.
+
+	// Where a rectangle with its left edge on the segment would rest. Returns false if it would stick out of the page.
+	bool FindRestingHeight(size_t a_segmentIndex, int a_width, int a_height, int& a_y) const;
+
+	// Raise the skyline over a packed rectangle.
+	void AddSegment(size_t a_segmentIndex, const SDL_Rect& a_rect);
+
+private:
+	std::vector<SkylineSegment> m_skyline;	// Left to right, covering the width of the page.
+	int m_width = 0;
+	int m_height = 0;
+	size_t m_packedArea = 0;
+};
@@ -1,10 +1,11 @@
 #include "PCH.h"
 #include "TextureManager.h"
+#include "AtlasPacker.h"
 #include "Engine.h"
+#include "Memory\AllocationCounter.h"
 #include "SDL\SDL_render.h"
 
 TextureManager::TextureManager()
-	: m_stringHasher()
 {
 }
 
@@ -15,17 +16,20 @@ TextureManager::~TextureManager()
 
 void TextureManager::Initialize()
 {
-	LoadTexture("./Assets/Images/Chopper-Spritesheet.png");
-	LoadTexture("./Assets/Images/Projectile.png");
-	LoadTexture("./Assets/Images/Tank.png");
-	LoadTexture("./Assets/Images/DestroyedTank.png");
-	LoadTexture("./Assets/Images/Truck.png");
-	LoadTexture("./Assets/Images/Airplane-Spritesheet.png");
-	LoadTexture("./Assets/Images/Tank.png");
-	LoadTexture("./Assets/Images/LandingBase.png");
-	LoadTexture("./Assets/Images/Boat.png");
-	LoadTexture("./Assets/Images/Carrier.png");
-	LoadTexture("./Assets/Images/Jet-Spritesheet.png");
+	// Everything the scene draws shares atlas pages, so a frame's sprites batch together.
+	LoadTextureAtlas({
+		"./Assets/Maps/Jungle.png",
+		"./Assets/Images/Chopper-Spritesheet.png",
+		"./Assets/Images/Projectile.png",
+		"./Assets/Images/Tank.png",
+		"./Assets/Images/DestroyedTank.png",
+		"./Assets/Images/Truck.png",
+		"./Assets/Images/Airplane-Spritesheet.png",
+		"./Assets/Images/LandingBase.png",
+		"./Assets/Images/Boat.png",
+		"./Assets/Images/Carrier.png",
+		"./Assets/Images/Jet-Spritesheet.png"
+	});
 }
 
 void TextureManager::Shutdown()
@@ -35,12 +39,16 @@ void TextureManager::Shutdown()
 
 TextureId TextureManager::LoadTexture(const char* a_texturePath)
 {
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+
 	// Get the engine and renderer to construct the texture.
 	static const Engine& engine = Engine::GetInstanceRead();
 	static SDL_Renderer* renderer = engine.GetEngineRenderer();
 
-	// Hash the path to the file. This is the key in the map.
-	const TextureId hash = m_stringHasher(a_texturePath);
+	// Each path is loaded once.
+	const TextureId loadedTextureId = GetTextureId(a_texturePath);
+	if (loadedTextureId != INVALID_TEXTURE_ID)
+		return loadedTextureId;
 
 	// Load the texture.
 	SDL_Texture* texture = IMG_LoadTexture(renderer, a_texturePath);
@@ -48,63 +56,239 @@ TextureId TextureManager::LoadTexture(const char* a_texturePath)
 	{
 		fprintf(stderr, "Failed to load texture %s.\n", a_texturePath);
 		assert(false);
+		return INVALID_TEXTURE_ID;
 	}
 
-	// Add the texture to our map and return the result.
-	m_textureMap[hash] = texture;
-	return hash;
+	// The texture covers its whole page. This is the only time it is queried.
+	Uint32 textureFormat = SDL_PIXELFORMAT_UNKNOWN;
+	int textureWidth = 0;
+	int textureHeight = 0;
+	SDL_QueryTexture(texture, &textureFormat, nullptr, &textureWidth, &textureHeight);
+
+	// Add the texture to the table and return its id.
+	return AddTexture(a_texturePath, { { 0, 0, textureWidth, textureHeight }, AddPage(texture, textureWidth, textureHeight, 1) }, textureFormat);
 }
 
-TextureId TextureManager::GetTextureId(const char* a_texturePath) const
+void TextureManager::LoadTextureAtlas(const std::vector<const char*>& a_texturePaths)
 {
-	const size_t textureHash = m_stringHasher(a_texturePath);;
-	assert(HaveTexture(textureHash));
-	return textureHash;
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+
+	static SDL_Renderer* renderer = Engine::GetInstanceRead().GetEngineRenderer();
+
+	// An image waiting to be packed.
+	struct AtlasImage final
+	{
+		const char* texturePath = nullptr;	// 8 bytes.
+		SDL_Surface* surface = nullptr;		// 8 bytes.
+	};										// Total = 16 bytes.
+
+	// Load the images that aren't in yet.
+	std::vector<AtlasImage> images;
+	for (const char* texturePath : a_texturePaths)
+	{
+		const auto isSamePath = [texturePath](const AtlasImage& an_image) { return strcmp(an_image.texturePath, texturePath) == 0; };
+		if (GetTextureId(texturePath) != INVALID_TEXTURE_ID || std::any_of(images.begin(), images.end(), isSamePath))
+			continue;
+
+		SDL_Surface* surface = IMG_Load(texturePath);
+		if (!surface)
+		{
+			fprintf(stderr, "Failed to load texture %s.\n", texturePath);
+			assert(false);
+			continue;
+		}
+
+		images.push_back({ texturePath, surface });
+	}
+
+	// Tallest first, which packs tighter on a skyline.
+	std::sort(images.begin(), images.end(), [](const AtlasImage& an_image1, const AtlasImage& an_image2)
+	{
+		if (an_image1.surface->h != an_image2.surface->h)
+			return an_image1.surface->h > an_image2.surface->h;
+		return an_image1.surface->w > an_image2.surface->w;
+	});
+
+	// Use pages as large as the renderer takes, up to the atlas page size.
+	SDL_RendererInfo rendererInfo = {};
+	SDL_GetRendererInfo(renderer, &rendererInfo);
+	const int pageWidth = rendererInfo.max_texture_width > 0 ? std::min(ATLAS_PAGE_SIZE, rendererInfo.max_texture_width) : ATLAS_PAGE_SIZE;
+	const int pageHeight = rendererInfo.max_texture_height > 0 ? std::min(ATLAS_PAGE_SIZE, rendererInfo.max_texture_height) : ATLAS_PAGE_SIZE;
+
+	// Pack every image onto the first page with room for it, starting a new page when none has.
+	std::vector<AtlasPacker> packers;
+	std::vector<SDL_Surface*> pageSurfaces;
+	std::vector<SDL_Point> pageExtents;					// Right and bottom edges of what is packed on each page.
+	std::vector<TextureRegion> regions(images.size());
+	for (size_t imageIndex = 0; imageIndex < images.size(); ++imageIndex)
+	{
+		SDL_Surface* surface = images[imageIndex].surface;
+		const int paddedWidth = surface->w + 2 * ATLAS_PADDING;
+		const int paddedHeight = surface->h + 2 * ATLAS_PADDING;
+
+		// Images too large for a page get a page of their own once the atlas is built.
+		if (paddedWidth > pageWidth || paddedHeight > pageHeight)
+		{
+			regions[imageIndex].pageIndex = std::numeric_limits<unsigned int>::max();
+			continue;
+		}
+
+		SDL_Point position = { 0, 0 };
+		size_t packerIndex = 0;
+		while (packerIndex < packers.size() && !packers[packerIndex].Pack(paddedWidth, paddedHeight, position))
+		{
+			++packerIndex;
+		}
+
+		if (packerIndex == packers.size())
+		{
+			packers.emplace_back(pageWidth, pageHeight);
+			pageSurfaces.push_back(SDL_CreateRGBSurfaceWithFormat(0, pageWidth, pageHeight, 32, SDL_PIXELFORMAT_ARGB8888));
+			pageExtents.push_back({ 0, 0 });
+			packers.back().Pack(paddedWidth, paddedHeight, position);
+		}
+
+		pageExtents[packerIndex].x = std::max(pageExtents[packerIndex].x, position.x + paddedWidth);
+		pageExtents[packerIndex].y = std::max(pageExtents[packerIndex].y, position.y + paddedHeight);
+
+		BlitPadded(surface, pageSurfaces[packerIndex], position.x + ATLAS_PADDING, position.y + ATLAS_PADDING);
+		regions[imageIndex] = { { position.x + ATLAS_PADDING, position.y + ATLAS_PADDING, surface->w, surface->h }, static_cast<unsigned int>(packerIndex) };
+	}
+
+	// Upload the pages, cropped to what was packed on them.
+	std::vector<unsigned int> pageIndices(pageSurfaces.size());
+	for (size_t packerIndex = 0; packerIndex < pageSurfaces.size(); ++packerIndex)
+	{
+		SDL_Surface* pageSurface = pageSurfaces[packerIndex];
+		const SDL_Point& pageExtent = pageExtents[packerIndex];
+		if (pageExtent.x < pageWidth || pageExtent.y < pageHeight)
+		{
+			SDL_Surface* croppedSurface = SDL_CreateRGBSurfaceWithFormat(0, pageExtent.x, pageExtent.y, 32, SDL_PIXELFORMAT_ARGB8888);
+			SDL_SetSurfaceBlendMode(pageSurface, SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(pageSurface, nullptr, croppedSurface, nullptr);
+			SDL_FreeSurface(pageSurface);
+			pageSurface = croppedSurface;
+		}
+
+		SDL_Texture* pageTexture = SDL_CreateTextureFromSurface(renderer, pageSurface);
+		SDL_SetTextureBlendMode(pageTexture, SDL_BLENDMODE_BLEND);
+		const SDL_Point pageSize = { pageSurface->w, pageSurface->h };
+		SDL_FreeSurface(pageSurface);
+
+		const unsigned int textureCount = static_cast<unsigned int>(std::count_if(regions.begin(), regions.end(), [packerIndex](const TextureRegion& a_region) { return a_region.pageIndex == packerIndex; }));
+		pageIndices[packerIndex] = AddPage(pageTexture, pageSize.x, pageSize.y, textureCount);
+	}
+
+	// Record where every texture ended up. Packed pages share the format they were built in, oversized images keep
+	// the one of their own page.
+	for (size_t imageIndex = 0; imageIndex < images.size(); ++imageIndex)
+	{
+		SDL_Surface* surface = images[imageIndex].surface;
+		TextureRegion& region = regions[imageIndex];
+		Uint32 textureFormat = SDL_PIXELFORMAT_ARGB8888;
+		if (region.pageIndex == std::numeric_limits<unsigned int>::max())
+		{
+			SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+			SDL_QueryTexture(texture, &textureFormat, nullptr, nullptr, nullptr);
+			region = { { 0, 0, surface->w, surface->h }, AddPage(texture, surface->w, surface->h, 1) };
+		}
+		else
+			region.pageIndex = pageIndices[region.pageIndex];
+
+		AddTexture(images[imageIndex].texturePath, region, textureFormat);
+		SDL_FreeSurface(surface);
+	}
 }
 
-bool TextureManager::HaveTexture(TextureId a_textureId) const
+TextureId TextureManager::GetTextureId(const char* a_texturePath) const
 {
-	return m_textureMap.find(a_textureId) != m_textureMap.end();
+	const auto textureIdIterator = m_textureIds.find(a_texturePath);
+	return textureIdIterator != m_textureIds.end() ? textureIdIterator->second : INVALID_TEXTURE_ID;
 }
 
-SDL_Texture* TextureManager::GetTexture(TextureId a_textureId) const
+void TextureManager::RemoveTexture(TextureId a_textureId)
 {
-	return m_textureMap.at(a_textureId);
+	assert(HaveTexture(a_textureId));
+
+	// Free the page once no texture is left on it, and retire the id of this texture.
+	TextureMetadata& textureMetadata = m_textureMetadata[a_textureId];
+	const unsigned int pageIndex = textureMetadata.region.pageIndex;
+	if (--m_pageTextureCounts[pageIndex] == 0)
+	{
+		SDL_DestroyTexture(m_pageTextures[pageIndex]);
+		m_pageTextures[pageIndex] = nullptr;
+	}
+	textureMetadata.isLoaded = false;
+
+	for (auto textureIdIterator = m_textureIds.begin(); textureIdIterator != m_textureIds.end(); ++textureIdIterator)
+	{
+		if (textureIdIterator->second == a_textureId)
+		{
+			m_textureIds.erase(textureIdIterator);
+			break;
+		}
+	}
 }
 
-void TextureManager::RemoveTexture(TextureId a_textureId)
+void TextureManager::Clear()
 {
-	// Free the texture and erase the entry for this texture.
-	SDL_Texture* texture = m_textureMap.at(a_textureId);
-	SDL_DestroyTexture(texture);
-	m_textureMap.erase(a_textureId);
+	// Erase all pages and clear the tables.
+	for (SDL_Texture* pageTexture : m_pageTextures)
+	{
+		if (pageTexture)
+			SDL_DestroyTexture(pageTexture);
+	}
+	m_pageTextures.clear();
+	m_pageTextureCounts.clear();
+	m_pageSizes.clear();
+	m_textureMetadata.clear();
+	m_textureIds.clear();
 }
 
-int TextureManager::GetTextureWidth(TextureId a_textureId) const
+unsigned int TextureManager::AddPage(SDL_Texture* a_pageTexture, int a_pageWidth, int a_pageHeight, unsigned int a_textureCount)
 {
-	// Query the SDL texture for its width.
-	int textureWidth = 0;
-	SDL_Texture* texture = m_textureMap.at(a_textureId);
-	SDL_QueryTexture(texture, nullptr, nullptr, &textureWidth, nullptr);
-	return textureWidth;
+	m_pageTextures.push_back(a_pageTexture);
+	m_pageTextureCounts.push_back(a_textureCount);
+	m_pageSizes.push_back({ a_pageWidth, a_pageHeight });
+	return static_cast<unsigned int>(m_pageTextures.size() - 1);
 }
 
-int TextureManager::GetTextureHeight(TextureId a_textureId) const
+TextureId TextureManager::AddTexture(const char* a_texturePath, const TextureRegion& a_region, Uint32 a_format)
 {
-	// Query the SDL texture for its height.
-	int textureHeight = 0;
-	SDL_Texture* texture = m_textureMap.at(a_textureId);
-	SDL_QueryTexture(texture, nullptr, nullptr, nullptr, &textureHeight);
-	return textureHeight;
+	const TextureId textureId = static_cast<TextureId>(m_textureMetadata.size());
+	TextureMetadata textureMetadata;
+	textureMetadata.region = a_region;
+	textureMetadata.format = a_format;
+	textureMetadata.isLoaded = true;
+	m_textureMetadata.push_back(textureMetadata);
+	m_textureIds[a_texturePath] = textureId;
+	return textureId;
 }
 
-void TextureManager::Clear()
+void TextureManager::BlitPadded(SDL_Surface* an_image, SDL_Surface* a_page, int a_x, int a_y)
 {
-	// Erase all textures and clear the map.
-	for (const auto& texturePair : m_textureMap)
+	// Copy the pixels as they are, alpha included, rather than blending them onto the page.
+	SDL_SetSurfaceBlendMode(an_image, SDL_BLENDMODE_NONE);
+
+	const int width = an_image->w;
+	const int height = an_image->h;
+
+	// The image, then its edges and corners one pixel out. Blits clip their destination, so pass copies.
+	const SDL_Rect sourceRects[9] = {
+		{ 0, 0, width, height },
+		{ 0, 0, width, 1 }, { 0, height - 1, width, 1 }, { 0, 0, 1, height }, { width - 1, 0, 1, height },
+		{ 0, 0, 1, 1 }, { width - 1, 0, 1, 1 }, { 0, height - 1, 1, 1 }, { width - 1, height - 1, 1, 1 }
+	};
+	const SDL_Point destinationPoints[9] = {
+		{ a_x, a_y },
+		{ a_x, a_y - 1 }, { a_x, a_y + height }, { a_x - 1, a_y }, { a_x + width, a_y },
+		{ a_x - 1, a_y - 1 }, { a_x + width, a_y - 1 }, { a_x - 1, a_y + height }, { a_x + width, a_y + height }
+	};
+
+	for (int rectIndex = 0; rectIndex < 9; ++rectIndex)
 	{
-		SDL_DestroyTexture(texturePair.second);
+		SDL_Rect sourceRect = sourceRects[rectIndex];
+		SDL_Rect destinationRect = { destinationPoints[rectIndex].x, destinationPoints[rectIndex].y, sourceRect.w, sourceRect.h };
+		SDL_BlitSurface(an_image, &sourceRect, a_page, &destinationRect);
 	}
-	m_textureMap.clear();
 }
-
@@ -2,7 +2,24 @@
 #include "PCH.h"
 #include "Macros.h"
 
-using TextureId = size_t;
+// Textures are numbered densely in the order they are loaded, so their ids index straight into the metadata table.
+using TextureId = unsigned int;
+constexpr TextureId INVALID_TEXTURE_ID = std::numeric_limits<TextureId>::max();
+
+// Where a texture lives: the page texture holding it, and the rectangle it covers on that page.
+struct TextureRegion final
+{
+	SDL_Rect rect = { 0, 0, 0, 0 };		// 16 bytes.
+	unsigned int pageIndex = 0;			// 4 bytes.
+};										// Total = 20 bytes.
+
+// Everything there is to know about a loaded texture, filled in once at load so lookups never reach into SDL.
+struct TextureMetadata final
+{
+	TextureRegion region;						// 20 bytes. Its size is the size of the rectangle.
+	Uint32 format = SDL_PIXELFORMAT_UNKNOWN;	// 4 bytes. Pixel format of the page.
+	bool isLoaded = false;						// 1 byte. False once removed, the id is not reused.
+};												// Total = 28 bytes with padding.
 
 class TextureManager final
 {
@@ -15,20 +32,54 @@ public:
 	void Initialize();
 	void Shutdown();
 
+	// Load an image into a page of its own. Returns the id of the texture already loaded from the path, if any.
 	TextureId LoadTexture(const char* a_texturePath);
+
+	// Load images and pack them together into as few atlas pages as possible, so sprites drawn from any of them can go
+	// out in a single batch. Images already loaded are skipped.
+	void LoadTextureAtlas(const std::vector<const char*>& a_texturePaths);
+
+	// The id of the texture loaded from the path, or the invalid id if there is none. Looks the path up, so keep the id
+	// rather than calling this every frame.
 	TextureId GetTextureId(const char* a_texturePath) const;
 
-	bool HaveTexture(TextureId a_textureId) const;
-	SDL_Texture* GetTexture(TextureId a_textureId) const;
+	bool HaveTexture(TextureId a_textureId) const { return a_textureId < m_textureMetadata.size() && m_textureMetadata[a_textureId].isLoaded; }
+
+	// The page holding the texture. Textures may share a page, so sample it through the texture's region: rectangles on
+	// the texture must be offset by the position of the region.
+	SDL_Texture* GetTexture(TextureId a_textureId) const { return m_pageTextures[m_textureMetadata[a_textureId].region.pageIndex]; }
+	const TextureRegion& GetTextureRegion(TextureId a_textureId) const { return m_textureMetadata[a_textureId].region; }
+	const TextureMetadata& GetTextureMetadataRead(TextureId a_textureId) const { return m_textureMetadata[a_textureId]; }
 	void RemoveTexture(TextureId a_textureId);
 
-	int GetTextureWidth(TextureId a_textureId) const;
-	int GetTextureHeight(TextureId a_textureId) const;
+	int GetTextureWidth(TextureId a_textureId) const { return m_textureMetadata[a_textureId].region.rect.w; }
+	int GetTextureHeight(TextureId a_textureId) const { return m_textureMetadata[a_textureId].region.rect.h; }
+	Uint32 GetTextureFormat(TextureId a_textureId) const { return m_textureMetadata[a_textureId].format; }
+
+	// Size of the page holding the texture, for mapping rectangles on the page to texture coordinates.
+	const SDL_Point& GetTexturePageSize(TextureId a_textureId) const { return m_pageSizes[m_textureMetadata[a_textureId].region.pageIndex]; }
+
+	size_t GetPageCount() const { return m_pageTextures.size(); }
 
 	void Clear();
 
 private:
-	std::unordered_map<TextureId, SDL_Texture*> m_textureMap;
-	const std::hash<const char*> m_stringHasher;
-};
+	static constexpr int ATLAS_PAGE_SIZE = 2048;	// Largest atlas page, smaller if the renderer can't take it.
+	static constexpr int ATLAS_PADDING = 1;			// Pixels around each packed image, filled with its edge pixels.
+
+	unsigned int AddPage(SDL_Texture* a_pageTexture, int a_pageWidth, int a_pageHeight, unsigned int a_textureCount);
+
+	// Give the texture loaded from the path the next id.
+	TextureId AddTexture(const char* a_texturePath, const TextureRegion& a_region, Uint32 a_format);
 
+	// Copy the image onto the page, and repeat its edge pixels into the padding around it, so filtering at the edges
+	// of a region never picks up a neighbor.
+	static void BlitPadded(SDL_Surface* an_image, SDL_Surface* a_page, int a_x, int a_y);
+
+private:
+	std::vector<TextureMetadata> m_textureMetadata;		// Indexed by texture id.
+	std::unordered_map<std::string, TextureId> m_textureIds;	// Id of the texture loaded from each path.
+	std::vector<SDL_Texture*> m_pageTextures;			// Null once every texture on the page is removed.
+	std::vector<unsigned int> m_pageTextureCounts;		// Textures still on each page.
+	std::vector<SDL_Point> m_pageSizes;					// Width and height of each page.
+};
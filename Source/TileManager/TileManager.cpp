@@ -4,16 +4,19 @@
 #include "ECS\Registry.h"
 #include "Components\Components.h"
 #include "Engine.h"
+#include "Memory\AllocationCounter.h"
+#include <random>
 
 void TileManager::CreateMap(const char* a_tilemapPath, const char* a_spriteSheetPath, int a_rowCount, int a_columnCount, int a_tileWidth, int a_tileHeight)
 {
+	ALLOCATION_SCOPE(AllocationTag::Assets);
 	Registry& registry = Engine::GetInstanceWrite().GetRegistryWrite();
 	m_mapWidth = static_cast<int>(round(a_columnCount * a_tileWidth * m_tileScale));
 	m_mapHeight = static_cast<int>(round(a_rowCount * a_tileHeight * m_tileScale));
 
 	// Load the sprite sheet for the map.
 	TextureManager& textureManager = TextureManager::GetInstanceWrite();
-	const size_t textureId = textureManager.LoadTexture(a_spriteSheetPath);
+	const TextureId textureId = textureManager.LoadTexture(a_spriteSheetPath);
 
 #pragma warning(disable : 4996) // fopen unsafe warning.
 	// Attempt to open the tile map file.
@@ -37,35 +40,65 @@ void TileManager::CreateMap(const char* a_tilemapPath, const char* a_spriteSheet
 			const int column = buffer[columnIndex + 1] - '0';
 
 			// Create the tile entity.
-			const Entity tile = registry.CreateEntity();
-			{
-				// Add the transform component.
-				registry.AddComponent<TransformComponent>(tile, {
-					static_cast<float>((columnIndex / ENTRIES_PER_COLUMN) * a_tileWidth * m_tileScale),
-					static_cast<float>(rowIndex * a_tileHeight * m_tileScale),
-					0.0f,
-					m_tileScale,
-					m_tileScale
-				},
-				RequestPriority::Deferred);
+			CreateTile(registry, textureId, rowIndex, columnIndex / ENTRIES_PER_COLUMN, row, column, a_tileWidth, a_tileHeight);
+		}
+	}
+}
+
+void TileManager::CreateRandomMap(const char* a_spriteSheetPath, int a_rowCount, int a_columnCount, int a_tileWidth, int a_tileHeight, unsigned int a_seed)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	Registry& registry = Engine::GetInstanceWrite().GetRegistryWrite();
+	m_mapWidth = static_cast<int>(round(a_columnCount * a_tileWidth * m_tileScale));
+	m_mapHeight = static_cast<int>(round(a_rowCount * a_tileHeight * m_tileScale));
 
-				// Add the texture component.
-				registry.AddComponent<TextureComponent>(tile, {
-					textureId,
-					RenderOrder::BaseTileOrder
-				},
-				RequestPriority::Deferred);
+	// Load the sprite sheet for the map, and pick from every tile it holds.
+	TextureManager& textureManager = TextureManager::GetInstanceWrite();
+	const TextureId textureId = textureManager.LoadTexture(a_spriteSheetPath);
+	const int spriteRowCount = std::max(1, textureManager.GetTextureHeight(textureId) / a_tileHeight);
+	const int spriteColumnCount = std::max(1, textureManager.GetTextureWidth(textureId) / a_tileWidth);
 
-				// Add the tile component.
-				registry.AddComponent<TileComponent>(tile, {
-					column * a_tileWidth,
-					row * a_tileHeight,
-					a_tileWidth,
-					a_tileHeight
-				},
-				RequestPriority::Deferred);
-			}
+	std::mt19937 generator(a_seed);
+	std::uniform_int_distribution<int> rowDistribution(0, spriteRowCount - 1);
+	std::uniform_int_distribution<int> columnDistribution(0, spriteColumnCount - 1);
+	for (int rowIndex = 0; rowIndex < a_rowCount; ++rowIndex)
+	{
+		for (int columnIndex = 0; columnIndex < a_columnCount; ++columnIndex)
+		{
+			const int row = rowDistribution(generator);
+			const int column = columnDistribution(generator);
+			CreateTile(registry, textureId, rowIndex, columnIndex, row, column, a_tileWidth, a_tileHeight);
 		}
 	}
 }
 
+void TileManager::CreateTile(Registry& a_registry, TextureId a_textureId, int a_rowIndex, int a_columnIndex, int a_spriteRow, int a_spriteColumn, int a_tileWidth, int a_tileHeight)
+{
+	const Entity tile = a_registry.CreateEntity();
+
+	// Add the transform component.
+	a_registry.AddComponent<TransformComponent>(tile, {
+		static_cast<float>(a_columnIndex * a_tileWidth * m_tileScale),
+		static_cast<float>(a_rowIndex * a_tileHeight * m_tileScale),
+		0.0f,
+		m_tileScale,
+		m_tileScale
+	},
+	RequestPriority::Deferred);
+
+	// Add the texture component.
+	a_registry.AddComponent<TextureComponent>(tile, {
+		a_textureId,
+		RenderOrder::BaseTileOrder
+	},
+	RequestPriority::Deferred);
+
+	// Add the tile component.
+	a_registry.AddComponent<TileComponent>(tile, {
+		a_spriteColumn * a_tileWidth,
+		a_spriteRow * a_tileHeight,
+		a_tileWidth,
+		a_tileHeight
+	},
+	RequestPriority::Deferred);
+}
@@ -1,5 +1,7 @@
 #pragma once
+#include "ECS\Registry.h"
 #include "Macros.h"
+#include "TextureManager\TextureManager.h"
 
 class TileManager final
 {
@@ -9,10 +11,19 @@ public:
 
 	void CreateMap(const char* a_tilemapPath, const char* a_spriteSheetPath, int a_rowCount, int a_columnCount, int a_tileWidth, int a_tileHeight);
 
+	// Create a map of tiles picked at random from the sprite sheet, for maps larger than any map file.
+	void CreateRandomMap(const char* a_spriteSheetPath, int a_rowCount, int a_columnCount, int a_tileWidth, int a_tileHeight, unsigned int a_seed);
+
+	// Size the world of a scene without a tile map.
+	void SetMapSize(int a_mapWidth, int a_mapHeight) { m_mapWidth = a_mapWidth; m_mapHeight = a_mapHeight; }
+
 	float GetTileScale() const { return m_tileScale; }
 	int GetMapWidth() const { return m_mapWidth; }
 	int GetMapHeight() const { return m_mapHeight; }
 
+private:
+	void CreateTile(Registry& a_registry, TextureId a_textureId, int a_rowIndex, int a_columnIndex, int a_spriteRow, int a_spriteColumn, int a_tileWidth, int a_tileHeight);
+
 private:
 	float m_tileScale = 2.0f;
 	int m_mapWidth = 0;
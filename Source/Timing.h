@@ -0,0 +1,15 @@
+#pragma once
+#include "PCH.h"
+
+// Milliseconds spanned by a number of performance counter ticks.
+inline double TicksToMilliseconds(Uint64 a_ticks)
+{
+	static const double millisecondsPerTick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	return static_cast<double>(a_ticks) * millisecondsPerTick;
+}
+
+// Milliseconds elapsed since a performance counter value.
+inline double MillisecondsSince(Uint64 a_startTicks)
+{
+	return TicksToMilliseconds(SDL_GetPerformanceCounter() - a_startTicks);
+}